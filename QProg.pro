@@ -32,8 +32,44 @@ SOURCES	+= src/delegate.cc
 
 HEADERS	+= src/kitsrus.h
 SOURCES	+= src/kitsrus.cc
+HEADERS	+= src/transport.h
+SOURCES	+= src/transport.cc
+HEADERS	+= src/ring.h
+HEADERS	+= src/iothread.h
+SOURCES	+= src/iothread.cc
+HEADERS	+= src/portprobe.h
+SOURCES	+= src/portprobe.cc
+HEADERS	+= src/portwatcher.h
+SOURCES	+= src/portwatcher.cc
+HEADERS	+= src/serializer.h
+SOURCES	+= src/serializer.cc
+HEADERS	+= src/chipdetect.h
+SOURCES	+= src/chipdetect.cc
+HEADERS	+= src/session.h
+SOURCES	+= src/session.cc
+HEADERS	+= src/gang.h
+SOURCES	+= src/gang.cc
+HEADERS	+= src/production.h src/productionwindow.h
+SOURCES	+= src/production.cc src/productionwindow.cc
+HEADERS	+= src/jobqueue.h src/jobserver.h src/scheduler.h
+SOURCES	+= src/jobqueue.cc src/jobserver.cc src/scheduler.cc
 HEADERS	+= src/chipinfo.h
 SOURCES	+= src/chipinfo.cc
+HEADERS	+= src/coretraits.h
+HEADERS	+= src/devicedatabase.h
+SOURCES	+= src/devicedatabase.cc
+HEADERS	+= src/devicelistmodel.h
+SOURCES	+= src/devicelistmodel.cc
+HEADERS	+= src/chipimage.h
+SOURCES	+= src/chipimage.cc
+HEADERS	+= src/filewatcher.h
+SOURCES	+= src/filewatcher.cc
+HEADERS	+= src/hexwriter.h
+SOURCES	+= src/hexwriter.cc
+HEADERS	+= src/binimage.h
+SOURCES	+= src/binimage.cc
+HEADERS	+= src/imagediff.h
+SOURCES	+= src/imagediff.cc
 
 # libintelhex
 DEPENDPATH += lib/intelhex/include lib/intelhex/src
@@ -0,0 +1,25 @@
+/*  Shared bits of the benchmark program
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	BENCH_H
+#define	BENCH_H
+
+namespace bench
+{
+    // Number of times operator new has been called since the program started
+    unsigned long   allocations();
+
+    // Print one line of results for a benchmark that ran some number of times
+    void    report(const char *name, unsigned long iterations, int msecs, unsigned long allocs);
+
+    // The benchmarks. Each one takes the arguments that follow its name.
+    int	readback(int argc, char *argv[]);
+    int	keys(int argc, char *argv[]);
+    int	import(int argc, char *argv[]);
+}
+
+#endif	// BENCH_H
@@ -0,0 +1,27 @@
+######################################################################
+# Benchmarks for the parts of QProg that don't need a programmer
+#  qmake && make, then run ./bench with the name of a benchmark
+######################################################################
+
+TEMPLATE = app
+TARGET = bench
+CONFIG	+= console warn_on qt stl
+CONFIG	-= app_bundle
+QT	-= gui
+INCLUDEPATH += ../include ../src
+DEPENDPATH += ../src
+
+HEADERS	+= bench.h
+SOURCES	+= main.cc
+SOURCES	+= readback.cc
+SOURCES	+= keys.cc
+SOURCES	+= import.cc
+
+HEADERS	+= chipinfo.h chipimage.h devicedatabase.h
+SOURCES	+= chipinfo.cc chipimage.cc devicedatabase.cc
+
+# libintelhex
+DEPENDPATH += ../lib/intelhex/include ../lib/intelhex/src
+INCLUDEPATH += ../lib/intelhex/include
+HEADERS += intelhex.h
+SOURCES += intelhex.cc
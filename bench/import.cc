@@ -0,0 +1,143 @@
+/*  Importing a synthetic device info export
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <iostream>
+
+#include <stdlib.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QStringList>
+#include <QTime>
+
+#include "bench.h"
+#include "devicedatabase.h"
+
+// Build an export of parts devices, each with the keys that a real one has
+static QByteArray make_export(unsigned long parts)
+{
+    static const char *const keys[][2] =
+    {
+	{"BandGap",		"N"},
+	{"CALword",		"N"},
+	{"CoreType",		"bit14_B"},
+	{"EraseMode",		"1"},
+	{"FUSEblank",		"3FFF"},
+	{"FastPowerSequence",	"0"},
+	{"FlashChip",		"Y"},
+	{"ICSPonly",		"N"},
+	{"NumConfigWords",	"1"},
+	{"NumEEPROMBytes",	"256"},
+	{"NumROMWords",		"8192"},
+	{"OverProgram",		"0"},
+	{"PowerSequence",	"VccVpp1"},
+	{"ProgramDelay",	"10"},
+	{"ProgramTries",	"1"},
+	{"Type",		"PIC"},
+    };
+
+    QByteArray	data;
+    data.reserve(parts*600);
+    for(unsigned long i=1; i <= parts; ++i)
+    {
+	const QByteArray prefix("DeviceInfo/Devices/" + QByteArray::number((uint)i) + "/");
+	data += prefix + "Name=BENCH" + QByteArray::number((uint)i) + "\n";
+	data += prefix + "ChipID=" + QByteArray::number((uint)(i & 0x3FFF), 16) + "\n";
+	data += prefix + "CreateTimeStamp=2026-10-19 00:00:00\n";
+	for(unsigned k=0; k < sizeof(keys)/sizeof(keys[0]); ++k)
+	    data += prefix + keys[k][0] + "=" + keys[k][1] + "\n";
+    }
+    data += "DeviceInfo/Devices/size=" + QByteArray::number((uint)parts) + "\n";
+    return data;
+}
+
+namespace bench
+{
+    // bench import [parts]
+    //	Times each step of importing an export, and the QSettings::setValue()
+    //	per line import that it replaced. Everything is written to a
+    //	scratch directory that's removed afterwards.
+    int import(int argc, char *argv[])
+    {
+	const unsigned long parts = (argc > 1) ? strtoul(argv[1], NULL, 0) : 5000;
+	if( parts == 0 )
+	{
+	    std::cerr << "Need at least one part\n";
+	    return 1;
+	}
+
+	// Keep the snapshot and the settings away from the real ones
+	const QString scratch(QDir::tempPath() + "/qprog-bench");
+	QDir().mkpath(scratch);
+	QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, scratch);
+	QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, scratch);
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setOrganizationName("QProgBench");
+	QCoreApplication::setApplicationName("QProgBench");
+
+	const QByteArray data(make_export(parts));
+	std::cout << parts << " parts, " << data.size() << " bytes\n";
+
+	QTime timer;
+	unsigned long before = allocations();
+	timer.start();
+	DeviceInfoParser    parser;
+	if( !parser.feed(data.constData(), data.size()) || !parser.finish() )
+	{
+	    std::cerr << "Parse failed: " << qPrintable(parser.error()) << "\n";
+	    return 1;
+	}
+	report("parse", 1, timer.elapsed(), allocations() - before);
+
+	DeviceDatabase	database;
+	DeviceDatabase::counts_type counts;
+	QString	error;
+	before = allocations();
+	timer.start();
+	if( !database.apply(parser, counts, &error) )
+	{
+	    std::cerr << "Apply failed: " << qPrintable(error) << "\n";
+	    return 1;
+	}
+	report("apply and write the snapshot", 1, timer.elapsed(), allocations() - before);
+
+	before = allocations();
+	timer.start();
+	DeviceDatabase	loaded;
+	if( !loaded.load() || (loaded.size() != parts) )
+	{
+	    std::cerr << "Loading the snapshot failed\n";
+	    return 1;
+	}
+	report("load the snapshot", 1, timer.elapsed(), allocations() - before);
+
+	// The old import: one setValue() per line
+	const QString ini(scratch + "/settings.ini");
+	before = allocations();
+	timer.start();
+	{
+	    QSettings	settings(ini, QSettings::IniFormat);
+	    const QStringList lines(QString(data).split('\n'));
+	    for(QStringList::const_iterator i = lines.begin(); i != lines.end(); ++i)
+	    {
+		const QStringList pair(i->split('='));
+		if( pair.size() == 2 )
+		    settings.setValue(pair[0], pair[1]);
+	    }
+	    settings.sync();
+	}
+	report("QSettings::setValue per line", 1, timer.elapsed(), allocations() - before);
+
+	QFile::remove(ini);
+	QFile::remove(DeviceDatabase::snapshotPath());
+	QDir().rmdir(scratch + "/QProgBench");
+	QDir().rmdir(scratch);
+	return 0;
+    }
+}
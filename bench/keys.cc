@@ -0,0 +1,87 @@
+/*  Speed of chipinfo::set(), which every device info import runs for each key
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <iostream>
+#include <string>
+
+#include <stdlib.h>
+
+#include <QTime>
+
+#include "bench.h"
+#include "chipinfo.h"
+
+// The keys of one device, the way an export lists them
+static const char *const pairs[][2] =
+{
+    {"BandGap",		    "N"},
+    {"CALword",		    "N"},
+    {"CHIPname",	    "18F4550"},
+    {"ChipID",		    "1200"},
+    {"CoreType",	    "bit16_B"},
+    {"CreateTimeStamp",	    "2007-07-20 12:00:00"},
+    {"EraseMode",	    "4"},
+    {"FUSEblank",	    "0700 1F1F 8700 0085 C00F E00F 400F"},
+    {"FastPowerSequence",   "0"},
+    {"FlashChip",	    "Y"},
+    {"ICSPonly",	    "N"},
+    {"NumConfigWords",	    "7"},
+    {"NumEEPROMBytes",	    "256"},
+    {"NumROMWords",	    "16384"},
+    {"OverProgram",	    "0"},
+    {"PowerSequence",	    "VccVpp1"},
+    {"ProgramDelay",	    "10"},
+    {"ProgramTries",	    "1"},
+    {"SocketImage",	    "40pin"},
+    {"Type",		    "PIC"},
+};
+static const unsigned num_pairs = sizeof(pairs)/sizeof(pairs[0]);
+
+namespace bench
+{
+    // bench keys [devices]
+    int keys(int argc, char *argv[])
+    {
+	const unsigned long devices = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+	if( devices == 0 )
+	{
+	    std::cerr << "Need at least one device\n";
+	    return 1;
+	}
+
+	// Imports hand set() keys and values where they sit in a buffer
+	std::string keys[num_pairs], values[num_pairs];
+	for(unsigned i=0; i < num_pairs; ++i)
+	{
+	    keys[i] = pairs[i][0];
+	    values[i] = pairs[i][1];
+	}
+
+	unsigned long failures = 0;
+	QTime timer;
+	const unsigned long before = allocations();
+	timer.start();
+	for(unsigned long d=0; d < devices; ++d)
+	{
+	    chipinfo::chipinfo chip;
+	    for(unsigned i=0; i < num_pairs; ++i)
+		if( !chip.set(keys[i].data(), keys[i].size(), values[i].data(), values[i].size()) )
+		    ++failures;
+	}
+	const int msecs = timer.elapsed();
+	const unsigned long allocs = allocations() - before;
+
+	if( failures )
+	{
+	    std::cerr << failures << " keys weren't recognized\n";
+	    return 1;
+	}
+	report("chipinfo::set (per device)", devices, msecs, allocs);
+	std::cout << "\t" << (1e6*msecs)/(devices*num_pairs) << " ns per key\n";
+	return 0;
+    }
+}
@@ -0,0 +1,82 @@
+/*  Benchmarks for the parts of QProg that don't need a programmer
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <iostream>
+#include <new>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+// Count every allocation so that the benchmarks can report them
+static unsigned long new_count = 0;
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+    ++new_count;
+    void *const p = malloc(size ? size : 1);
+    if( !p )
+	throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+    free(p);
+}
+
+namespace bench
+{
+    unsigned long allocations()
+    {
+	return new_count;
+    }
+
+    void report(const char *name, unsigned long iterations, int msecs, unsigned long allocs)
+    {
+	std::cout << name << ": " << iterations << " iterations, ";
+	std::cout << (1000.0*msecs)/iterations << " us each, ";
+	std::cout << (double)allocs/iterations << " allocations each\n";
+    }
+}
+
+static const struct
+{
+    const char *name;
+    int	(*run)(int, char *[]);
+    const char *usage;
+} benchmarks[] =
+{
+    {"readback", bench::readback, "[cycles]\tRead a chip into a hex_data and into a reused chipimage_t"},
+    {"keys", bench::keys, "[devices]\tSet every key of a device with chipinfo::set()"},
+    {"import", bench::import, "[parts]\tImport a synthetic export, and compare with QSettings"},
+};
+static const unsigned num_benchmarks = sizeof(benchmarks)/sizeof(benchmarks[0]);
+
+int main(int argc, char *argv[])
+{
+    if( argc >= 2 )
+	for(unsigned i=0; i < num_benchmarks; ++i)
+	    if( strcmp(argv[1], benchmarks[i].name) == 0 )
+		return benchmarks[i].run(argc - 1, argv + 1);
+
+    std::cerr << "Usage: " << argv[0] << " <benchmark> [arguments]\n";
+    for(unsigned i=0; i < num_benchmarks; ++i)
+	std::cerr << "\t" << benchmarks[i].name << " " << benchmarks[i].usage << "\n";
+    return 1;
+}
@@ -0,0 +1,97 @@
+/*  Allocations made by a verify's readback
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <iostream>
+
+#include <stdlib.h>
+
+#include <QTime>
+
+#include "bench.h"
+#include "chipimage.h"
+#include "intelhex.h"
+
+// A readback stores every byte of the chip one at a time, by address, in the
+//  order that kitsrus_t reads them. The values don't matter.
+static inline uint8_t sample(chipimage::chipimage_t::address_t address)
+{
+    return (address * 31) & 0xFF;
+}
+
+template<typename T> static void read_chip(const chipimage::chipimage_t &layout, T &sink)
+{
+    for(unsigned r=0; r < chipimage::NUM_REGIONS; ++r)
+	for(chipimage::chipimage_t::address_t a = layout.begin((chipimage::region_t)r); a < layout.end((chipimage::region_t)r); ++a)
+	    sink(a, sample(a));
+}
+
+// What Verify did before: read into a new hex_data, then convert it
+struct hex_sink
+{
+    intelhex::hex_data	data;
+    void operator()(intelhex::hex_data::address_t a, uint8_t v) { data[a] = v;	}
+};
+
+// What Verify does now: read straight into an image that's kept between runs
+struct image_sink
+{
+    chipimage::chipimage_t  &image;
+    image_sink(chipimage::chipimage_t &i) : image(i) {}
+    void operator()(chipimage::chipimage_t::address_t a, uint8_t v) { image.put(a, v);	}
+};
+
+namespace bench
+{
+    // bench readback [cycles]
+    int readback(int argc, char *argv[])
+    {
+	const unsigned long cycles = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100;
+	if( cycles == 0 )
+	{
+	    std::cerr << "Need at least one cycle\n";
+	    return 1;
+	}
+
+	// An 18F4550: 16K words of ROM, 256 bytes of EEPROM and 7 config words
+	chipinfo::chipinfo chip;
+	chip.name = "PIC18F4550";
+	chip.rom_size = 0x4000;
+	chip.eeprom_size = 256;
+	chip.num_config_words = 7;
+	chip.core_type = Core16_B;
+
+	chipimage::chipimage_t layout;
+	layout.clear(chip);
+
+	QTime timer;
+	unsigned long before = allocations();
+	timer.start();
+	for(unsigned long i=0; i < cycles; ++i)
+	{
+	    hex_sink sink;
+	    read_chip(layout, sink);
+	    const chipimage::chipimage_t image(chip, sink.data);
+	}
+	report("hex_data", cycles, timer.elapsed(), allocations() - before);
+
+	chipimage::chipimage_t readback;
+	image_sink sink(readback);
+	before = allocations();
+	timer.start();
+	for(unsigned long i=0; i < cycles; ++i)
+	{
+	    if( readback.matches(chip) )
+		readback.reset();
+	    else
+		readback.clear(chip);
+	    read_chip(layout, sink);
+	}
+	report("chipimage_t", cycles, timer.elapsed(), allocations() - before);
+
+	return 0;
+    }
+}
@@ -9,8 +9,10 @@
 #define	DELEGATE_H
 
 #include <QApplication>		// For QEvent
+#include <QUrl>
 
-class QBuffer;
+class DeviceDatabaseBuilder;
+class DeviceInfoParser;
 class QHttp;
 class QHttpResponseHeader;
 class QProgressDialog;
@@ -24,26 +26,43 @@ protected:
     
 public:
     enum { Startup = QEvent::User, StartupDidFinish, StartupDidFail };
-    Delegate() : buffer(NULL), http(NULL) {}
+    Delegate() : http(NULL), progressDialog(NULL), parser(NULL), builder(NULL), started(false) {}
+
+    // Where device info is downloaded from. The QPROG_DEVICE_INFO_URL
+    //	environment variable overrides the DeviceInfoDownload/URL setting,
+    //	which overrides the default.
+    static QUrl deviceInfoURL();
+
+signals:
+    void deviceInfoUpdated();	    // A download replaced the device database
 
 private slots:
     void getDeviceInfo();
     void httpCancel();
     void httpCleanup();
+    void httpReadyRead(const QHttpResponseHeader &);
     void httpResponseHeader(const QHttpResponseHeader &responseHeader);
     void httpRequestFinished(int requestId, bool error);
     void httpStateChanged(int state);
+    void importFinished();
+    void progressCanceled();
     void updateProgress(int bytesRead, int totalBytes);
 
 private:
-    QBuffer*	buffer;
     QHttp*	http;
     QProgressDialog*	progressDialog;
+    DeviceInfoParser*	parser;	    // Parses the response as it arrives
+    DeviceDatabaseBuilder*  builder;
+    QUrl    url;
+    QString etag;		    // Validators from the response, saved once it's imported
+    QString lastModified;
     bool httpRequestAborted;
+    bool notModified;
+    bool started;		    // The main window is up, so there's no startup waiting
     int httpGetId;
 
     void startup();
-
+    void updateDidFinish(bool success);
 };
 
 extern Delegate delegate;
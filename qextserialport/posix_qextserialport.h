@@ -43,6 +43,8 @@ public:
     virtual void setRts(bool set=true);
     virtual ulong lineStatus();
 
+    int handle() const { return fd; }	// For select() and poll(), while the port is open
+
 protected:
     int	fd;
     struct termios Posix_CommConfig;
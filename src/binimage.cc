@@ -0,0 +1,187 @@
+/*  Native binary chip image files
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <string.h>
+
+#include <QFile>
+
+#include "binimage.h"
+#include "hexwriter.h"
+
+#define	BINIMAGE_MAGIC		"QPROGIMG"
+#define	BINIMAGE_VERSION	1
+
+namespace binimage
+{
+    struct header_t
+    {
+	char	magic[8];
+	uint32_t    version;
+	uint32_t    header_size;
+	uint32_t    payload_size;
+	uint32_t    crc;
+	char	chip_name[32];
+	uint8_t	core_type;
+	uint8_t	reserved[7];
+	chipimage::chipimage_t::layout_t    regions[chipimage::NUM_REGIONS];
+    };
+
+    // The payload has to start on an alignment boundary, and the layout above is the file format
+    typedef char header_size_check[((sizeof(header_t) % CHIPIMAGE_ALIGNMENT) == 0) && (sizeof(header_t) == 128) ? 1 : -1];
+
+    // CRC-32 (IEEE 802.3) lookup table, filled in at startup
+    static struct crc_table_t
+    {
+	uint32_t    table[256];
+	crc_table_t()
+	{
+	    for(uint32_t i=0; i < 256; ++i)
+	    {
+		uint32_t c = i;
+		for(unsigned k=0; k < 8; ++k)
+		    c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+		table[i] = c;
+	    }
+	}
+    } crc_table;
+
+    uint32_t crc32(const uint8_t *p, uint32_t length)
+    {
+	uint32_t c = 0xFFFFFFFF;
+	for(uint32_t i=0; i < length; ++i)
+	    c = crc_table.table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+	return c ^ 0xFFFFFFFF;
+    }
+
+    bool is_binimage(const QString &path)
+    {
+	QFile file(path);
+	char magic[8];
+	if( !file.open(QIODevice::ReadOnly) || (file.read(magic, sizeof(magic)) != sizeof(magic)) )
+	    return false;
+	return memcmp(magic, BINIMAGE_MAGIC, sizeof(magic)) == 0;
+    }
+
+    bool load(const QString &path, chipimage::chipimage_t &image, std::string *chip_name, uint8_t *core_type, bool check_crc)
+    {
+	QFile *file = new QFile(path);
+	if( !file->open(QIODevice::ReadOnly) || (file->size() < (qint64)sizeof(header_t)) )
+	{
+	    delete file;
+	    return false;
+	}
+
+	const qint64 length = file->size();
+	const uint8_t *const p = file->map(0, length);
+	if( !p )
+	{
+	    delete file;
+	    return false;
+	}
+
+	header_t header;
+	memcpy(&header, p, sizeof(header));
+
+	// Sanity check everything before pointing the image at it
+	bool valid = (memcmp(header.magic, BINIMAGE_MAGIC, sizeof(header.magic)) == 0)
+		  && (header.version == BINIMAGE_VERSION)
+		  && (header.header_size >= sizeof(header_t))
+		  && ((header.header_size % CHIPIMAGE_ALIGNMENT) == 0)
+		  && ((qint64)header.header_size + header.payload_size <= length);
+	for(unsigned r=0; valid && (r < chipimage::NUM_REGIONS); ++r)
+	    valid = (header.regions[r].used <= header.regions[r].size)
+		 && ((uint64_t)header.regions[r].offset + header.regions[r].size <= header.payload_size);
+	if( valid && check_crc )
+	    valid = crc32(p + header.header_size, header.payload_size) == header.crc;
+	if( !valid )
+	{
+	    delete file;
+	    return false;
+	}
+
+	if( chip_name )
+	{
+	    chip_name->assign(header.chip_name, sizeof(header.chip_name));
+	    chip_name->resize(strlen(chip_name->c_str()));	// Drop the padding
+	}
+	if( core_type )
+	    *core_type = header.core_type;
+
+	image.adopt(file, p + header.header_size, header.payload_size, header.regions);
+	return true;
+    }
+
+    bool load_file(const QString &path, const chipinfo::chipinfo &chip, chipimage::chipimage_t &image, QString *error)
+    {
+	if( is_binimage(path) )
+	{
+	    std::string name;
+	    if( !load(path, image, &name) )
+	    {
+		if( error )
+		    *error = QString("%1 is not a valid image").arg(path);
+		return false;
+	    }
+	    if( (name != chip.name) || !image.matches(chip) )
+	    {
+		if( error )
+		    *error = QString("%1 was made for a %2").arg(path).arg(QString(name.c_str()));
+		image = chipimage::chipimage_t();
+		return false;
+	    }
+	    return true;
+	}
+
+	intelhex::hex_data HexData(path.toStdString());	//Load the hex file
+	image.load(chip, HexData);
+	return true;
+    }
+
+    bool save(const QString &path, const chipimage::chipimage_t &image, const chipinfo::chipinfo &chip)
+    {
+	if( image.empty() )
+	    return false;
+
+	header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BINIMAGE_MAGIC, sizeof(header.magic));
+	header.version = BINIMAGE_VERSION;
+	header.header_size = sizeof(header_t);
+	header.payload_size = image.storage_size();
+	header.crc = crc32(image.data(), image.storage_size());
+	strncpy(header.chip_name, chip.name.c_str(), sizeof(header.chip_name));
+	header.core_type = chip.core_type;
+	for(unsigned r=0; r < chipimage::NUM_REGIONS; ++r)
+	    header.regions[r] = image.layout((chipimage::region_t)r);
+
+	QFile file(path);
+	if( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+	    return false;
+	return (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == (qint64)sizeof(header))
+	    && (file.write(reinterpret_cast<const char*>(image.data()), image.storage_size()) == (qint64)image.storage_size());
+    }
+
+    bool write_hex(const QString &path, const chipimage::chipimage_t &image, const chipinfo::chipinfo &chip)
+    {
+	hexwriter::hexwriter_t	writer;
+	if( !writer.open(QFile::encodeName(path).constData()) )
+	    return false;
+
+	writer.skip_blank(image.begin(chipimage::ROM), image.end(chipimage::ROM), chip.romBlank(), 2);
+	writer.skip_blank(image.begin(chipimage::EEPROM), image.end(chipimage::EEPROM), chip.eepromBlank(), 1);
+
+	// Regions that were never set in the source don't need to be written at all
+	for(unsigned r=0; r < chipimage::NUM_REGIONS; ++r)
+	{
+	    const chipimage::region_t region = (chipimage::region_t)r;
+	    const uint8_t *const p = image.data(region);
+	    for(chipimage::chipimage_t::size_type i=0; i < image.used(region); ++i)
+		writer.put(image.begin(region) + i, p[i]);
+	}
+	return writer.finish();
+    }
+}
@@ -0,0 +1,58 @@
+/*  Native binary chip image files
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	BINIMAGE_H
+#define	BINIMAGE_H
+
+#include <string>
+
+#include <QString>
+
+#include "chipimage.h"
+#include "chipinfo.h"
+
+// A binary image is a fixed size header followed by the chipimage_t storage
+//  block exactly as it sits in memory, so loading one is a matter of mapping
+//  the file and pointing an image at it.
+//
+//  The header is stored in host byte order, which is little-endian on every
+//  platform that QProg runs on. The CRC covers the payload only.
+//
+//	offset	size	field
+//	0	8	magic "QPROGIMG"
+//	8	4	format version
+//	12	4	header size (offset of the payload)
+//	16	4	payload size
+//	20	4	payload CRC-32
+//	24	32	chip name, NUL padded
+//	56	1	core type
+//	57	7	reserved
+//	64	64	region layouts (begin, size, used, offset) for ROM, EEPROM, ID, CONFIG
+namespace binimage
+{
+    // Preferred file extension, without the leading dot
+    #define	BINIMAGE_EXTENSION	"qbi"
+
+    bool    is_binimage(const QString &path);	// Check a file for the magic number
+
+    // Map a binary image into image. If chip_name or core_type are given
+    //  they're set from the header. The CRC is only checked if check_crc is true.
+    bool    load(const QString &path, chipimage::chipimage_t &image, std::string *chip_name = NULL, uint8_t *core_type = NULL, bool check_crc = true);
+    bool    save(const QString &path, const chipimage::chipimage_t &, const chipinfo::chipinfo &);
+
+    // Load either a binary image or an Intel HEX file for chip. A binary image
+    //  that was made for some other chip is refused. On failure error, if
+    //  given, is set to something suitable for showing to the user.
+    bool    load_file(const QString &path, const chipinfo::chipinfo &chip, chipimage::chipimage_t &image, QString *error = NULL);
+
+    // Write an image out as Intel HEX, leaving out blank records
+    bool    write_hex(const QString &path, const chipimage::chipimage_t &, const chipinfo::chipinfo &);
+
+    uint32_t	crc32(const uint8_t *, uint32_t length);
+}
+
+#endif	// BINIMAGE_H
@@ -7,26 +7,39 @@
 */
 
 #include <iostream>
+#include <sstream>
 
 #include <QFileDialog>
+#include <QApplication>
+#include <QCompleter>
 #include <QGridLayout>
 #include <QLabel>
+#include <QLineEdit>
+#include <QListView>
 #include <QMessageBox>
 #include <QSettings>
 #include <QStringList>
 
 #ifdef	Q_OS_DARWIN
-#include <sstream>
-
 #include <Carbon/Carbon.h>
 #include <IOKit/IOKitLib.h>
 #include <IOKit/serial/IOSerialKeys.h>
 
 #endif	//Q_OS_DARWIN
 
+#include "binimage.h"
 #include "chipinfo.h"
+#include "devicedatabase.h"
+#include "devicelistmodel.h"
+#include "hexwriter.h"
+#include "imagediff.h"
 #include "intelhex.h"
 #include "centralwidget.h"
+#include "portprobe.h"
+#include "portwatcher.h"
+#include "productionwindow.h"
+#include "session.h"
+#include "filewatcher.h"
 
 #include "qextserialport.h"
 
@@ -38,20 +51,46 @@ CentralWidget::CentralWidget() : QWidget()
     ProgrammerDeviceNode = new QComboBox();
     connect(ProgrammerDeviceNode, SIGNAL(activated(const QString&)), this, SLOT(onDeviceComboChange(const QString &)));
 
+    // The target combo shows a model instead of holding an item per device.
+    //	Typing in it searches a second copy of the model through a completer.
+    targetModel = new DeviceListModel(this);
+    searchModel = new DeviceListModel(this);
     TargetType = new QComboBox();
+    TargetType->setModel(targetModel);
+    TargetType->setEditable(true);
+    TargetType->setInsertPolicy(QComboBox::NoInsert);
+    if( QListView *view = qobject_cast<QListView*>(TargetType->view()) )
+	view->setUniformItemSizes(true);
+    QCompleter	*completer = new QCompleter(searchModel, this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);	// The model does the filtering
+    TargetType->setCompleter(completer);
     connect(TargetType, SIGNAL(activated(const QString&)), this, SLOT(onTargetComboChange(const QString &)));
+    connect(TargetType->lineEdit(), SIGNAL(textEdited(const QString&)), searchModel, SLOT(setFilterText(const QString&)));
+    connect(TargetType->lineEdit(), SIGNAL(editingFinished()), this, SLOT(onTargetEditingFinished()));
+    connect(completer, SIGNAL(activated(const QString&)), this, SLOT(selectTarget(const QString&)));
+
+    TargetFamily = new QComboBox();
+    TargetFamily->addItem("All", (unsigned)DeviceListModel::ALL_FAMILIES);
+    TargetFamily->addItem("12-bit", (unsigned)DeviceListModel::FAMILY_12BIT);
+    TargetFamily->addItem("14-bit", (unsigned)DeviceListModel::FAMILY_14BIT);
+    TargetFamily->addItem("16-bit", (unsigned)DeviceListModel::FAMILY_16BIT);
+    connect(TargetFamily, SIGNAL(activated(int)), this, SLOT(onTargetFamilyChange(int)));
 
     EraseCheckBox = new QCheckBox("Erase before programming");
     VerifyCheckBox = new QCheckBox("Verify after programming");
     NewWindowOnReadCheckBox = new QCheckBox("Open new window on read");
     ProgramOnFileChangeCheckBox = new QCheckBox("Reprogram on file change");
-    ProgramOnFileChangeCheckBox->setEnabled(false);
+    AutoDetectCheckBox = new QCheckBox("Detect target before programming");
 
     //Connect the checkbox change signals so the state changes can be saved to settings
     connect(EraseCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onEraseCheckBoxChange(int)));
     connect(VerifyCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onVerifyCheckBoxChange(int)));
     connect(NewWindowOnReadCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onNewWindowOnReadCheckBoxChange(int)));
     connect(ProgramOnFileChangeCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onProgramOnFileChangeCheckBoxChange(int)));
+    connect(AutoDetectCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onAutoDetectCheckBoxChange(int)));
+
+    QPushButton	*DetectButton = new QPushButton("Detect");
+    connect(DetectButton, SIGNAL(clicked()), this, SLOT(detect()));
 
     QPushButton	*ProgramButton = new QPushButton("Program");
     QPushButton	*ReadButton = new QPushButton("Read");
@@ -64,6 +103,13 @@ CentralWidget::CentralWidget() : QWidget()
 
     FileName = new QComboBox();
     FileName->setMaxCount(5);
+    connect(FileName, SIGNAL(activated(int)), this, SLOT(onFileNameChange(int)));
+
+    portWatcher = new PortWatcher(this);
+    connect(portWatcher, SIGNAL(portsChanged()), this, SLOT(onPortsChanged()));
+
+    fileWatcher = new FileWatcher(this);
+    connect(fileWatcher, SIGNAL(fileChanged(const QString &)), this, SLOT(onWatchedFileChanged(const QString &)));
 
     QPushButton	*BrowseButton = new QPushButton("Browse");
     connect(BrowseButton, SIGNAL(clicked()), this, SLOT(browse()));
@@ -72,9 +118,11 @@ CentralWidget::CentralWidget() : QWidget()
     QGridLayout	*Layout0 = new QGridLayout;
     Layout0->addWidget(ProgrammerDeviceNodeLabel, 0, 0);
     Layout0->addWidget(TargetTypeLabel, 1, 0);
+    Layout0->addWidget(TargetFamily, 1, 1);
     Layout0->addWidget(ProgrammerDeviceNode, 0, 2, 1, 2);
 
-    Layout0->addWidget(TargetType, 1, 2, 1, 2);
+    Layout0->addWidget(TargetType, 1, 2);
+    Layout0->addWidget(DetectButton, 1, 3);
 
     Layout0->addWidget(FileNameLabel, 2, 0);
     Layout0->addWidget(FileName, 2, 1, 1, 2);
@@ -87,28 +135,40 @@ CentralWidget::CentralWidget() : QWidget()
     Layout0->addWidget(NewWindowOnReadCheckBox, 4, 0, 1, 2);
 #endif	//Q_OS_DARWIN
     Layout0->addWidget(ProgramOnFileChangeCheckBox, 4, 2, 1, 2);
+    Layout0->addWidget(AutoDetectCheckBox, 5, 0, 1, 2);
 
-    Layout0->addWidget(ProgramButton, 5, 0);
-    Layout0->addWidget(ReadButton, 5, 1);
-    Layout0->addWidget(VerifyButton, 5, 2);
-    Layout0->addWidget(EraseButton, 5, 3);
+    Layout0->addWidget(ProgramButton, 6, 0);
+    Layout0->addWidget(ReadButton, 6, 1);
+    Layout0->addWidget(VerifyButton, 6, 2);
+    Layout0->addWidget(EraseButton, 6, 3);
 
     setLayout(Layout0);
 
     FillPortCombo();		//Fill the programmer dropdown with the available ports
 
-    //Set the device combo to the last used port
+    //Set the device combo to the last used port, following it if it has a new name
     QString last_device = settings.value("CentralWidget/DeviceCombo/Last/Text").toString();
+    QString last_id = settings.value("CentralWidget/DeviceCombo/Last/Id").toString();
     int j=0;
-    if( !last_device.isEmpty() )
+    if( !last_id.isEmpty() && ((j = ProgrammerDeviceNode->findData(last_id, PortIdRole)) != -1) )
+	ProgrammerDeviceNode->setCurrentIndex(j);
+    else if( !last_device.isEmpty() )
 	if( (j = ProgrammerDeviceNode->findText(last_device)) != -1 )
 	    ProgrammerDeviceNode->setCurrentIndex(j);
 
+    //Restore the target family filter
+    if( (j = TargetFamily->findData(settings.value("CentralWidget/TargetFamily/Last/Mask"))) != -1 )
+    {
+	TargetFamily->setCurrentIndex(j);
+	onTargetFamilyChange(j);
+    }
+
     //Restore the checkbox states from settings
     EraseCheckBox->setCheckState((Qt::CheckState)settings.value("CentralWidget/EraseBeforeProgrammingCheckBox/checkState").toInt());
     VerifyCheckBox->setCheckState((Qt::CheckState)settings.value("CentralWidget/VerifyAfterProgrammingCheckBox/checkState").toInt());
     NewWindowOnReadCheckBox->setCheckState((Qt::CheckState)settings.value("CentralWidget/NewWindowOnReadCheckBox/checkState").toInt());
     ProgramOnFileChangeCheckBox->setCheckState((Qt::CheckState)settings.value("CentralWidget/ProgramOnFileChangeCheckBox/checkState").toInt());
+    AutoDetectCheckBox->setCheckState((Qt::CheckState)settings.value("CentralWidget/AutoDetectCheckBox/checkState").toInt());
 
     //Restore the file list from settings
     j = settings.beginReadArray("CentralWidget/FileName/Last");
@@ -121,6 +181,8 @@ CentralWidget::CentralWidget() : QWidget()
 
     progressDialog = new QProgressDialog(this);
     progressDialog->setModal(true);
+
+    updateFileWatch();
 }
 
 void CentralWidget::onEraseCheckBoxChange(int state)
@@ -141,59 +203,113 @@ void CentralWidget::onNewWindowOnReadCheckBoxChange(int state)
 void CentralWidget::onProgramOnFileChangeCheckBoxChange(int state)
 {
     settings.setValue("CentralWidget/ProgramOnFileChangeCheckBox/checkState", state);
+    updateFileWatch();
+}
+
+void CentralWidget::onAutoDetectCheckBoxChange(int state)
+{
+    settings.setValue("CentralWidget/AutoDetectCheckBox/checkState", state);
+}
+
+void CentralWidget::onFileNameChange(int)
+{
+    updateFileWatch();
+}
+
+// Watch the selected file if reprogramming on file change is enabled
+void CentralWidget::updateFileWatch()
+{
+    if( ProgramOnFileChangeCheckBox->isChecked() && (FileName->currentIndex() != -1) )
+	fileWatcher->watch(FileName->itemData(FileName->currentIndex()).toString());
+    else
+	fileWatcher->unwatch();
 }
 
 bool CentralWidget::FillTargetCombo()
 {
-    TargetType->clear();
+    targetModel->reload();
+    searchModel->reload();
 
-    QSettings	settings;
-    if( !settings.childGroups().contains("DeviceInfo") )
+    if( deviceDatabase.empty() )
     {
 	QMessageBox::information(this, tr(""), tr("No Device Info"));
 	return false;
     }
 
-    settings.beginGroup("DeviceInfo");
+    //Set the combo to the last used target
+    restoreTarget();
 
-    if( !settings.childGroups().contains("Devices") )
-    {
-	QMessageBox::information(this, tr(""), tr("No Devices"));
-	return false;
-    }
+    return true;
+}
 
-    size_t numDevices = settings.beginReadArray("Devices");
-    QStringList devices = settings.childGroups();
-    numDevices = devices.count();	// Rude hack to deal with QSettings bug
+// Select the last used target, or the first one if it isn't in the list
+void CentralWidget::restoreTarget()
+{
+    const int row = targetModel->rowOf(settings.value("CentralWidget/TargetCombo/Last/Text").toString());
+    TargetType->setCurrentIndex(((row == -1) && targetModel->rowCount()) ? 0 : row);
+}
 
-    for(size_t i=0; i<numDevices; ++i)
-    {
-	settings.setArrayIndex(i);
-	QVariant n = settings.value("Name");
-	if( n.isValid() && (n.toString().length()!=0) )
-	    TargetType->addItem(n.toString(), (unsigned)i);
-    }
-    settings.endArray();
-    settings.endGroup();
+void CentralWidget::onTargetComboChange(const QString &text)
+{
+    settings.setValue("CentralWidget/TargetCombo/Last/Text", text);
+}
 
-    //Set the combo to the last used target
-    QString last_target = settings.value("CentralWidget/TargetCombo/Last/Text").toString();
-    int j=0;
-    if( !last_target.isEmpty() )
-	if( (j = TargetType->findText(last_target)) != -1 )
-	    TargetType->setCurrentIndex(j);
+void CentralWidget::onTargetFamilyChange(int index)
+{
+    const QVariant mask = TargetFamily->itemData(index);
+    settings.setValue("CentralWidget/TargetFamily/Last/Mask", mask);
+    targetModel->setFamilies(mask.toUInt());
+    searchModel->setFamilies(mask.toUInt());
+    restoreTarget();
+}
 
+// Select the device with the given name. Returns false if it isn't in the list.
+bool CentralWidget::selectTarget(const QString &name)
+{
+    const int row = targetModel->rowOf(name);
+    if( row == -1 )
+	return false;
+    TargetType->setCurrentIndex(row);
+    onTargetComboChange(TargetType->itemText(row));
     return true;
 }
 
-void CentralWidget::onTargetComboChange(const QString &text)
+// Select whatever was typed into the target combo, if it's a device, and put
+//  back the name of the selected device if it isn't
+void CentralWidget::onTargetEditingFinished()
 {
-    settings.setValue("CentralWidget/TargetCombo/Last/Text", text);
+    if( !selectTarget(TargetType->lineEdit()->text()) )
+	TargetType->lineEdit()->setText(TargetType->itemText(TargetType->currentIndex()));
+    searchModel->setFilterText(QString());
 }
 
+// Only the user picking a port from the combo changes which one is remembered
 void CentralWidget::onDeviceComboChange(const QString &text)
 {
     settings.setValue("CentralWidget/DeviceCombo/Last/Text", text);
+    settings.setValue("CentralWidget/DeviceCombo/Last/Id", ProgrammerDeviceNode->itemData(ProgrammerDeviceNode->currentIndex(), PortIdRole));
+}
+
+// A port was plugged in or unplugged. Go back to the port the user last
+//  picked whenever it's there, even under a different name, and otherwise
+//  keep whatever is showing. The pick comes from the settings, not the
+//  combo, which falls back to its first item when the selection goes away.
+void CentralWidget::onPortsChanged()
+{
+    const QString id = settings.value("CentralWidget/DeviceCombo/Last/Id").toString();
+    const QString text = settings.value("CentralWidget/DeviceCombo/Last/Text").toString();
+    const QString path = currentPath();
+
+    ProgrammerDeviceNode->clear();
+    FillPortCombo();
+
+    int j;
+    if( !id.isEmpty() && ((j = ProgrammerDeviceNode->findData(id, PortIdRole)) != -1) )
+	ProgrammerDeviceNode->setCurrentIndex(j);
+    else if( id.isEmpty() && !text.isEmpty() && ((j = ProgrammerDeviceNode->findText(text)) != -1) )
+	ProgrammerDeviceNode->setCurrentIndex(j);
+    else if( (j = ProgrammerDeviceNode->findData(path)) != -1 )
+	ProgrammerDeviceNode->setCurrentIndex(j);
 }
 
 void CentralWidget::browse()
@@ -221,246 +337,244 @@ void CentralWidget::browse()
 	    settings.setValue("Path", FileName->itemData(i));
 	}
 	settings.endArray();
+
+	updateFileWatch();
     }
 }
 
-// Load the chip info from the settings
-bool loadChipInfo(QString &part, chipinfo::chipinfo &chip_info)
+// Load the chip info from the device database
+bool loadChipInfo(const QString &part, chipinfo::chipinfo &chip_info)
 {
-    QSettings	settings;
-    if( !settings.childGroups().contains("DeviceInfo") )
-	return false;
-
-    settings.beginGroup("DeviceInfo");
-
-    if( !settings.childGroups().contains("Devices") )
+    const chipinfo::chipinfo *const info = deviceDatabase.find(part);
+    if( !info )
 	return false;
-
-    size_t numDevices = settings.beginReadArray("Devices");
-    QStringList devices = settings.childGroups();
-    numDevices = devices.count();	// Rude hack to deal with QSettings bug
-
-    for(size_t i=0; i<numDevices; ++i)
-    {
-	settings.setArrayIndex(i);
-	QVariant n = settings.value("Name");
-	if( n.isValid() && (n.toString()==part) )
-	{
-	    QStringList keys = settings.childKeys();
-	    QStringListIterator i(keys);
-	    while(i.hasNext())
-	    {
-		QString	key(i.next());
-		QString	value(settings.value(key).toString());
-		if( value.size() == 0 )	//Skip empty keys
-		    continue;
-		chip_info.set(key.toStdString(), value.toStdString());
-	    }
-	}
-    }
-    settings.endArray();
-    settings.endGroup();
-
+    chip_info = *info;
     return true;
 }
 
 
-bool do_reset(kitsrus::kitsrus_t &programmer)
+// Show a session's progress in a QProgressDialog
+class DialogProgress : public session::progress_t
 {
-    if(!programmer.hard_reset())
+public:
+    DialogProgress(QProgressDialog *d) : dialog(d) {}
+
+    virtual void stage(const char *label)   { dialog->setLabelText(label);	}
+    virtual bool progress(int i, int max_i)
     {
-	//Try assuming that the programmer is a Kit149
-	programmer.set_149();
-	if(!programmer.hard_reset())
-	{
-	    QMessageBox::critical(0, "Error", "Could not reset programmer");
-	    return false;
-	}
+	dialog->setMaximum(max_i);
+	dialog->setValue(i);
+	return !dialog->wasCanceled();
     }
 
-    //Enter command mode
-    if(!programmer.command_mode())
+private:
+    QProgressDialog *dialog;
+};
+
+bool CentralWidget::openSession(session::session_t &s)
+{
+    if( !s.open() )
     {
-	QMessageBox::critical(0, "Error", "Could not enter Command Mode");
+	QMessageBox::critical(this, "Error", s.error());
 	return false;
     }
     return true;
 }
 
-bool do_erase(kitsrus::kitsrus_t &programmer)
+// Identify the chip in the socket and select it as the target. The session
+//  is left set up for the chip that was found. Returns false if it couldn't
+//  be identified.
+bool CentralWidget::doDetect(session::session_t &s)
 {
-//  programmer.chip_power_on();		//Activate programming voltages
-    if( !programmer.erase_chip() )	//Erase the chip first
+    const chipinfo::chipinfo *const device = s.detect();
+    if( !device )
     {
-	QMessageBox::critical(0, "Error", "Could not erase part");
+	QMessageBox::critical(this, "Error", s.error());
 	return false;
     }
-    programmer.chip_power_off();		//Turn the chip off
-    return true;
-}
-
-bool do_rom_write(kitsrus::kitsrus_t &programmer, intelhex::hex_data &HexData)
-{
-    const intelhex::hex_data::size_type num_rom_bytes = HexData.size_below_addr(programmer.get_rom_size());
 
-    if( num_rom_bytes > 0 )
+    // Show every family if the one that's selected hides the chip
+    const QString name(device->name.c_str());
+    if( !selectTarget(name) )
     {
-	programmer.chip_power_on();		//Activate programming voltages
-	if( !programmer.write_rom(HexData) )
-	{
-	    std::cerr << "Error programming ROM\n";
-	    programmer.hard_reset();		//Do a hard reset to clear the error and turn power off
-	    return false;								// and then bail out
-	}
-	programmer.chip_power_off();		//Turn the chip off
+	TargetFamily->setCurrentIndex(0);
+	onTargetFamilyChange(0);
+	selectTarget(name);
     }
-    else
-	std::cout << "No ROM words in file\n";
     return true;
 }
 
-bool do_config_write(kitsrus::kitsrus_t &programmer, intelhex::hex_data &HexData)
+// Check that the chip in the socket is the target that the image was made
+//  for. If it isn't, the chip is selected as the target, but nothing is
+//  written, because the file may well be wrong for it too.
+bool CentralWidget::checkDetectedTarget(session::session_t &s)
 {
-    programmer.chip_power_on();		//Activate programming voltages
-    if( !programmer.write_config(HexData) )
+    const QString expected(s.chip().name.c_str());
+    if( !doDetect(s) )
+	return false;
+    if( s.chip().name != expected.toStdString() )
     {
-	programmer.hard_reset();		//Do a hard reset to clear the error and turn power off
+	QMessageBox::critical(this, "Error", tr("The chip in the socket is a %1, not a %2. It has been selected as the target, check that the file is meant for it and try again.")
+	    .arg(QString(s.chip().name.c_str())).arg(expected));
 	return false;
     }
-    programmer.chip_power_off();		//Turn the chip off
     return true;
 }
 
-bool do_eeprom_write(kitsrus::kitsrus_t &programmer, intelhex::hex_data &HexData)
+void CentralWidget::detect()
 {
-    const intelhex::hex_data::size_type num_eeprom_bytes = HexData.size_in_range(programmer.get_eeprom_start(), programmer.get_eeprom_start() + programmer.get_eeprom_size());
+    chipinfo::chipinfo	chip_info;
+    QString	target(TargetType->itemText(TargetType->currentIndex()));
 
-    if(num_eeprom_bytes > 0)
+    // Start with the selected target, since the chip is most likely to be the same kind
+    if( !loadChipInfo(target, chip_info) )
     {
-	programmer.chip_power_on();		//Activate programming voltages
-	if( !programmer.write_eeprom(HexData) )
-	{
-	    programmer.hard_reset();		//Do a hard reset to clear the error and turn power off
-	    return false;
-	}
-	programmer.chip_power_off();		//Turn the chip off
+	if( deviceDatabase.empty() )
+	    return;
+	chip_info = deviceDatabase[0];
     }
-    else
-	std::cout << "No EEPROM bytes in file\n";
-    return true;
-}
 
-bool do_rom_read(kitsrus::kitsrus_t &programmer, intelhex::hex_data &HexData)
-{
-    programmer.chip_power_on();		//Activate programming voltages
-    if( !programmer.read_rom(HexData) )	//Read ROM
-    {
-	programmer.hard_reset();		//Do a hard reset to clear the error and turn power off
-	return false;
-    }
-    programmer.chip_power_off();	//Turn the chip off
-    return true;
+    DialogProgress	progress(progressDialog);
+    session::session_t	s(currentPath(), chip_info, &progress);
+    if( openSession(s) )
+	doDetect(s);
 }
 
-bool do_config_read(kitsrus::kitsrus_t &programmer, intelhex::hex_data &HexData)
+void CentralWidget::program_all()
 {
-    programmer.chip_power_on();			//Activate programming voltages
-    if( !programmer.read_config(HexData) )	//Read Config
+    chipinfo::chipinfo	chip_info;
+    QString	target(TargetType->itemText(TargetType->currentIndex()));
+
+    //Load the chip info from the settings
+    if( !loadChipInfo(target, chip_info) )
+	return;
+
+    //Grab the currently selected file name
+    if( FileName->currentIndex() == -1 )
     {
-	programmer.hard_reset();		//Do a hard reset to clear the error and turn power off
-	return false;
+	browse();	//Open a file dialog if a file hasn't been selected yet
+	if( FileName->currentIndex() == -1 )
+	{
+	    QMessageBox::critical(this, "Error", "You must select a file to program");
+	    return;
+	}
     }
-    programmer.chip_power_off();		//Turn the chip off
-    return true;
-}
+    QString file_name = (FileName->itemData(FileName->currentIndex())).toString();
 
-bool do_eeprom_read(kitsrus::kitsrus_t &programmer, intelhex::hex_data &HexData)
-{
-    programmer.chip_power_on();		//Activate programming voltages
-    if( !programmer.read_eeprom(HexData) )	//Read EEPROM
+    //Put this in a block to close the serial port early
     {
-	programmer.hard_reset();		//Do a hard reset to clear the error and turn power off
-	return false;
+	chipimage::chipimage_t	image;
+	if( !loadImage(file_name, chip_info, image) )
+	    return;
+
+	DialogProgress	progress(progressDialog);
+	session::session_t	s(currentPath(), chip_info, &progress);
+	if( !openSession(s) )
+	    return;
+	if( AutoDetectCheckBox->isChecked() && !checkDetectedTarget(s) )
+	    return;
+
+	lastImage = chipimage::chipimage_t();	// Whatever was on the chip is about to be gone
+	if( !s.write(image, NULL, EraseCheckBox->isChecked()) )
+	{
+	    progressDialog->reset();
+	    QMessageBox::critical(this, "Error", tr("Error writing to chip: %1").arg(s.error()));
+	    return;
+	}
+	lastImage = image;
+	lastImageTarget = target;
+	lastImagePort = s.port();
     }
-    programmer.chip_power_off();		//Turn the chip off
-    return true;
+    if( VerifyCheckBox->isChecked() )
+	onVerify();
 }
 
-bool handle_progress(void* p, int i, int max_i)
+// Start programming chips as they're put in the socket, using the selected
+//  file, target and erase/verify options
+void CentralWidget::production()
 {
-    return static_cast<CentralWidget*>(p)->handleProgress(i, max_i);
-}
+    chipinfo::chipinfo	chip_info;
+    QString	target(TargetType->itemText(TargetType->currentIndex()));
 
-// Handle the actual write sequence
-bool do_write_all(kitsrus::kitsrus_t& prog, intelhex::hex_data &HexData, bool erase_first, QProgressDialog *progressDialog)
-{
-    // If erase before programming...
-    if( erase_first )
-	do_erase(prog);
+    //Load the chip info from the settings
+    if( !loadChipInfo(target, chip_info) )
+	return;
 
-    // Do the programming sequence
-    //  For some reason config has to be written first or the programmer locks up
-    progressDialog->setLabelText("Writing Config");	//Set the progress dialog label
-    if( !do_config_write(prog, HexData) )
-	return false;
+    if( FileName->currentIndex() == -1 )
+    {
+	browse();	//Open a file dialog if a file hasn't been selected yet
+	if( FileName->currentIndex() == -1 )
+	{
+	    QMessageBox::critical(this, "Error", "You must select a file to program");
+	    return;
+	}
+    }
 
-    progressDialog->setLabelText("Writing EEPROM");	//Set the progress dialog label
-    if( !do_eeprom_write(prog, HexData) )
-	return false;
+    chipimage::chipimage_t	image;
+    if( !loadImage(FileName->itemData(FileName->currentIndex()).toString(), chip_info, image) )
+	return;
 
-    progressDialog->setLabelText("Writing ROM");	//Set the progress dialog label
-    if( !do_rom_write(prog, HexData) )			//Write the ROM words
-	return false;
+    // Fields that get a different value on each chip
+    serializer::serializer_t	serializer;
+    const QStringList fields = settings.value("Production/Serial/Fields").toStringList();
+    QString error;
+    for(QStringList::const_iterator i = fields.begin(); i != fields.end(); ++i)
+	if( !serializer.add(i->toStdString(), &error) )
+	    break;
+    if( error.isEmpty() )
+	serializer.bind(chip_info, image, &error);
+    if( !error.isEmpty() )
+    {
+	QMessageBox::critical(this, "Error", error);
+	return;
+    }
 
-    return true;
+    const unsigned interval = settings.value("Production/PollInterval", 100).toUInt();
+    const quint64 first_unit = settings.value("Production/Serial/NextUnit", 0).toULongLong();
+    lastImage = chipimage::chipimage_t();	// The chip is going to change without us
+    ProductionWindow *window = new ProductionWindow(currentPath(), chip_info, image, serializer, first_unit, EraseCheckBox->isChecked(), VerifyCheckBox->isChecked(), interval, this);
+    window->show();
 }
 
-// Handle the actual write sequence
-bool do_read_all(kitsrus::kitsrus_t& prog, intelhex::hex_data &HexData, QProgressDialog *progressDialog)
+// Reset every port in the programmer combo at once and see which ones answer.
+//  The first one that does is selected, but it isn't remembered (see
+//  onPortsChanged()) unless the user picks it.
+void CentralWidget::findProgrammers()
 {
-    progressDialog->setLabelText("Reading ROM");	//Set the progress dialog label
-    if( !do_rom_read(prog, HexData) )
-	return false;
-
-    progressDialog->setLabelText("Reading Config");	//Set the progress dialog label
-    if( !do_config_read(prog, HexData) )
-	return false;
-
-    progressDialog->setLabelText("Reading EEPROM");	//Set the progress dialog label
-    if( !do_eeprom_read(prog, HexData) )
-	return false;
+    QStringList	ports;
+    for(int i=0; i < ProgrammerDeviceNode->count(); ++i)
+	ports.append(ProgrammerDeviceNode->itemData(i).toString());
 
-    return true;
-}
+    std::vector<portprobe::result_t>	found;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    portprobe::probe(ports, found);
+    QApplication::restoreOverrideCursor();
 
-bool CentralWidget::doProgrammerInit(kitsrus::kitsrus_t& prog)
-{
-    if( !prog.open() )			//Open the port
+    if( found.empty() )
     {
-	QMessageBox::critical(this, "Error", "Could not open serial port");
-	return false;
+	QMessageBox::information(this, "Find Programmers", "No programmers answered");
+	return;
     }
 
-    if( !do_reset(prog) )		//Reset the programmer
-	return false;
-
-    //Check the protocol version
-    std::string protocol = prog.get_protocol();
-
-    if( (protocol != "P018") && (protocol != "P18A") )
+    QString list;
+    for(std::vector<portprobe::result_t>::const_iterator i = found.begin(); i != found.end(); ++i)
     {
-	QMessageBox::critical(this, "Error", tr("Wrong protocol version ( %1 )").arg(QString(protocol.c_str())));
-	return false;
+	const int index = ProgrammerDeviceNode->findData(QVariant(i->port));
+	const QString description = QString("%1, protocol %2").arg(i->firmware_name).arg(i->protocol);
+	if( index != -1 )
+	    ProgrammerDeviceNode->setItemData(index, description, Qt::ToolTipRole);
+	list += QString("%1: %2\n").arg(ProgrammerDeviceNode->itemText(index)).arg(description);
     }
 
-    prog.init_program_vars();			//Initialize programming variables
-
-    prog.set_callback(&handle_progress, this);	//Set the progress callback
-
-    return true;
+    const int first = ProgrammerDeviceNode->findData(QVariant(found.front().port));
+    if( first != -1 )
+	ProgrammerDeviceNode->setCurrentIndex(first);
+    QMessageBox::information(this, "Find Programmers", list);
 }
 
-void CentralWidget::program_all()
+// Reprogram the chip with a file that has changed since it was last written
+//  Only the parts of the new image that differ from the last one are sent
+void CentralWidget::onWatchedFileChanged(const QString &file_name)
 {
     chipinfo::chipinfo	chip_info;
     QString	target(TargetType->itemText(TargetType->currentIndex()));
@@ -469,40 +583,59 @@ void CentralWidget::program_all()
     if( !loadChipInfo(target, chip_info) )
 	return;
 
-    //Grab the currently selected file name
-    if( FileName->currentIndex() == -1 )
+    chipimage::chipimage_t	image;
+    if( !loadImage(file_name, chip_info, image) )
+	return;
+
+    // Without an image to compare against the whole chip has to be written.
+    //	Differential writes are only for the same chip on the same programmer.
+    //	lastImage is cleared while writing, so compare against a copy of it.
+    const chipimage::chipimage_t last(lastImage);
+    const chipimage::chipimage_t *previous = (!last.empty() && (lastImageTarget == target) && (lastImagePort == currentPath())) ? &last : NULL;
+
+    // Nothing to do if the file changed but the image didn't (a comment, for instance)
+    if( previous )
     {
-	browse();	//Open a file dialog if a file hasn't been selected yet
-	if( FileName->currentIndex() == -1 )
-	{
-	    QMessageBox::critical(this, "Error", "You must select a file to program");
+	imagediff::changes_t	changes;
+	imagediff::diff(image, *previous, changes);
+	if( changes.empty() )
 	    return;
-	}
     }
-    QString file_name = (FileName->itemData(FileName->currentIndex())).toString();
 
     //Put this in a block to close the serial port early
     {
-	QString	path(currentPath());
-	kitsrus::kitsrus_t	prog(path, chip_info);	//Programmer interface
-	intelhex::hex_data HexData(file_name.toStdString());	//Load the hex file
-
-	if( !doProgrammerInit(prog) )
+	DialogProgress	progress(progressDialog);
+	session::session_t	s(currentPath(), chip_info, &progress);
+	if( !openSession(s) )
 	    return;
 
-	if( !do_write_all(prog, HexData, EraseCheckBox->isChecked(), progressDialog) )
+	// A differential write depends on what's already on the chip, so never erase first
+	lastImage = chipimage::chipimage_t();	// The chip is in an unknown state until this works
+	bool written = s.write(image, previous, !previous && EraseCheckBox->isChecked());
+
+	// The chip may have been swapped since the last write, so check the
+	//  parts that weren't written. If they're wrong, write all of it.
+	imagediff::changes_t	changes;
+	if( written && previous )
+	{
+	    written = s.verify(image, readback, changes);
+	    if( written && !changes.empty() )
+		written = s.write(image, NULL, true);
+	}
+	if( !written )
 	{
 	    progressDialog->reset();
-	    QMessageBox::critical(this, "Error", tr("Error writing to chip"));
+	    QMessageBox::critical(this, "Error", tr("Error writing to chip: %1").arg(s.error()));
 	    return;
 	}
+	lastImage = image;
+	lastImageTarget = target;
+	lastImagePort = s.port();
     }
-    if( VerifyCheckBox->isChecked() )
-	onVerify();
 }
 
 #ifdef	Q_OS_DARWIN
-void handle_open_new_text(intelhex::hex_data& HexData)
+void handle_open_new_text(const std::string &text)
 {
     OSErr err = noErr;
     FSRef	ref;
@@ -540,15 +673,13 @@ void handle_open_new_text(intelhex::hex_data& HexData)
 	{
 	    AppleEvent openEvent;
 	    AEDesc	docSpec, insertLoc;
-	    std::ostringstream text;
 
 	    // Get the doc spec from the reply event
 	    AEGetParamDesc(&replyEvent, keyDirectObject, typeWildCard, &docSpec);
 	    AEDisposeDesc(&createEvent);	//The create event is no longer needed
 
 	    // Build an Apple Event to send the text to the editor
-	    HexData.write(text);
-	    AEBuildAppleEvent(kAECoreSuite, kAECreateElement, typeProcessSerialNumber, &psn, sizeof(psn), kAutoGenerateReturnID, kAnyTransactionID, &openEvent, NULL, "kocl:type(cpar), data:TEXT(@)", text.str().c_str());
+	    AEBuildAppleEvent(kAECoreSuite, kAECreateElement, typeProcessSerialNumber, &psn, sizeof(psn), kAutoGenerateReturnID, kAnyTransactionID, &openEvent, NULL, "kocl:type(cpar), data:TEXT(@)", text.c_str());
 //	    AEPutAttributeDesc(&openEvent, keySubjectAttr, &docSpec);	//Add the doc spec as an attribute
 	    AEBuildDesc(&insertLoc, NULL, "insl{kobj:@, kpos:end}", &docSpec);	//Make an insert location
 	    AEPutParamDesc(&openEvent, keyAEInsertHere, &insertLoc);	//Insert the insert location
@@ -569,7 +700,6 @@ void handle_open_new_text(intelhex::hex_data& HexData)
 void CentralWidget::read()
 {
     chipinfo::chipinfo	chip_info;
-    intelhex::hex_data	HexData;
 
     QString	target(TargetType->itemText(TargetType->currentIndex()));
 
@@ -577,34 +707,59 @@ void CentralWidget::read()
     if( !loadChipInfo(target, chip_info) )
 	return;
 
+    // The records are written as the bytes arrive, so the destination has to
+    //	be known before reading starts
+    QString out_file;
+    std::string text;
+#ifdef	Q_OS_DARWIN
+    const bool new_window = NewWindowOnReadCheckBox->isChecked();
+#else
+    const bool new_window = false;
+#endif	//Q_OS_DARWIN
+    hexwriter::hexwriter_t  writer(new_window ? &text : NULL);
+    if( !new_window )
+    {
+	out_file = QFileDialog::getSaveFileName(this);
+	if( out_file.isEmpty() )
+	    return;
+	if( !writer.open(QFile::encodeName(out_file).constData()) )
+	{
+	    QMessageBox::critical(this, "Error", tr("Could not open %1").arg(out_file));
+	    return;
+	}
+    }
+
+    // Don't bother writing records that are entirely blank
+    writer.skip_blank(2*chip_info.romBegin(), 2*chip_info.romEnd(), chip_info.romBlank(), 2);
+    writer.skip_blank(chip_info.eepromBegin(), chip_info.eepromEnd(), chip_info.eepromBlank(), 1);
+
     QString	path(ProgrammerDeviceNode->itemData(ProgrammerDeviceNode->currentIndex()).toString());
 
     //Put this in a block to close the serial port early
     {
-	kitsrus::kitsrus_t	prog(path, chip_info);	//Programmer interface
+	DialogProgress	progress(progressDialog);
+	session::session_t	s(path, chip_info, &progress);
 
-	if( !doProgrammerInit(prog) )
-	    return;
-
-	if( !do_read_all(prog, HexData, progressDialog) )
+	if( !s.open() || !s.read(writer) )
 	{
 	    progressDialog->reset();
-	    QMessageBox::critical(this, "Error", tr("Error reading chip"));
+	    writer.finish();
+	    if( !out_file.isEmpty() )
+		QFile::remove(out_file);	// Don't leave a partial file lying around
+	    QMessageBox::critical(this, "Error", tr("Error reading chip: %1").arg(s.error()));
+	    return;
 	}
     }
 
-
-#ifdef	Q_OS_DARWIN
-    if( NewWindowOnReadCheckBox->isChecked() )
-	handle_open_new_text(HexData);
-    else
+    if( !writer.finish() )
     {
-#endif	//Q_OS_DARWIN
-	QString out_file(QFileDialog::getSaveFileName(this));
-	if( !out_file.isEmpty() )
-	    HexData.write(out_file.toStdString().c_str());
-#ifdef	Q_OS_DARWIN
+	QMessageBox::critical(this, "Error", tr("Could not write %1").arg(out_file));
+	return;
     }
+
+#ifdef	Q_OS_DARWIN
+    if( new_window )
+	handle_open_new_text(text);
 #endif	//Q_OS_DARWIN
 }
 
@@ -631,40 +786,103 @@ void CentralWidget::onVerify()
 
     //Put this in a block to close the serial port early
     {
-	QString	path(currentPath());
-	kitsrus::kitsrus_t	prog(path, chip_info);	//Programmer interface
-	intelhex::hex_data HexData(file_name.toStdString());	//Load the hex file
+	chipimage::chipimage_t	image;
+	if( !loadImage(file_name, chip_info, image) )
+	    return;
 
-	if( !doProgrammerInit(prog) )
+	DialogProgress	progress(progressDialog);
+	session::session_t	s(currentPath(), chip_info, &progress);
+	if( !openSession(s) )
+	    return;
+	if( AutoDetectCheckBox->isChecked() && !checkDetectedTarget(s) )
 	    return;
 
-	intelhex::hex_data VerifyData;
-	if( !do_read_all(prog, VerifyData, progressDialog) )
+	// The readback image is kept between verifies
+	imagediff::changes_t	changes;
+	if( !s.verify(image, readback, changes) )
 	{
 	    progressDialog->reset();
-	    QMessageBox::critical(this, "Error", tr("Error reading chip"));
+	    QMessageBox::critical(this, "Error", tr("Error reading chip: %1").arg(s.error()));
+	    return;
 	}
 
-	// Compare ROM
-	const bool flash = intelhex::compare(HexData, VerifyData, chip_info.romBlank(), chip_info.romBegin(), chip_info.romEnd());
-	// Compare EEPROM
-	const bool eeprom = intelhex::compare(HexData, VerifyData, chip_info.eepromBlank(), chip_info.eepromBegin(), chip_info.eepromEnd());
-	// Compare Config
-//	const bool config = intelhex::compare(HexData, VerifyData, chip_info.configBlank(), chip_info.configBegin(), chip_info.configEnd());
+	// The chip isn't what was last written to it, so don't write it differentially
+	if( !changes.empty() )
+	    lastImage = chipimage::chipimage_t();
 
-	QMessageBox::information(this, "Verify Results",
-				 tr("Flash\t%1\nEEPROM\t%2\nConfig\t%3")
+	const bool flash = !imagediff::extent(changes, chipimage::ROM);
+	const bool eeprom = !imagediff::extent(changes, chipimage::EEPROM);
+	const bool config = !imagediff::extent(changes, chipimage::CONFIG);
+
+	QMessageBox	results(QMessageBox::Information, "Verify Results",
+				tr("Flash\t%1\nEEPROM\t%2\nConfig\t%3")
 				    .arg(flash?"Pass":"Fail")
 				    .arg(eeprom?"Pass":"Fail")
-				    .arg("Not Verified")
-				 );
+				    .arg(config?"Pass":"Fail"),
+				QMessageBox::Ok, this);
+	// List the blocks that didn't match, with the file's bytes first
+	if( !changes.empty() )
+	{
+	    std::ostringstream	details;
+	    imagediff::print(details, image, readback, changes);
+	    results.setDetailedText(QString(details.str().c_str()));
 	}
+	results.exec();
+	}
+}
+
+// Load an Intel HEX or binary image file for the given chip
+bool CentralWidget::loadImage(const QString &file_name, const chipinfo::chipinfo &chip_info, chipimage::chipimage_t &image)
+{
+    QString error;
+    if( !binimage::load_file(file_name, chip_info, image, &error) )
+    {
+	QMessageBox::critical(this, "Error", error);
+	return false;
+    }
+    return true;
+}
+
+// Convert the selected Intel HEX file to a binary image for the selected target
+void CentralWidget::exportBinaryImage()
+{
+    chipinfo::chipinfo	chip_info;
+    QString	target(TargetType->itemText(TargetType->currentIndex()));
+
+    if( !loadChipInfo(target, chip_info) || (FileName->currentIndex() == -1) )
+	return;
+
+    chipimage::chipimage_t  image;
+    if( !loadImage(FileName->itemData(FileName->currentIndex()).toString(), chip_info, image) )
+	return;
+
+    QString out_file(QFileDialog::getSaveFileName(this, tr("Export Binary Image"), QString(), tr("Binary Images (*.%1)").arg(BINIMAGE_EXTENSION)));
+    if( !out_file.isEmpty() && !binimage::save(out_file, image, chip_info) )
+	QMessageBox::critical(this, "Error", tr("Could not write %1").arg(out_file));
+}
+
+// Convert the selected file back to Intel HEX
+void CentralWidget::exportHex()
+{
+    chipinfo::chipinfo	chip_info;
+    QString	target(TargetType->itemText(TargetType->currentIndex()));
+
+    if( !loadChipInfo(target, chip_info) || (FileName->currentIndex() == -1) )
+	return;
+
+    chipimage::chipimage_t  image;
+    if( !loadImage(FileName->itemData(FileName->currentIndex()).toString(), chip_info, image) )
+	return;
+
+    QString out_file(QFileDialog::getSaveFileName(this, tr("Export Intel HEX"), QString(), tr("Intel HEX (*.hex)")));
+    if( !out_file.isEmpty() && !binimage::write_hex(out_file, image, chip_info) )
+	QMessageBox::critical(this, "Error", tr("Could not write %1").arg(out_file));
 }
 
 void CentralWidget::bulk_erase()
 {
     chipinfo::chipinfo	chip_info;
-    QString	target(TargetType->itemData(TargetType->currentIndex()).toString());
+    QString	target(TargetType->itemText(TargetType->currentIndex()));
 
     //Load the chip info from the settings
     if( !loadChipInfo(target, chip_info) )
@@ -674,12 +892,16 @@ void CentralWidget::bulk_erase()
 
     //Put this in a block to close the serial port early
     {
-	kitsrus::kitsrus_t	prog(path, chip_info);	//Programmer interface
-
-	if( !doProgrammerInit(prog) )
+	session::session_t	s(path, chip_info);
+	if( !openSession(s) )
 	    return;
 
-	do_erase(prog);		//Do the erase
+	lastImage = chipimage::chipimage_t();
+	if( !s.erase() )
+	{
+	    QMessageBox::critical(this, "Error", s.error());
+	    return;
+	}
     }
 
     QMessageBox::information(this, "Bulk Erase", "Successfully Erased");
@@ -777,19 +999,25 @@ bool CentralWidget::FillPortCombo()
 //	Returns true if a port is found, false otherwise
 bool CentralWidget::FillPortCombo()
 {
+#ifdef	Q_OS_LINUX
+    // sysfs knows which ports are real, and what's plugged into them
+    const QList<PortInfo> &ports = portWatcher->ports();
+    for(QList<PortInfo>::const_iterator i = ports.begin(); i != ports.end(); ++i)
+    {
+	ProgrammerDeviceNode->addItem(i->name, QVariant(i->path));
+	const int index = ProgrammerDeviceNode->count() - 1;
+	ProgrammerDeviceNode->setItemData(index, i->id, PortIdRole);
+	ProgrammerDeviceNode->setItemData(index, i->description(), Qt::ToolTipRole);
+    }
+    return !ports.isEmpty();
+#else
     QDir dir("/dev");
     if( !dir.exists() )
 	return false;
 
     dir.setFilter(QDir::System | QDir::CaseSensitive);
     QStringList 	names;
-
-#ifdef	Q_OS_LINUX
-    names << "ttyS*" << "ttyU*";
-#else
     names << "cu*";
-#endif	//Q_OS_LINUX
-
     dir.setNameFilters(names);
 
     QStringList devs = dir.entryList();
@@ -802,6 +1030,7 @@ bool CentralWidget::FillPortCombo()
     }
 
     return true;
+#endif	//Q_OS_LINUX
 }
 
 #endif	//Q_WS_X11
@@ -19,8 +19,14 @@
 #include <QProgressDialog>
 #include <QSettings>
 
+#include	"chipimage.h"
 #include	"kitsrus.h"
 
+class DeviceListModel;
+class FileWatcher;
+class PortWatcher;
+namespace session { class session_t; }
+
 class CentralWidget : public QWidget
 {
     Q_OBJECT
@@ -28,22 +34,26 @@ public:
     CentralWidget();
     bool FillTargetCombo();
 
-    //Handle a progress update from the programmer
-    //	Returns false if the cancel button was clicked, otherwise true
-    bool handleProgress(int i, int max_i)
-    {
-	progressDialog->setMaximum(max_i);
-	progressDialog->setValue(i);
-	return !progressDialog->wasCanceled();
-    }
+public slots:
+    void exportBinaryImage();
+    void exportHex();
+    void production();
+    void findProgrammers();
 
 private slots:
     void onEraseCheckBoxChange(int);
     void onVerifyCheckBoxChange(int);
     void onNewWindowOnReadCheckBoxChange(int);
     void onProgramOnFileChangeCheckBoxChange(int);
+    void onAutoDetectCheckBoxChange(int);
     void onTargetComboChange(const QString &);
+    void onTargetFamilyChange(int);
+    void onTargetEditingFinished();
+    bool selectTarget(const QString &);
     void onDeviceComboChange(const QString &);
+    void onPortsChanged();
+    void onFileNameChange(int);
+    void onWatchedFileChanged(const QString &);
     void browse();
 #ifdef	Q_OS_LINUX
     void device_browse();
@@ -53,28 +63,53 @@ private slots:
     void read();
     void bulk_erase();
     void onVerify();
+    void detect();
 
 private:
+    // The port combo's items hold the port's path as their data, and its
+    //	PortInfo::id in this role
+    enum { PortIdRole = Qt::UserRole + 1 };
+
     QComboBox	*FileName;
     QComboBox	*ProgrammerDeviceNode;
     QComboBox	*TargetType;
+    QComboBox	*TargetFamily;
+    DeviceListModel *targetModel;	// What the target combo shows
+    DeviceListModel *searchModel;	// Filtered by what's typed into the target combo
 
     QCheckBox	*EraseCheckBox;
     QCheckBox	*VerifyCheckBox;
     QCheckBox	*NewWindowOnReadCheckBox;
     QCheckBox	*ProgramOnFileChangeCheckBox;
+    QCheckBox	*AutoDetectCheckBox;
     QProgressDialog *progressDialog;
 
     QSettings	settings;
 
+    void    restoreTarget();
+
+    FileWatcher	*fileWatcher;
+    PortWatcher	*portWatcher;
+    chipimage::chipimage_t  lastImage;	    // The image most recently written to the chip
+    QString	lastImageTarget;	    // The target that lastImage was written to
+    QString	lastImagePort;		    // The programmer it was written with
+    chipimage::chipimage_t  readback;	    // Reused by every verify
+
     bool FillPortCombo();
+    void updateFileWatch();
 
     QString currentPath()
     {
 	return ProgrammerDeviceNode->itemData(ProgrammerDeviceNode->currentIndex()).toString();
     }
 
-    bool doProgrammerInit(kitsrus::kitsrus_t&);
+    bool openSession(session::session_t &);	// Shows what went wrong if it fails
+    bool doDetect(session::session_t &);
+    bool checkDetectedTarget(session::session_t &);
+    bool loadImage(const QString &, const chipinfo::chipinfo &, chipimage::chipimage_t &);
 };
 
+// Load the chip info for part from the device database
+bool loadChipInfo(const QString &part, chipinfo::chipinfo &chip_info);
+
 #endif	//CENTRALWIDGET_H
@@ -0,0 +1,88 @@
+/*  Identify the chip in the programmer's socket by its device ID
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include "chipdetect.h"
+#include "coretraits.h"
+#include "devicedatabase.h"
+
+#define	NUM_FAMILIES	(coretraits::CORE_UNKNOWN + 1)
+
+namespace chipdetect
+{
+    // Returns false for IDs that don't belong to any part: a 14 or 16-bit
+    //	blank, or nothing at all. ChipID is FFFF for parts that don't have one.
+    static bool valid(uint16_t id)
+    {
+	id &= ~CHIP_ID_REVISION_MASK;
+	return id && (id != (BLANK_14BIT & ~CHIP_ID_REVISION_MASK)) && (id != (BLANK_16BIT & ~CHIP_ID_REVISION_MASK));
+    }
+
+    // Read the ID with prog set up for chip, and find the device in chip's
+    //	family that has it. The readback from a chip of another family is
+    //	garbage, so only a match in the same family counts.
+    static const chipinfo::chipinfo* probe(kitsrus::kitsrus_t &prog, const chipinfo::chipinfo &chip)
+    {
+	uint16_t id;
+	prog.chip_power_on();
+	const bool ok = prog.read_chip_id(id);
+	prog.chip_power_off();
+	if( !ok || !valid(id) )
+	    return NULL;
+
+	const coretraits::family_t family = coretraits::family(chip.core_type);
+	const QList<const chipinfo::chipinfo*> matches = deviceDatabase.findChipID(id & ~CHIP_ID_REVISION_MASK);
+	const chipinfo::chipinfo *result = NULL;
+	for(QList<const chipinfo::chipinfo*>::const_iterator i = matches.begin(); i != matches.end(); ++i)
+	    if( coretraits::family((*i)->core_type) == family )
+	    {
+		if( (*i)->name == chip.name )
+		    return *i;
+		if( !result )
+		    result = *i;
+	    }
+	return result;
+    }
+
+    // Set prog up for the device that was found, unless it already is
+    static const chipinfo::chipinfo* found(kitsrus::kitsrus_t &prog, const chipinfo::chipinfo &probed, const chipinfo::chipinfo *device)
+    {
+	if( device->name != probed.name )
+	{
+	    prog.set_chip(*device);
+	    prog.init_program_vars();
+	}
+	return device;
+    }
+
+    const chipinfo::chipinfo* detect(kitsrus::kitsrus_t &prog, const chipinfo::chipinfo &current)
+    {
+	const chipinfo::chipinfo *device = probe(prog, current);
+	if( device )
+	    return found(prog, current, device);
+
+	// Try again with the settings for each of the other families
+	bool tried[NUM_FAMILIES] = {false};
+	tried[coretraits::family(current.core_type)] = true;
+	tried[coretraits::CORE_UNKNOWN] = true;	// Nothing can be read with those settings
+	for(DeviceDatabase::size_type i=0; i < deviceDatabase.size(); ++i)
+	{
+	    const chipinfo::chipinfo &chip = deviceDatabase[i];
+	    const coretraits::family_t family = coretraits::family(chip.core_type);
+	    if( tried[family] || !valid(chip.chip_id) )
+		continue;
+	    tried[family] = true;
+
+	    prog.set_chip(chip);
+	    if( prog.init_program_vars() && (device = probe(prog, chip)) )
+		return found(prog, chip, device);
+	}
+
+	prog.set_chip(current);
+	prog.init_program_vars();
+	return NULL;
+    }
+}
@@ -0,0 +1,27 @@
+/*  Identify the chip in the programmer's socket by its device ID
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	CHIPDETECT_H
+#define	CHIPDETECT_H
+
+#include "chipinfo.h"
+#include "kitsrus.h"
+
+namespace chipdetect
+{
+    // Read the device ID of the chip in the socket and look it up in
+    //	deviceDatabase. prog must be reset and set up for current. The ID is
+    //	read with current's settings first, and then with those of one device
+    //	from each of the other core families, until a device in the same
+    //	family as the settings has that ID. current wins if it's one of them.
+    //
+    //	Returns the device, with prog set up for it, or NULL, with prog set up
+    //	for current, if the chip has no ID or the ID isn't in the database.
+    const chipinfo::chipinfo*	detect(kitsrus::kitsrus_t &prog, const chipinfo::chipinfo &current);
+}
+
+#endif	// CHIPDETECT_H
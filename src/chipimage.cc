@@ -0,0 +1,139 @@
+/*  Dense in-memory image of a target chip
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <string.h>
+
+#include <QFile>
+
+#include "chipimage.h"
+
+namespace chipimage
+{
+    chipimage_t::storage_t::storage_t(size_type l) : base(new uint8_t[l]), length(l), file(NULL) {}
+
+    chipimage_t::storage_t::storage_t(const storage_t &other) : QSharedData(), base(new uint8_t[other.length]), length(other.length), file(NULL)
+    {
+	memcpy(base, other.base, length);
+    }
+
+    chipimage_t::storage_t::~storage_t()
+    {
+	if( file )
+	    delete file;	// Closing the file unmaps it
+	else
+	    delete[] base;
+    }
+
+    chipimage_t::chipimage_t()
+    {
+	memset(regions, 0, sizeof(regions));
+    }
+
+    // Figure out where each region lives on the chip and in storage
+    void chipimage_t::plan(const chipinfo::chipinfo &chip, layout_t layout[NUM_REGIONS])
+    {
+	layout[ROM].begin = chip.romBegin();
+	layout[ROM].size = 2*chip.rom_size;
+	layout[EEPROM].begin = chip.get_eeprom_start();
+	layout[EEPROM].size = chip.eeprom_size;
+	layout[ID].begin = chip.get_id_start();
+	layout[ID].size = 4;
+	layout[CONFIG].begin = chip.get_config_start();
+	layout[CONFIG].size = 2*chip.numConfigWords();
+
+	size_type offset = 0;
+	for(unsigned r=0; r < NUM_REGIONS; ++r)
+	{
+	    layout[r].used = 0;
+	    layout[r].offset = offset;
+	    offset += (layout[r].size + CHIPIMAGE_ALIGNMENT - 1) & ~(CHIPIMAGE_ALIGNMENT - 1);
+	}
+    }
+
+    // Fill the regions with their blank values
+    //	ROM is filled with the little-endian blank word, everything else with 0xFF
+    void chipimage_t::clear(const chipinfo::chipinfo &chip)
+    {
+	plan(chip, regions);
+	const layout_t &last = regions[NUM_REGIONS-1];
+	storage = new storage_t(last.offset + ((last.size + CHIPIMAGE_ALIGNMENT - 1) & ~(CHIPIMAGE_ALIGNMENT - 1)));
+	memset(storage->base, 0xFF, storage->length);
+
+	const uint16_t blank = chip.romBlank();
+	uint8_t *const rom = storage->base + regions[ROM].offset;
+	for(size_type i=0; i < regions[ROM].size; i += 2)
+	{
+	    rom[i] = blank & 0xFF;
+	    rom[i+1] = (blank >> 8) & 0xFF;
+	}
+    }
+
+    void chipimage_t::reset()
+    {
+	for(unsigned r=0; r < NUM_REGIONS; ++r)
+	    regions[r].used = 0;
+    }
+
+    void chipimage_t::load(const chipinfo::chipinfo &chip, intelhex::hex_data &HexData)
+    {
+	clear(chip);
+
+	for(unsigned r=0; r < NUM_REGIONS; ++r)
+	{
+	    layout_t &region = regions[r];
+	    uint8_t *const p = storage->base + region.offset;
+	    for(size_type i=0; i < region.size; ++i)
+		if( HexData.isset(region.begin + i) )
+		{
+		    p[i] = HexData.get(region.begin + i);
+		    region.used = i + 1;
+		}
+	}
+    }
+
+    void chipimage_t::adopt(QFile *file, const uint8_t *base, size_type length, const layout_t layout[NUM_REGIONS])
+    {
+	storage = new storage_t(file, base, length);
+	memcpy(regions, layout, sizeof(regions));
+    }
+
+    bool chipimage_t::matches(const chipinfo::chipinfo &chip) const
+    {
+	layout_t layout[NUM_REGIONS];
+	plan(chip, layout);
+	for(unsigned r=0; r < NUM_REGIONS; ++r)
+	    if( (layout[r].begin != regions[r].begin) || (layout[r].size != regions[r].size) )
+		return false;
+	return true;
+    }
+
+    // Make a private copy of shared or mapped storage before modifying it
+    void chipimage_t::detach()
+    {
+	if( storage && ((storage->ref != 1) || storage->file) )
+	    storage = new storage_t(*storage);
+    }
+
+    void chipimage_t::set(region_t r, size_type offset, uint8_t value)
+    {
+	detach();
+	layout_t &region = regions[r];
+	storage->base[region.offset + offset] = value;
+	if( offset >= region.used )
+	    region.used = offset + 1;
+    }
+
+    void chipimage_t::put(address_t address, uint8_t value)
+    {
+	for(unsigned r=0; r < NUM_REGIONS; ++r)
+	    if( (address >= regions[r].begin) && (address - regions[r].begin < regions[r].size) )
+	    {
+		set((region_t)r, address - regions[r].begin, value);
+		return;
+	    }
+    }
+}
@@ -0,0 +1,103 @@
+/*  Dense in-memory image of a target chip
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	CHIPIMAGE_H
+#define	CHIPIMAGE_H
+
+#include <QExplicitlySharedDataPointer>
+#include <QSharedData>
+
+#include "chipinfo.h"
+#include "intelhex.h"
+
+class QFile;
+
+namespace chipimage
+{
+    // The regions of a chip that the programmer knows how to write
+    enum region_t { ROM = 0, EEPROM, ID, CONFIG, NUM_REGIONS };
+
+    // Region payloads start on multiples of this many bytes
+    #define	CHIPIMAGE_ALIGNMENT	64
+
+    // A hex_data is sparse and keyed by address, which is fine for files but
+    //	slow to walk and compare. A chipimage_t holds one contiguous, blank
+    //	filled buffer per region, laid out the way the programmer sends it.
+    //	All of the regions live in a single block of storage that's shared
+    //	between copies of the image, and that may be a memory-mapped file.
+    //	Modifying an image gives it a private copy of the storage first.
+    class chipimage_t
+    {
+    public:
+	typedef	chipinfo::chipinfo::address_t	address_t;
+	typedef	uint32_t	size_type;
+
+	// Where a region lives on the chip and in the image's storage
+	struct layout_t
+	{
+	    address_t	begin;	// Chip address of the first byte
+	    size_type	size;	// Number of bytes
+	    size_type	used;	// Bytes from begin through the last byte that was set
+	    size_type	offset;	// Offset of the first byte in storage
+	};
+
+	chipimage_t();
+	chipimage_t(const chipinfo::chipinfo &chip, intelhex::hex_data &HexData)
+	{
+	    load(chip, HexData);
+	}
+
+	void	clear(const chipinfo::chipinfo &);	// Resize for a chip and fill with blanks
+	// Forget which bytes were set without touching the storage, so that an
+	//  image can be refilled by another readback without reallocating
+	void	reset();
+	void	load(const chipinfo::chipinfo &, intelhex::hex_data &);
+	// Use part of an open file's mapping as the storage, and take ownership of the file
+	void	adopt(QFile *, const uint8_t *base, size_type length, const layout_t [NUM_REGIONS]);
+
+	bool	empty() const { return !storage;	}
+	// Returns true if the regions are laid out the way they would be for chip
+	bool	matches(const chipinfo::chipinfo &chip) const;
+
+	const layout_t&	layout(region_t r) const { return regions[r];	}
+	address_t	begin(region_t r) const { return regions[r].begin;	}
+	address_t	end(region_t r) const { return regions[r].begin + size(r);	}
+	size_type	size(region_t r) const { return regions[r].size;	}
+	size_type	used(region_t r) const { return regions[r].used;	}
+
+	const uint8_t*	data(region_t r) const { return storage ? storage->base + regions[r].offset : NULL;	}
+	// The block of storage that holds all of the regions, padding included
+	const uint8_t*	data() const { return storage ? storage->base : NULL;	}
+	size_type	storage_size() const { return storage ? storage->length : 0;	}
+
+	uint8_t	get(region_t r, size_type offset) const { return storage->base[regions[r].offset + offset];	}
+	void	set(region_t, size_type offset, uint8_t);
+	void	put(address_t, uint8_t);	// Set a byte by chip address. Bytes outside of every region are dropped.
+
+    private:
+	class storage_t : public QSharedData
+	{
+	public:
+	    storage_t(size_type);
+	    storage_t(const storage_t &);
+	    storage_t(QFile *f, const uint8_t *b, size_type l) : base(const_cast<uint8_t*>(b)), length(l), file(f) {}
+	    ~storage_t();
+
+	    uint8_t*	base;
+	    size_type	length;
+	    QFile*	file;	// Non-NULL if base points into a mapped file
+	};
+
+	QExplicitlySharedDataPointer<storage_t>	storage;
+	layout_t	regions[NUM_REGIONS];
+
+	static void	plan(const chipinfo::chipinfo &, layout_t [NUM_REGIONS]);
+	void	detach();
+    };
+}
+
+#endif	// CHIPIMAGE_H
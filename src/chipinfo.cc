@@ -7,161 +7,268 @@
 
 #include <iostream>
 
+#include <string.h>
+
 #include "chipinfo.h"
 
 namespace chipinfo
 {
-    const std::string	key_ConfigWordDescriptions("ConfigWordDescriptions");
-
-    bool chipinfo::set(std::string key, std::string value)
-    {
-	if( (key=="CHIPname") || (key=="Name") )
-	    name = value;
-	else if(key=="INCLUDE") {}
-	else if(key=="SocketImage") {}
-	else if(key=="EraseMode")
-	    erase_mode = strtol(value.c_str(), NULL, 10);
-	else if(key=="FlashChip") {}
-	else if( key=="FastPowerSequence" )
-	    fast_power = (value=="1");
-	else if(key=="PowerSequence")
-	{
-	    if(value=="Vcc")
-		power_sequence = 0;
-	    else if(value=="VccVpp1")
-		power_sequence = 1;
-	    else if(value=="VccVpp2")
-		power_sequence = 2;
-	    else if(value=="Vpp1Vcc")
-		power_sequence = 3;
-	    else if(value=="Vpp2Vcc")
-		power_sequence = 4;
-	}
-	else if(key=="ProgramDelay")
-	    program_delay = strtol(value.c_str(), NULL, 10);
-	else if(key=="ProgramTries")
-	    program_tries = strtol(value.c_str(), NULL, 10);
-	else if(key=="OverProgram")
-	    over_program = strtol(value.c_str(), NULL, 10);
-	else if(key=="CoreType")
+    // Keys with behavior attached. Keys that are known but ignored map to KEY_IGNORED.
+    enum key_id_t
+    {
+	KEY_IGNORED, KEY_NAME, KEY_ERASE_MODE, KEY_FAST_POWER, KEY_POWER_SEQUENCE,
+	KEY_PROGRAM_DELAY, KEY_PROGRAM_TRIES, KEY_OVER_PROGRAM, KEY_CORE_TYPE,
+	KEY_FUSE_BLANK, KEY_CAL_WORD, KEY_BAND_GAP, KEY_CHIP_ID,
+	KEY_NUM_CONFIG_WORDS, KEY_NUM_EEPROM_BYTES, KEY_NUM_ROM_WORDS, KEY_STAMP,
+	KEY_EEPROM_SIZE, KEY_ROM_SIZE
+    };
+
+    struct entry_t
+    {
+	const char*	name;
+	size_t		length;
+	int		value;
+    };
+    #define	ENTRY(n, v)	{n, sizeof(n)-1, v}
+
+    // These tables are searched with a binary search, so they MUST be kept
+    //	sorted by name in byte order (uppercase sorts before lowercase)
+    static const entry_t keys[] =
+    {
+	ENTRY("BandGap",		KEY_BAND_GAP),
+	ENTRY("CALword",		KEY_CAL_WORD),
+	ENTRY("CHIPname",		KEY_NAME),
+	ENTRY("CPwarn",			KEY_IGNORED),
+	ENTRY("ChipID",			KEY_CHIP_ID),
+	ENTRY("ChipID1",		KEY_IGNORED),
+	ENTRY("CoreType",		KEY_CORE_TYPE),
+	ENTRY("CreateTimeStamp",	KEY_STAMP),
+	ENTRY("EEPROMsize",		KEY_EEPROM_SIZE),	// chipinfo.cid, in hex
+	ENTRY("EraseMode",		KEY_ERASE_MODE),
+	ENTRY("FUSEblank",		KEY_FUSE_BLANK),
+	ENTRY("FastPowerSequence",	KEY_FAST_POWER),
+	ENTRY("FlashChip",		KEY_IGNORED),
+	ENTRY("FlashROM",		KEY_IGNORED),
+	ENTRY("ICSPonly",		KEY_IGNORED),
+	ENTRY("ID",			KEY_IGNORED),
+	ENTRY("INCLUDE",		KEY_IGNORED),
+	ENTRY("Name",			KEY_NAME),
+	ENTRY("NumConfigWords",		KEY_NUM_CONFIG_WORDS),
+	ENTRY("NumEEPROMBytes",		KEY_NUM_EEPROM_BYTES),
+	ENTRY("NumPayloadBits",		KEY_IGNORED),
+	ENTRY("NumPayloadCommandBits",	KEY_IGNORED),
+	ENTRY("NumROMWords",		KEY_NUM_ROM_WORDS),
+	ENTRY("OverProgram",		KEY_OVER_PROGRAM),
+	ENTRY("PowerSequence",		KEY_POWER_SEQUENCE),
+	ENTRY("ProgramDelay",		KEY_PROGRAM_DELAY),
+	ENTRY("ProgramTries",		KEY_PROGRAM_TRIES),
+	ENTRY("ROMsize",		KEY_ROM_SIZE),		// chipinfo.cid, in hex
+	ENTRY("SocketImage",		KEY_IGNORED),
+	ENTRY("SocketImageType",	KEY_IGNORED),
+	ENTRY("Status",			KEY_IGNORED),
+	ENTRY("Type",			KEY_IGNORED),
+    };
+
+    static const entry_t core_types[] =
+    {
+	ENTRY("bit12_A",	Core12_A),	// 12C50x 12 bit
+	ENTRY("bit12_B",	Core12_B),	// 16F57
+	ENTRY("bit14_A",	Core14_A),	// 12C67x, 16C50x, 16Cxxx
+	ENTRY("bit14_B",	Core14_B),	// 16C8x 16F8x, 16F87x 16F62x
+	ENTRY("bit14_C",	Core14_C),	// 16F7x 16F7x7
+	ENTRY("bit14_D",	Core14_D),	// 12F67x
+	ENTRY("bit14_E",	Core14_E),	// 16F87x-A
+	ENTRY("bit14_F",	Core14_F),	// 16F818
+	ENTRY("bit14_G",	Core14_G),	// 16F87, 88
+	ENTRY("bit14_H",	Core10_A),	// 10Fxxx
+	ENTRY("bit16_A",	Core16_A),	// 18Fx230x330
+	ENTRY("bit16_B",	Core16_B),	// 18Fxx2xx8
+	ENTRY("bit16_C",	Core16_C),	// 18F6x2x
+    };
+
+    // chipinfo.cid marks a fast power sequence in its name instead of with FastPowerSequence
+    #define	FAST_POWER	0x100
+
+    static const entry_t power_sequences[] =
+    {
+	ENTRY("Vcc",		0),
+	ENTRY("VccFastVpp1",	1 | FAST_POWER),
+	ENTRY("VccFastVpp2",	2 | FAST_POWER),
+	ENTRY("VccVpp1",	1),
+	ENTRY("VccVpp2",	2),
+	ENTRY("Vpp1Vcc",	3),
+	ENTRY("Vpp2Vcc",	4),
+    };
+
+    // Keys that are numbered, and ignored, rather than listed above
+    static const entry_t key_ConfigWordDescriptions = ENTRY("ConfigWordDescriptions", KEY_IGNORED);
+
+    #undef	ENTRY
+    #define	TABLE_SIZE(t)	(sizeof(t)/sizeof(t[0]))
+
+    // Binary search a sorted table. Returns NULL if the name isn't there.
+    static const entry_t* find(const entry_t *table, size_t size, const char *name, size_t length)
+    {
+	while( size )
 	{
-	    if(value=="bit16_C")		// 18F6x2x
-	    {
-		core_type = Core16_C;
-		rom_blank = BLANK_16BIT;
-	    }
-	    if(value=="bit16_A")		// 18Fx230x330
-	    {
-		core_type = Core16_A;
-		rom_blank = BLANK_16BIT;
-	    }
-	    if(value=="bit16_B")		// 18Fxx2xx8
-	    {
-		core_type = Core16_B;
-		rom_blank = BLANK_16BIT;
-	    }
-	    if(value=="bit12_A")		// 12C50x 12 bit
-	    {
-		core_type = Core12_A;
-		rom_blank = BLANK_12BIT;
-	    }
-	    if(value=="bit14_A")		// 12C67x, 16C50x, 16Cxxx
-	    {
-		core_type = Core14_A;
-		rom_blank = BLANK_14BIT;
-	    }
-	    if(value=="bit14_B")		// 16C8x 16F8x, 16F87x 16F62x
+	    const entry_t *const middle = table + size/2;
+	    int c = memcmp(middle->name, name, (middle->length < length) ? middle->length : length);
+	    if( c == 0 )
+		c = (middle->length < length) ? -1 : ((middle->length > length) ? 1 : 0);
+	    if( c == 0 )
+		return middle;
+	    if( c < 0 )
 	    {
-		core_type = Core14_B;
-		rom_blank = BLANK_14BIT;
+		table = middle + 1;
+		size -= size/2 + 1;
 	    }
-	    if(value=="bit14_C")		// 16F7x 16F7x7
-	    {
-		core_type = Core14_C;
-		rom_blank = BLANK_14BIT;
-	    }
-	    if(value=="bit14_D")		// 12F67x
-	    {
-		core_type = Core14_D;
-		rom_blank = BLANK_14BIT;
-	    }
-	    if(value=="bit14_E")		// 16F87x-A
-	    {
-		core_type = Core14_E;
-		rom_blank = BLANK_14BIT;
-	    }
-	    if(value=="bit14_F")		// 16F818
-	    {
-		core_type = Core14_F;
-		rom_blank = BLANK_14BIT;
-	    }
-	    if(value=="bit14_G")		// 16F87, 88
-	    {
-		core_type = Core14_G;
-		rom_blank = BLANK_14BIT;
-	    }
-	    if(value=="bit14_H")		// 10Fxxx
-	    {
-		core_type = Core10_A;
-		rom_blank = BLANK_12BIT;
-	    }
-	    if(value=="bit12_B")		// 16F57
-	    {
-		core_type = Core12_B;
-		rom_blank = BLANK_12BIT;
-	    }
-
-	    if(core_type == Core16_A)	//Set iff Core16_A
-		single_panel = true;
 	    else
-		single_panel = false;
+		size /= 2;
 	}
-	else if(key=="FUSEblank")
-	    fuse_blank = strtol(value.c_str(), NULL, 16);
-	else if(key=="CPwarn") {}
-	else if(key=="CALword")
+	return NULL;
+    }
+
+    // Like strtoul(), but for strings that aren't NUL terminated
+    static unsigned long parse_number(const char *p, size_t length, unsigned base)
+    {
+	const char *const end = p + length;
+	if( (base == 16) && (length > 2) && (p[0] == '0') && ((p[1] == 'x') || (p[1] == 'X')) )
+	    p += 2;
+
+	unsigned long n = 0;
+	for(; p < end; ++p)
 	{
-	    if(value == "Y")
-		cal_word = true;
+	    unsigned digit;
+	    if( (*p >= '0') && (*p <= '9') )
+		digit = *p - '0';
+	    else if( (*p >= 'a') && (*p <= 'f') )
+		digit = *p - 'a' + 10;
+	    else if( (*p >= 'A') && (*p <= 'F') )
+		digit = *p - 'A' + 10;
 	    else
-		cal_word = false;
+		break;
+	    if( digit >= base )
+		break;
+	    n = n*base + digit;
 	}
-	else if(key=="BandGap")
+	return n;
+    }
+
+    static bool is_yes(const char *value, size_t length)
+    {
+	return (length == 1) && (value[0] == 'Y');
+    }
+
+    bool chipinfo::set(const std::string &key, const std::string &value)
+    {
+	return set(key.data(), key.size(), value.data(), value.size());
+    }
+
+    bool chipinfo::set(const char *key, size_t key_length, const char *value, size_t value_length)
+    {
+	const entry_t *const entry = find(keys, TABLE_SIZE(keys), key, key_length);
+	if( !entry )
 	{
-	    if(value == "Y")
-		band_gap = true;
-	    else
-		band_gap = false;
+	    if( (key_length >= key_ConfigWordDescriptions.length) &&
+		(memcmp(key, key_ConfigWordDescriptions.name, key_ConfigWordDescriptions.length) == 0) )
+		return true;
+
+	    std::cerr << "Unrecognized key: " << std::string(key, key_length) << " => " << std::string(value, value_length) << std::endl;
+	    return false;
 	}
-	else if(key=="ICSPonly") {}
-	else if(key=="ChipID")
-	    chip_id = strtol(value.c_str(), NULL, 16);
-	else if(key=="Type") {}
-	else if(key=="ChipID1")	{}
-	else if(key=="FlashROM")	{}
-	else if(key=="NumConfigWords")
-	    num_config_words = strtol(value.c_str(), NULL, 10);
-	else if(key=="NumEEPROMBytes")
-	    eeprom_size = strtol(value.c_str(), NULL, 10);
-	else if(key=="NumPayloadBits")	{}
-	else if(key=="NumPayloadCommandBits")	{}
-	else if(key=="NumROMWords")
-	    rom_size = strtoul(value.c_str(), NULL, 10);
-	else if(key=="SocketImageType")	{}
-	else if(key=="Status")	{}
-	else if( equal(key_ConfigWordDescriptions.begin(), key_ConfigWordDescriptions.end(), key.begin()) )	{}
-	else if ( (key=="ID") || 	// Keys to ignore
-		  (key=="CreateTimeStamp")
-		) {}
-	else
+
+	switch( entry->value )
 	{
-	    std::cout << "Unrecognized key: " << key << " => " << value << std::endl;
-	    return false;
+	    case KEY_NAME:
+		name.assign(value, value_length);
+		break;
+	    case KEY_STAMP:
+		stamp.assign(value, value_length);
+		break;
+	    case KEY_ERASE_MODE:
+		erase_mode = parse_number(value, value_length, 10);
+		break;
+	    case KEY_FAST_POWER:
+		fast_power = (value_length == 1) && (value[0] == '1');
+		break;
+	    case KEY_POWER_SEQUENCE:
+	    {
+		const entry_t *const sequence = find(power_sequences, TABLE_SIZE(power_sequences), value, value_length);
+		if( sequence )
+		{
+		    power_sequence = sequence->value & ~FAST_POWER;
+		    if( sequence->value & FAST_POWER )
+			fast_power = true;
+		}
+		break;
+	    }
+	    case KEY_PROGRAM_DELAY:
+		program_delay = parse_number(value, value_length, 10);
+		break;
+	    case KEY_PROGRAM_TRIES:
+		program_tries = parse_number(value, value_length, 10);
+		break;
+	    case KEY_OVER_PROGRAM:
+		over_program = parse_number(value, value_length, 10);
+		break;
+	    case KEY_CORE_TYPE:
+	    {
+		const entry_t *const core = find(core_types, TABLE_SIZE(core_types), value, value_length);
+		if( core )
+		{
+		    core_type = core->value;
+		    rom_blank = romBlank();
+		}
+		single_panel = (core_type == Core16_A);	//Set iff Core16_A
+		break;
+	    }
+	    case KEY_FUSE_BLANK:	// One hex word per config word, separated by spaces
+	    {
+		const char *const end = value + value_length;
+		const char *p = value;
+		for(unsigned i=0; i < MAX_CONFIG_WORDS; ++i)
+		{
+		    while( (p < end) && (*p == ' ') )
+			++p;
+		    const char *const word = p;
+		    while( (p < end) && (*p != ' ') )
+			++p;
+		    fuse_blanks[i] = parse_number(word, p - word, 16);
+		}
+		fuse_blank = fuse_blanks[0];
+		break;
+	    }
+	    case KEY_CAL_WORD:
+		cal_word = is_yes(value, value_length);
+		break;
+	    case KEY_BAND_GAP:
+		band_gap = is_yes(value, value_length);
+		break;
+	    case KEY_CHIP_ID:
+		chip_id = parse_number(value, value_length, 16);
+		break;
+	    case KEY_NUM_CONFIG_WORDS:
+		num_config_words = parse_number(value, value_length, 10);
+		break;
+	    case KEY_NUM_EEPROM_BYTES:
+		eeprom_size = parse_number(value, value_length, 10);
+		break;
+	    case KEY_NUM_ROM_WORDS:
+		rom_size = parse_number(value, value_length, 10);
+		break;
+	    case KEY_EEPROM_SIZE:
+		eeprom_size = parse_number(value, value_length, 16);
+		break;
+	    case KEY_ROM_SIZE:
+		rom_size = parse_number(value, value_length, 16);
+		break;
+	    default:	// Known, but ignored
+		break;
 	}
 	return true;
     }
 
-    bool chipinfo::is14bit()
+    bool chipinfo::is14bit() const
     {
 	switch(core_type)
 	{
@@ -178,7 +285,7 @@ namespace chipinfo
 	}
     }
 
-    bool chipinfo::is16bit()
+    bool chipinfo::is16bit() const
     {
 	switch(core_type)
 	{
@@ -191,7 +298,7 @@ namespace chipinfo
 	}
     }
 
-    uint32_t chipinfo::get_eeprom_start()
+    uint32_t chipinfo::get_eeprom_start() const
     {
 	if( (core_type==Core16_C) || (core_type==Core16_A) || (core_type==Core16_B))
 	    return EEPROM_START_16BIT;
@@ -199,7 +306,7 @@ namespace chipinfo
 	    return EEPROM_START_14BIT;
     }
 
-    uint32_t chipinfo::get_config_start()
+    uint32_t chipinfo::get_config_start() const
     {
 	if( (core_type==Core12_A) || (core_type==Core12_B) )
 	    return CONFIG_START_12BIT;
@@ -209,7 +316,7 @@ namespace chipinfo
 	    return CONFIG_START_14BIT;
     }
 
-    uint32_t chipinfo::get_id_start()
+    uint32_t chipinfo::get_id_start() const
     {
 	if( is12bit() )
 	    return rom_size;	// ID locations immediately follow program words
@@ -221,7 +328,14 @@ namespace chipinfo
 	    return 0;	//FIXME
     }
 
-    uint32_t chipinfo::get_blank_value()
+    uint16_t chipinfo::configMask(unsigned word) const
+    {
+	if( (word < MAX_CONFIG_WORDS) && fuse_blanks[word] )
+	    return fuse_blanks[word];
+	return romBlank();	// Unknown, so every bit that a word can have
+    }
+
+    uint32_t chipinfo::get_blank_value() const
     {
 	if( (core_type==Core16_C) || (core_type==Core16_A) || (core_type==Core16_B))
 	    return BLANK_16BIT;
@@ -36,6 +36,13 @@ namespace chipinfo
 	#define	ID_START_14BIT	0x2000
 	#define	ID_START_16BIT	0x200000
 
+	// The low bits of a device ID word are the silicon revision, which
+	//  ChipID leaves out
+	#define	CHIP_ID_REVISION_MASK	0x001F
+
+	// The programmer takes at most this many config words
+	#define	MAX_CONFIG_WORDS	7
+
 	// Core Type Codes	for chipinfo file
 	#define	Core16_C	0   // 18F6x2x
 	#define	Core16_A	1   // 18Fx230x330
@@ -51,14 +58,20 @@ namespace chipinfo
 	#define	Core12_B	11  // 16F57
 	#define	Core10_A	12  // 10Fxxx
 
-	chipinfo() : fast_power(false) {}
+	chipinfo() : chip_id(0), rom_size(0), eeprom_size(0), num_config_words(0), fuse_blank(0), fast_power(false)
+	{
+	    for(unsigned i=0; i < MAX_CONFIG_WORDS; ++i)
+		fuse_blanks[i] = 0;
+	}
 
 	std::string	name;		    //Chip name
+	std::string	stamp;		    //CreateTimeStamp, when the device info last changed
 	uint16_t	chip_id;
 	rom_size_type	rom_size;	    //Number of ROM words
 	eeprom_size_type    eeprom_size;    //EEPROM size in bytes
 	uint8_t	num_config_words;
-	uint16_t    fuse_blank;
+	uint16_t    fuse_blank;		    //Blank value of the first config word
+	uint16_t    fuse_blanks[MAX_CONFIG_WORDS];  //Blank value of each config word, zero if unknown
 	uint32_t    rom_blank;		    //Value of a blank ROM word
 	uint8_t	program_delay;
 	uint8_t	erase_mode;
@@ -71,21 +84,27 @@ namespace chipinfo
 	bool	fast_power;
 	bool	single_panel;
 
-	bool set(std::string, std::string);
+	// Set a field from a device info key/value pair
+	//  Returns false for keys that it doesn't know about
+	bool set(const std::string &key, const std::string &value);
+	bool set(const char *key, size_t key_length, const char *value, size_t value_length);
 
-	bool is12bit()
+	bool is12bit() const
 	{
 	    return (core_type == Core12_A) || (core_type == Core12_B);
 	}
 
-	bool	is14bit();
-	bool	is16bit();
+	bool	is14bit() const;
+	bool	is16bit() const;
 
-	uint32_t	get_eeprom_start();
-	uint32_t	get_config_start();
-	uint32_t	get_id_start();
-	uint32_t	get_blank_value();
+	uint32_t	get_eeprom_start() const;
+	uint32_t	get_config_start() const;
+	uint32_t	get_id_start() const;
+	uint32_t	get_blank_value() const;
 	const uint8_t	numConfigWords() const { return num_config_words;	}
+	// The bits of a config word that the chip implements. A blank config
+	//  word has all of them set, and the rest always read back as zero.
+	uint16_t	configMask(unsigned word) const;
 
 	const uint8_t	eepromBlank()	const { return 0xFF;	}
 	const address_t	eepromBegin()	const
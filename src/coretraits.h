@@ -0,0 +1,113 @@
+/*  Compile-time constants for each PIC core family
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	CORETRAITS_H
+#define	CORETRAITS_H
+
+#include "chipinfo.h"
+
+// chipinfo answers questions about a part by switching on its core type every
+//  time it's asked. Code that's templated on one of the trait classes below
+//  gets the answers as constants instead, so the family only has to be looked
+//  up once (see family()) to pick the right instantiation.
+//
+//  The values match what chipinfo returns for each family.
+namespace coretraits
+{
+    // CORE_UNKNOWN is for core types that aren't in the list below. There
+    //	aren't any traits for it, because there's no telling where anything is
+    //	on such a part, so it can't be programmed.
+    enum family_t { CORE10, CORE12, CORE14, CORE16, CORE_UNKNOWN };
+
+    // 10Fxxx
+    struct Core10
+    {
+	enum
+	{
+	    rom_blank = BLANK_12BIT,
+	    eeprom_start = EEPROM_START_14BIT,
+	    config_start = CONFIG_START_14BIT,
+	    reads_id = false,		// The config readback doesn't include the ID locations
+	    id_follows_rom = false,
+	    id_start = 0,
+	    has_fuse = false		// Config is also written with CMD_WRITE_FUSE
+	};
+    };
+
+    // 12C50x, 16F57
+    struct Core12
+    {
+	enum
+	{
+	    rom_blank = BLANK_12BIT,
+	    eeprom_start = EEPROM_START_12BIT,
+	    config_start = CONFIG_START_12BIT,
+	    reads_id = true,
+	    id_follows_rom = true,	// ID locations immediately follow program words
+	    id_start = 0,
+	    has_fuse = false
+	};
+    };
+
+    // 12F6xx, 16Cxxx, 16Fxxx
+    struct Core14
+    {
+	enum
+	{
+	    rom_blank = BLANK_14BIT,
+	    eeprom_start = EEPROM_START_14BIT,
+	    config_start = CONFIG_START_14BIT,
+	    reads_id = true,
+	    id_follows_rom = false,
+	    id_start = ID_START_14BIT,
+	    has_fuse = false
+	};
+    };
+
+    // 18Fxxx
+    struct Core16
+    {
+	enum
+	{
+	    rom_blank = BLANK_16BIT,
+	    eeprom_start = EEPROM_START_16BIT,
+	    config_start = CONFIG_START_16BIT,
+	    reads_id = false,
+	    id_follows_rom = false,
+	    id_start = ID_START_16BIT,
+	    has_fuse = true
+	};
+    };
+
+    inline family_t family(uint8_t core_type)
+    {
+	switch(core_type)
+	{
+	    case Core10_A:
+		return CORE10;
+	    case Core12_A:
+	    case Core12_B:
+		return CORE12;
+	    case Core14_A:
+	    case Core14_B:
+	    case Core14_C:
+	    case Core14_D:
+	    case Core14_E:
+	    case Core14_F:
+	    case Core14_G:
+		return CORE14;
+	    case Core16_A:
+	    case Core16_B:
+	    case Core16_C:
+		return CORE16;
+	    default:
+		return CORE_UNKNOWN;
+	}
+    }
+}
+
+#endif	// CORETRAITS_H
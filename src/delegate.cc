@@ -9,10 +9,11 @@
 #include <QMessageBox>
 #include <QProgressDialog>
 #include <QSettings>
-#include <QTextStream>
+#include <QUrl>
 
 #include "centralwidget.h"
 #include "delegate.h"
+#include "devicedatabase.h"
 #include "mainwindow.h"
 
 #define	POST_STARTUP_DID_FINISH	qApp->postEvent(this, new QEvent((QEvent::Type)Delegate::StartupDidFinish), Qt::LowEventPriority)
@@ -33,8 +34,8 @@ void Delegate::startup()
 	}
     }
 
-    //See if the device info exists and warn the user if it doesn't
-    if( settings.childGroups().contains("DeviceInfo") )
+    //Load the device info and warn the user if it doesn't exist
+    if( deviceDatabase.load() )
 	POST_STARTUP_DID_FINISH;
     else
     {
@@ -73,6 +74,7 @@ void Delegate::customEvent(QEvent* e)
 	    break;
 	case (QEvent::Type)StartupDidFinish:
 	{
+	    started = true;
 	    (new MainWindow())->show();
 	    break;
 	}
@@ -84,33 +86,91 @@ void Delegate::customEvent(QEvent* e)
     }
 }
 
-//  Get the device info database and store it
-//   All device info is stored with a prefix of "DeviceInfo"
+#define	DEVICE_INFO_URL	"http://bfoz.net/projects/qprog/api/?command=export"
+
+QUrl Delegate::deviceInfoURL()
+{
+    const QByteArray env(qgetenv("QPROG_DEVICE_INFO_URL"));
+    if( !env.isEmpty() )
+	return QUrl(QString::fromLocal8Bit(env.constData()));
+    return QUrl(QSettings().value("DeviceInfoDownload/URL", DEVICE_INFO_URL).toString());
+}
+
+//  Get the device info database and import it
+//   The response is parsed as it arrives, and the database is built on
+//   another thread once the download is complete
 void Delegate::getDeviceInfo()
 {
-    if( !buffer )
-	buffer = new QBuffer;
-
-    progressDialog = new QProgressDialog();
-    progressDialog->setWindowTitle("Updating device info");
-    progressDialog->setCancelButtonText("Cancel");
-    progressDialog->setMinimumDuration(0);
-    progressDialog->setModal(true);
+    if( parser || builder )
+	return;			// Already updating
+
+    url = deviceInfoURL();
+    if( !url.isValid() || url.host().isEmpty() )
+    {
+	QMessageBox::critical(NULL, tr("Device Info"), tr("Bad device info URL %1").arg(url.toString()));
+	updateDidFinish(false);
+	return;
+    }
+
+    parser = new DeviceInfoParser;
+    notModified = false;
+    httpRequestAborted = false;
+
+    if( !progressDialog )
+    {
+	progressDialog = new QProgressDialog();
+	progressDialog->setWindowTitle("Updating device info");
+	progressDialog->setMinimumDuration(0);
+	progressDialog->setModal(true);
+	connect(progressDialog, SIGNAL(canceled()), this, SLOT(progressCanceled()));
+    }
+    progressDialog->setCancelButtonText("Cancel");	// The last import may have removed it
     progressDialog->show();		//Force the dialog to open immediately
-    connect(progressDialog, SIGNAL(canceled()), this, SLOT(httpCancel()));
 
     if( !http )
     {
-	http = new QHttp("bfoz.net");
-	httpRequestAborted = false;
+	http = new QHttp(this);
 	connect(http, SIGNAL(dataReadProgress(int, int)), this, SLOT(updateProgress(int, int)));
 	connect(http, SIGNAL(requestFinished(int, bool)), this, SLOT(httpRequestFinished(int, bool)));
+	connect(http, SIGNAL(readyRead(const QHttpResponseHeader &)), this, SLOT(httpReadyRead(const QHttpResponseHeader &)));
 	connect(http, SIGNAL(responseHeaderReceived(const QHttpResponseHeader &)), this, SLOT(httpResponseHeader(const QHttpResponseHeader &)));
 	connect(http, SIGNAL(stateChanged(int)), this, SLOT(httpStateChanged(int)));
     }
 
+    const bool https = (url.scheme() == "https");
+    http->setHost(url.host(), https ? QHttp::ConnectionModeHttps : QHttp::ConnectionModeHttp, url.port(https ? 443 : 80));
+
+    // Ask for only the devices that changed since the newest one that's
+    //	loaded. A server that doesn't do deltas sends everything, and that's
+    //	handled too.
+    QUrl request_url(url);
+    const std::string newest(deviceDatabase.newestStamp());
+    if( !newest.empty() )
+	request_url.addQueryItem("since", QString(newest.c_str()));
+
+    QHttpRequestHeader	header("GET", QString(request_url.toEncoded(QUrl::RemoveScheme | QUrl::RemoveAuthority)));
+    header.setValue("Host", url.host());
+
+    // Don't download the database again if the server says it hasn't changed
+    //	since the last import. The validators are only good if that import is
+    //	what's loaded now.
+    if( !deviceDatabase.empty() )
+    {
+	QSettings   settings;
+	const QString previous_url(settings.value("DeviceInfoDownload/Source").toString());
+	const QString previous_etag(settings.value("DeviceInfoDownload/ETag").toString());
+	const QString previous_modified(settings.value("DeviceInfoDownload/LastModified").toString());
+	if( previous_url == url.toString() )
+	{
+	    if( !previous_etag.isEmpty() )
+		header.setValue("If-None-Match", previous_etag);
+	    if( !previous_modified.isEmpty() )
+		header.setValue("If-Modified-Since", previous_modified);
+	}
+    }
+
     // Start the request
-    httpGetId = http->get("/projects/qprog/api/?command=export", buffer);
+    httpGetId = http->request(header);
 }
 
 void Delegate::httpCancel()
@@ -120,82 +180,157 @@ void Delegate::httpCancel()
     httpCleanup();
 }
 
+// The user cancelled the download, so nothing else is going to finish it
+void Delegate::progressCanceled()
+{
+    if( builder )
+	return;		// Too late to cancel, and importFinished() will finish it
+    httpCancel();
+    updateDidFinish(false);
+}
+
 void Delegate::httpCleanup()
 {
     progressDialog->hide();
-    if( buffer )
+    if( parser && !builder )	// The builder is still using it
     {
-	delete buffer;
-	buffer = NULL;
+	delete parser;
+	parser = NULL;
     }
 }
 
 void Delegate::httpResponseHeader(const QHttpResponseHeader &responseHeader)
 {
-    if(responseHeader.statusCode() != 200)
+    switch( responseHeader.statusCode() )
     {
-	QMessageBox msgBox;
-	msgBox.setText("Download Failed");
-	msgBox.setInformativeText(tr("%1").arg(responseHeader.reasonPhrase()));
-	msgBox.setIcon(QMessageBox::Critical);
-	msgBox.setStandardButtons(QMessageBox::Ok);
-	msgBox.setDefaultButton(QMessageBox::Ok);
+	case 200:
+	    etag = responseHeader.value("ETag");
+	    lastModified = responseHeader.value("Last-Modified");
+	    break;
+	case 304:	// The database hasn't changed since it was last imported
+	    notModified = true;
+	    break;
+	default:
+	{
+	    QMessageBox msgBox;
+	    msgBox.setText("Download Failed");
+	    msgBox.setInformativeText(tr("%1").arg(responseHeader.reasonPhrase()));
+	    msgBox.setIcon(QMessageBox::Critical);
+	    msgBox.setStandardButtons(QMessageBox::Ok);
+	    msgBox.setDefaultButton(QMessageBox::Ok);
+
+	    httpCancel();
+	    msgBox.exec();
+	    updateDidFinish(false);
+	}
+    }
+}
 
+// Parse each chunk of the response as it arrives
+void Delegate::httpReadyRead(const QHttpResponseHeader &responseHeader)
+{
+    const QByteArray chunk(http->readAll());
+    if( (responseHeader.statusCode() != 200) || !parser )
+	return;
+
+    if( !parser->feed(chunk.constData(), chunk.size()) )
+    {
+	const QString error(parser->error());
 	httpCancel();
-	POST_STARTUP_DID_FAIL;
+	QMessageBox::critical(NULL, tr("Device Info"), tr("The download was bad: %1").arg(error));
+	updateDidFinish(false);
     }
 }
 
 void Delegate::httpRequestFinished(int requestId, bool error)
 {
-    if( httpRequestAborted || (requestId != httpGetId) )
+    // setHost() is a request too
+    if( requestId != httpGetId )
+	return;
+
+    if( httpRequestAborted )
+	return;		// Whoever aborted it has already cleaned up
+
+    if(error)
     {
+	QMessageBox::information(NULL, tr("HTTP"), tr("Download failed"));
 	httpCleanup();
-	POST_STARTUP_DID_FAIL;
+	updateDidFinish(false);
 	return;
     }
 
-    if(error)
+    if( notModified )
     {
-	QMessageBox::information(NULL, tr("HTTP"), tr("Download failed"));
 	httpCleanup();
-	POST_STARTUP_DID_FAIL;
+	QMessageBox::information(NULL, tr("Device Info"), tr("The device info is already up to date"));
+	updateDidFinish(true);
 	return;
     }
 
-    // Store the server copy of the device info at the user,organization level
-    //  so the user can make changes without corrupting the local copy
-    QSettings	settings(QCoreApplication::organizationName());
+    if( !parser->finish() )
+    {
+	const QString import_error(parser->error());
+	httpCleanup();
+	QMessageBox::critical(NULL, tr("Device Info"), tr("The download was bad: %1").arg(import_error));
+	updateDidFinish(false);
+	return;
+    }
 
-    // Warn if the settings file isn't writable
-    if( !settings.isWritable() )
-	qWarning("Read Only Settings! You need write permission for %s", qPrintable(settings.fileName()));
+    // Apply the changes to a copy of the database and write the snapshot in the background
+    progressDialog->setLabelText("Building device database");
+    progressDialog->setCancelButton(NULL);	// Too late to cancel now
+    builder = new DeviceDatabaseBuilder(deviceDatabase, *parser);
+    connect(builder, SIGNAL(finished()), this, SLOT(importFinished()));
+    builder->start();
+}
 
-    // There's no need to beginGroup() here because the keys returned
-    //  by the server already have the group name included
-    //	settings.beginGroup("DeviceInfo");
-    QTextStream in(buffer->data());
-    while(!in.atEnd())
+// The builder is done, so swap its database in
+void Delegate::importFinished()
+{
+    const bool success = builder->succeeded();
+    const QString import_error(builder->error);
+    const DeviceDatabase::counts_type counts(builder->counts);
+    if( success && counts.changed() )
+	deviceDatabase.swap(builder->database);
+
+    builder->deleteLater();
+    builder = NULL;
+    httpCleanup();
+
+    if( !success )
     {
-	QString line(in.readLine());
-	if( line.contains('=') )
-	{
-	    QStringList qsl = line.split('=');
-	    settings.setValue(qsl.at(0), qsl.at(1));
-	}
+	QMessageBox::critical(NULL, tr("Device Info"), tr("The download couldn't be imported: %1").arg(import_error));
+	updateDidFinish(false);
+	return;
     }
-    //	settings.endGroup();
 
-    httpCleanup();
+    QSettings	settings;
+    settings.setValue("DeviceInfoDownload/Source", url.toString());
+    settings.setValue("DeviceInfoDownload/ETag", etag);
+    settings.setValue("DeviceInfoDownload/LastModified", lastModified);
+
+    if( counts.changed() )
+	emit deviceInfoUpdated();
 
     QMessageBox msgBox;
     msgBox.setText("Download Successful");
-    msgBox.setInformativeText(tr("Retrieved %1 bytes").arg(buffer->size()));
+    msgBox.setInformativeText(tr("Added %1, updated %2, deleted %3, unchanged %4").arg(counts.inserted).arg(counts.updated).arg(counts.deleted).arg(counts.unchanged));
     msgBox.setStandardButtons(QMessageBox::Ok);
     msgBox.setDefaultButton(QMessageBox::Ok);
     msgBox.exec();
 
-    POST_STARTUP_DID_FINISH;
+    updateDidFinish(true);
+}
+
+// Startup waits for the first download to finish, but later updates don't
+void Delegate::updateDidFinish(bool success)
+{
+    if( started )
+	return;
+    if( success )
+	POST_STARTUP_DID_FINISH;
+    else
+	POST_STARTUP_DID_FAIL;
 }
 
 // Change the progress dialog text according to the state of the connection
@@ -204,7 +339,7 @@ void Delegate::httpStateChanged(int state)
     switch(state)
     {
 	case QHttp::HostLookup:
-	    progressDialog->setLabelText("Looking up bfoz.net");
+	    progressDialog->setLabelText(tr("Looking up %1").arg(url.host()));
 	    break;
 	case QHttp::Connecting:
 	    progressDialog->setLabelText("Connecting");
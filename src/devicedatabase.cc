@@ -0,0 +1,808 @@
+/*  In-memory copy of the device info database
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <algorithm>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStringList>
+
+#ifdef	Q_WS_WIN	// Defined by the Qt headers
+#include <windows.h>
+#endif
+
+#include "devicedatabase.h"
+
+#define	SNAPSHOT_MAGIC		"QPROGDDB"
+#define	SNAPSHOT_VERSION	5
+#define	SNAPSHOT_FILE_NAME	"QProg.devices"
+
+// The settings files that device info can come from, in the order that
+//  QSettings falls back through them. The GUI writes to the user's
+//  application file all the time, but device info can be stored there too,
+//  so only the DeviceInfo group of each file goes into the stamp.
+#define	NUM_SOURCES	4
+#define	DEVICE_INFO_GROUP	"DeviceInfo"
+
+// Snapshot file layout
+//  A snapshot_header_t followed by count record_t's. Everything is in host
+//  byte order, because the snapshot never leaves the machine that made it.
+struct snapshot_source_t
+{
+    uint32_t	size;
+    uint8_t	digest[16];	// MD5 of the file's device info, all zero if it has none
+};
+
+struct snapshot_header_t
+{
+    char	magic[8];
+    uint32_t	version;
+    uint32_t	header_size;
+    uint32_t	record_size;
+    uint32_t	count;
+    uint32_t	origin;		// One of the SNAPSHOT_ORIGIN_* values below
+    snapshot_source_t	sources[NUM_SOURCES];	// Only used for SNAPSHOT_ORIGIN_SETTINGS
+};
+
+#define	SNAPSHOT_ORIGIN_SETTINGS    0	// Compiled from the settings, stale when they change
+#define	SNAPSHOT_ORIGIN_IMPORT	    1	// Imported directly, and authoritative
+
+struct record_t
+{
+    char	name[32];	// NUL terminated
+    char	stamp[32];	// NUL terminated, empty if it was too long to store
+    uint32_t	rom_size;
+    uint32_t	rom_blank;
+    uint16_t	chip_id;
+    uint16_t	eeprom_size;
+    uint16_t	fuse_blanks[MAX_CONFIG_WORDS];
+    uint8_t	num_config_words;
+    uint8_t	program_delay;
+    uint8_t	erase_mode;
+    uint8_t	power_sequence;
+    uint8_t	program_tries;
+    uint8_t	core_type;
+    uint8_t	over_program;
+    uint8_t	flags;		// Bits are RECORD_* below
+    uint8_t	reserved[2];
+};
+
+#define	RECORD_CAL_WORD		0x01
+#define	RECORD_BAND_GAP		0x02
+#define	RECORD_FAST_POWER	0x04
+#define	RECORD_SINGLE_PANEL	0x08
+
+static void source_paths(QString paths[NUM_SOURCES])
+{
+    const QString org(QCoreApplication::organizationName());
+    const QString app(QCoreApplication::applicationName());
+    paths[0] = QSettings(QSettings::UserScope, org, app).fileName();
+    paths[1] = QSettings(QSettings::UserScope, org).fileName();
+    paths[2] = QSettings(QSettings::SystemScope, org, app).fileName();
+    paths[3] = QSettings(QSettings::SystemScope, org).fileName();
+}
+
+// The part of a settings file that holds device info, or nothing if it doesn't
+//  have any. QSettings puts each top level group of an INI file in a section
+//  of its own, so that's everything in the [DeviceInfo] section. A property
+//  list can't be picked apart that easily, so all of it counts if it mentions
+//  device info at all.
+static QByteArray device_info(const QByteArray &contents)
+{
+#ifdef	Q_OS_DARWIN
+    return contents.contains(DEVICE_INFO_GROUP) ? contents : QByteArray();
+#else
+    QByteArray	group;
+    bool    inside = false;
+    for(int start=0; start < contents.size(); )
+    {
+	int end = contents.indexOf('\n', start);
+	end = (end == -1) ? contents.size() : end + 1;
+	const QByteArray line(contents.mid(start, end - start));
+	const QByteArray trimmed(line.trimmed());
+	if( trimmed.startsWith("[") )
+	    inside = (trimmed == "[" DEVICE_INFO_GROUP "]");
+	else if( inside )
+	    group.append(line);
+	start = end;
+    }
+    return group;
+#endif	//Q_OS_DARWIN
+}
+
+// Fill in the stamp for the current state of the settings files
+//  Returns false if the settings aren't kept in files (the Windows registry),
+//  in which case there's no way to tell when the snapshot is stale.
+//
+//  Modification times are only good to a second on some filesystems, and a
+//  settings file can be rewritten with the same size within a second, so the
+//  stamp has a hash of the contents instead. A file without device info gets
+//  the same stamp as one that doesn't exist.
+static bool get_stamp(snapshot_source_t *stamp)
+{
+#ifdef	Q_WS_WIN
+    return false;
+#else
+    QString paths[NUM_SOURCES];
+    source_paths(paths);
+
+    memset(stamp, 0, NUM_SOURCES*sizeof(snapshot_source_t));
+    for(unsigned i=0; i < NUM_SOURCES; ++i)
+    {
+	QFile	file(paths[i]);
+	if( !file.open(QIODevice::ReadOnly) )
+	    continue;
+	const QByteArray contents(device_info(file.readAll()));
+	if( contents.isEmpty() )
+	    continue;
+	const QByteArray digest(QCryptographicHash::hash(contents, QCryptographicHash::Md5));
+	stamp[i].size = contents.size();
+	memcpy(stamp[i].digest, digest.constData(), sizeof(stamp[i].digest));
+    }
+    return true;
+#endif	//Q_WS_WIN
+}
+
+QString DeviceDatabase::snapshotPath()
+{
+    return QFileInfo(QSettings().fileName()).absolutePath() + "/" + SNAPSHOT_FILE_NAME;
+}
+
+void DeviceDatabase::clear()
+{
+    devices.clear();
+    byName.clear();
+    byChipID.clear();
+}
+
+void DeviceDatabase::add(const chipinfo::chipinfo &chip_info)
+{
+    // Names should be unique, but if they aren't the first one wins
+    const QString name(chip_info.name.c_str());
+    if( byName.contains(name) )
+	return;
+
+    byName.insert(name, devices.size());
+    if( chip_info.chip_id )
+	byChipID.insert(chip_info.chip_id, devices.size());
+    devices.push_back(chip_info);
+}
+
+// Add a device, or replace the one with the same name
+void DeviceDatabase::put(const chipinfo::chipinfo &chip_info)
+{
+    QHash<QString, size_type>::const_iterator i = byName.find(QString(chip_info.name.c_str()));
+    if( i == byName.end() )
+    {
+	add(chip_info);
+	return;
+    }
+
+    chipinfo::chipinfo &device = devices[i.value()];
+    if( device.chip_id != chip_info.chip_id )
+    {
+	byChipID.remove(device.chip_id, i.value());
+	if( chip_info.chip_id )
+	    byChipID.insert(chip_info.chip_id, i.value());
+    }
+    device = chip_info;
+}
+
+bool DeviceDatabase::load()
+{
+    snapshot_source_t	stamp[NUM_SOURCES];
+    const bool stamped = get_stamp(stamp);
+    const QString path(snapshotPath());
+
+    bool imported = false;
+    snapshot_source_t	sources[NUM_SOURCES];
+    if( loadSnapshot(path, stamped ? stamp : NULL, imported, sources) )
+    {
+	// Settings that were edited after an import override it. The result
+	//  is saved so that the settings don't have to be read again.
+	if( imported && stamped && (memcmp(sources, stamp, sizeof(sources)) != 0) )
+	{
+	    overlaySettings(sources, stamp);
+	    if( !saveSnapshot(path, stamp, true) )
+		qWarning("Could not write the device info snapshot %s", qPrintable(path));
+	}
+	return true;
+    }
+
+    if( !loadSettings() )
+	return false;
+
+    // A snapshot that can't be written just means a slower startup next time
+    if( stamped && !saveSnapshot(path, stamp, false) )
+	qWarning("Could not write the device info snapshot %s", qPrintable(path));
+    return true;
+}
+
+bool DeviceDatabase::loadSettings()
+{
+    clear();
+
+    QSettings	settings;
+    return readSettings(settings, false);
+}
+
+// Re-read each settings file that's changed since an export was imported
+//  and let its devices replace the imported ones. QSettings prefers the
+//  first source, so the sources are read last to first.
+void DeviceDatabase::overlaySettings(const snapshot_source_t *then, const snapshot_source_t *now)
+{
+    QString paths[NUM_SOURCES];
+    source_paths(paths);
+    for(unsigned i=NUM_SOURCES; i-- > 0; )
+	if( memcmp(&then[i], &now[i], sizeof(snapshot_source_t)) != 0 )
+	{
+	    QSettings	settings(paths[i], QSettings::NativeFormat);
+	    readSettings(settings, true);
+	}
+}
+
+// Add the devices in settings to the table. If replace is true they replace
+//  devices with the same name, otherwise the ones already there win.
+bool DeviceDatabase::readSettings(QSettings &settings, bool replace)
+{
+    if( !settings.childGroups().contains(DEVICE_INFO_GROUP) )
+	return false;
+
+    settings.beginGroup(DEVICE_INFO_GROUP);
+
+    if( !settings.childGroups().contains("Devices") )
+	return false;
+
+    size_t numDevices = settings.beginReadArray("Devices");
+    QStringList groups = settings.childGroups();
+    numDevices = groups.count();	// Rude hack to deal with QSettings bug
+    devices.reserve(devices.size() + numDevices);
+
+    for(size_t i=0; i<numDevices; ++i)
+    {
+	settings.setArrayIndex(i);
+	QVariant n = settings.value("Name");
+	if( !n.isValid() || (n.toString().length() == 0) )
+	    continue;
+
+	chipinfo::chipinfo  chip_info;
+	QStringList keys = settings.childKeys();
+	QStringListIterator k(keys);
+	while(k.hasNext())
+	{
+	    QString	key(k.next());
+	    QString	value(settings.value(key).toString());
+	    if( value.size() == 0 )	//Skip empty keys
+		continue;
+	    chip_info.set(key.toStdString(), value.toStdString());
+	}
+	if( replace )
+	    put(chip_info);
+	else
+	    add(chip_info);
+    }
+    settings.endArray();
+    settings.endGroup();
+
+    return true;
+}
+
+bool DeviceDatabase::loadSnapshot(const QString &path, const snapshot_source_t *stamp, bool &imported, snapshot_source_t *sources)
+{
+    QFile   file(path);
+    if( !file.open(QIODevice::ReadOnly) || (file.size() < (qint64)sizeof(snapshot_header_t)) )
+	return false;
+
+    const qint64 length = file.size();
+    const uint8_t *const p = file.map(0, length);
+    if( !p )
+	return false;
+
+    snapshot_header_t	header;
+    memcpy(&header, p, sizeof(header));
+    if( (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0)
+	|| (header.version != SNAPSHOT_VERSION)
+	|| (header.header_size != sizeof(snapshot_header_t))
+	|| (header.record_size != sizeof(record_t))
+	|| (header.header_size + (qint64)header.count*header.record_size > length) )
+	return false;
+
+    // A snapshot of the settings is only good until they change
+    imported = (header.origin == SNAPSHOT_ORIGIN_IMPORT);
+    if( !imported && (!stamp || (memcmp(header.sources, stamp, sizeof(header.sources)) != 0)) )
+	return false;
+    memcpy(sources, header.sources, sizeof(header.sources));
+
+    clear();
+    devices.reserve(header.count);
+    const record_t *const records = reinterpret_cast<const record_t*>(p + header.header_size);
+    for(uint32_t i=0; i < header.count; ++i)
+    {
+	const record_t &r = records[i];
+	chipinfo::chipinfo  chip_info;
+	const char *const end = static_cast<const char*>(memchr(r.name, 0, sizeof(r.name)));
+	chip_info.name.assign(r.name, end ? end - r.name : sizeof(r.name));
+	const char *const stamp_end = static_cast<const char*>(memchr(r.stamp, 0, sizeof(r.stamp)));
+	chip_info.stamp.assign(r.stamp, stamp_end ? stamp_end - r.stamp : sizeof(r.stamp));
+	chip_info.chip_id = r.chip_id;
+	chip_info.rom_size = r.rom_size;
+	chip_info.eeprom_size = r.eeprom_size;
+	chip_info.num_config_words = r.num_config_words;
+	memcpy(chip_info.fuse_blanks, r.fuse_blanks, sizeof(r.fuse_blanks));
+	chip_info.fuse_blank = r.fuse_blanks[0];
+	chip_info.rom_blank = r.rom_blank;
+	chip_info.program_delay = r.program_delay;
+	chip_info.erase_mode = r.erase_mode;
+	chip_info.power_sequence = r.power_sequence;
+	chip_info.program_tries = r.program_tries;
+	chip_info.core_type = r.core_type;
+	chip_info.over_program = r.over_program;
+	chip_info.cal_word = r.flags & RECORD_CAL_WORD;
+	chip_info.band_gap = r.flags & RECORD_BAND_GAP;
+	chip_info.fast_power = r.flags & RECORD_FAST_POWER;
+	chip_info.single_panel = r.flags & RECORD_SINGLE_PANEL;
+	add(chip_info);
+    }
+    return true;
+}
+
+// Write to a temporary file and rename it over the old snapshot, so that a
+//  crash or a second copy of QProg never sees half of a snapshot
+bool DeviceDatabase::saveSnapshot(const QString &path, const snapshot_source_t *stamp, bool imported) const
+{
+    snapshot_header_t	header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = sizeof(snapshot_header_t);
+    header.record_size = sizeof(record_t);
+    header.count = devices.size();
+    header.origin = imported ? SNAPSHOT_ORIGIN_IMPORT : SNAPSHOT_ORIGIN_SETTINGS;
+    if( stamp )
+	memcpy(header.sources, stamp, sizeof(header.sources));
+
+    std::vector<record_t>   records(devices.size());
+    for(size_type i=0; i < devices.size(); ++i)
+    {
+	const chipinfo::chipinfo &chip_info = devices[i];
+	record_t &r = records[i];
+	memset(&r, 0, sizeof(r));
+	if( chip_info.name.size() >= sizeof(r.name) )
+	    return false;	// Too long to store
+	memcpy(r.name, chip_info.name.data(), chip_info.name.size());
+	if( chip_info.stamp.size() < sizeof(r.stamp) )	// Otherwise the device always looks changed
+	    memcpy(r.stamp, chip_info.stamp.data(), chip_info.stamp.size());
+	r.chip_id = chip_info.chip_id;
+	r.rom_size = chip_info.rom_size;
+	r.eeprom_size = chip_info.eeprom_size;
+	r.num_config_words = chip_info.num_config_words;
+	memcpy(r.fuse_blanks, chip_info.fuse_blanks, sizeof(r.fuse_blanks));
+	r.rom_blank = chip_info.rom_blank;
+	r.program_delay = chip_info.program_delay;
+	r.erase_mode = chip_info.erase_mode;
+	r.power_sequence = chip_info.power_sequence;
+	r.program_tries = chip_info.program_tries;
+	r.core_type = chip_info.core_type;
+	r.over_program = chip_info.over_program;
+	r.flags = (chip_info.cal_word ? RECORD_CAL_WORD : 0)
+		| (chip_info.band_gap ? RECORD_BAND_GAP : 0)
+		| (chip_info.fast_power ? RECORD_FAST_POWER : 0)
+		| (chip_info.single_panel ? RECORD_SINGLE_PANEL : 0);
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    const QString temp_path(path + ".tmp");
+    {
+	QFile	file(temp_path);
+	if( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+	    return false;
+	const qint64 records_size = records.size()*sizeof(record_t);
+	if( (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != (qint64)sizeof(header))
+	    || (records_size && (file.write(reinterpret_cast<const char*>(&records[0]), records_size) != records_size)) )
+	{
+	    file.close();
+	    QFile::remove(temp_path);
+	    return false;
+	}
+    }
+
+    // QFile::rename() won't replace an existing file, but rename(2) does it
+    //	atomically. Windows' rename() won't either, MoveFileEx() has to be asked to.
+#ifdef	Q_WS_WIN
+    if( !MoveFileExW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(temp_path).utf16()),
+		     reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(path).utf16()),
+		     MOVEFILE_REPLACE_EXISTING) )
+#else
+    if( ::rename(QFile::encodeName(temp_path).constData(), QFile::encodeName(path).constData()) != 0 )
+#endif	//Q_WS_WIN
+    {
+	QFile::remove(temp_path);
+	return false;
+    }
+    return true;
+}
+
+// Parse a decimal number that makes up all of [p, end)
+static bool parse_index(const char *p, const char *end, unsigned &n)
+{
+    if( p == end )
+	return false;
+    for(n=0; p < end; ++p)
+    {
+	if( (*p < '0') || (*p > '9') )
+	    return false;
+	n = n*10 + (*p - '0');
+    }
+    return true;
+}
+
+bool DeviceInfoParser::feed(const char *data, size_t length)
+{
+    if( failed )
+	return false;
+
+    const char *p = data;
+    const char *const end = data + length;
+
+    // Finish the line that was split by the last chunk
+    if( !partial.empty() )
+    {
+	const char *const eol = static_cast<const char*>(memchr(p, '\n', end - p));
+	if( !eol )
+	{
+	    partial.append(p, length);
+	    return true;
+	}
+	partial.append(p, eol - p);
+	if( !parse_line(partial.data(), partial.data() + partial.size()) )
+	    return false;
+	partial.clear();
+	p = eol + 1;
+    }
+
+    while( p < end )
+    {
+	const char *const eol = static_cast<const char*>(memchr(p, '\n', end - p));
+	if( !eol )
+	{
+	    partial.assign(p, end - p);	// Save it for the next chunk
+	    break;
+	}
+	if( !parse_line(p, eol) )
+	    return false;
+	p = eol + 1;
+    }
+    return true;
+}
+
+bool DeviceInfoParser::finish()
+{
+    if( failed )
+	return false;
+
+    // The last line may not have had a newline
+    if( !partial.empty() )
+    {
+	const bool ok = parse_line(partial.data(), partial.data() + partial.size());
+	partial.clear();
+	if( !ok )
+	    return false;
+    }
+
+    // Every device needs a name, or it can't be selected or found
+    for(devices_type::const_iterator i = parsed.begin(); i != parsed.end(); ++i)
+	if( i->second.name.empty() )
+	    return fail(QString("Device %1 doesn't have a name").arg(i->first));
+    if( parsed.empty() && !delta )	// A delta can be empty if nothing changed
+	return fail("No devices were found");
+    return true;
+}
+
+bool DeviceInfoParser::fail(const QString &message)
+{
+    failed = true;
+    error_string = message;
+    return false;
+}
+
+bool DeviceInfoParser::parse_line(const char *p, const char *eol)
+{
+    static const char prefix[] = "DeviceInfo/";
+    static const char devices_prefix[] = "DeviceInfo/Devices/";
+    static const char deleted_prefix[] = "DeviceInfo/Deleted/";
+    static const char since_key[] = "DeviceInfo/Since";
+    const size_t prefix_length = sizeof(prefix) - 1;
+    const size_t devices_prefix_length = sizeof(devices_prefix) - 1;
+    const size_t deleted_prefix_length = sizeof(deleted_prefix) - 1;
+
+    ++line_number;
+    if( (eol > p) && (eol[-1] == '\r') )
+	--eol;
+    if( eol == p )	// Skip blank lines
+	return true;
+
+    const char *const equals = static_cast<const char*>(memchr(p, '=', eol - p));
+    if( !equals || (equals - p < (ptrdiff_t)prefix_length) || (memcmp(p, prefix, prefix_length) != 0) )
+	return fail(QString("Line %1 isn't device info").arg(line_number));
+
+    // Anything outside of the Devices array (the array size, for instance) isn't needed
+    if( (equals - p > (ptrdiff_t)devices_prefix_length) && (memcmp(p, devices_prefix, devices_prefix_length) == 0) )
+    {
+	const char *const number = p + devices_prefix_length;
+	const char *const slash = static_cast<const char*>(memchr(number, '/', equals - number));
+	unsigned index;
+	if( slash && parse_index(number, slash, index) )
+	{
+	    const char *const key = slash + 1;
+	    const char *const value = equals + 1;
+	    if( (key < equals) && (value < eol) )	// Skip empty keys and values
+		parsed[index].set(key, equals - key, value, eol - value);
+	}
+	else if( !parse_index(number, equals, index) && (std::string(number, equals - number) != "size") )
+	    return fail(QString("Line %1 has a bad device number").arg(line_number));
+    }
+    else if( (equals - p == (ptrdiff_t)(sizeof(since_key) - 1)) && (memcmp(p, since_key, sizeof(since_key) - 1) == 0) )
+	delta = true;
+    else if( (equals - p > (ptrdiff_t)deleted_prefix_length) && (memcmp(p, deleted_prefix, deleted_prefix_length) == 0) )
+    {
+	unsigned index;
+	if( !parse_index(p + deleted_prefix_length, equals, index) )
+	    return fail(QString("Line %1 has a bad device number").arg(line_number));
+	if( equals + 1 < eol )
+	    deleted_names.push_back(std::string(equals + 1, eol));
+    }
+    return true;
+}
+
+// Count the space separated words in [p, end)
+static unsigned count_words(const char *p, const char *end)
+{
+    unsigned n = 0;
+    for(bool space = true; p < end; ++p)
+    {
+	if( space && (*p != ' ') )
+	    ++n;
+	space = (*p == ' ');
+    }
+    return n;
+}
+
+bool DeviceInfoParser::parseCID(const char *data, size_t length)
+{
+    static const char name_key[] = "CHIPname";
+    static const char fuse_blank_key[] = "FUSEblank";
+
+    if( failed )
+	return false;
+
+    chipinfo::chipinfo *device = NULL;
+    unsigned fuse_words = 0;	// Words in the current device's FUSEblank
+    const char *p = data;
+    const char *const end = data + length;
+    while( p < end )
+    {
+	const char *eol = static_cast<const char*>(memchr(p, '\n', end - p));
+	const char *const next = eol ? eol + 1 : end;
+	if( !eol )
+	    eol = end;
+	if( (eol > p) && (eol[-1] == '\r') )
+	    --eol;
+	++line_number;
+
+	// Blank lines, and the LISTn FUSEn lines that describe the config
+	//  bits, have nothing that's needed. The latter have spaces in the key.
+	const char *const equals = static_cast<const char*>(memchr(p, '=', eol - p));
+	if( !equals || (equals == p) || memchr(p, ' ', equals - p) )
+	{
+	    p = next;
+	    continue;
+	}
+
+	const char *const key = p;
+	const size_t key_length = equals - p;
+	const char *const value = equals + 1;
+	const size_t value_length = eol - value;
+	p = next;
+
+	if( (key_length == sizeof(name_key) - 1) && (memcmp(key, name_key, key_length) == 0) )
+	{
+	    // The file doesn't say how many config words there are, but there's a blank value for each one
+	    if( device && !device->num_config_words )
+		device->num_config_words = fuse_words;
+	    device = &parsed[parsed.size()];
+	    fuse_words = 0;
+	}
+	else if( !device )	// Anything before the first device is a file header
+	    continue;
+	else if( (key_length == sizeof(fuse_blank_key) - 1) && (memcmp(key, fuse_blank_key, key_length) == 0) )
+	    fuse_words = count_words(value, eol);
+
+	if( value_length )
+	    device->set(key, key_length, value, value_length);
+    }
+    if( device && !device->num_config_words )
+	device->num_config_words = fuse_words;
+
+    return finish();
+}
+
+bool DeviceDatabase::import(const QString &path, counts_type &counts, QString *error)
+{
+    QFile   file(path);
+    if( !file.open(QIODevice::ReadOnly) )
+    {
+	if( error )
+	    *error = QString("Could not open %1").arg(path);
+	return false;
+    }
+
+    // Parse the file where it's mapped. An empty file can't be mapped, and
+    //	files that can't be for some other reason are read instead.
+    size_t length = file.size();
+    const char *data = length ? reinterpret_cast<const char*>(file.map(0, length)) : NULL;
+    QByteArray	contents;
+    if( !data )
+    {
+	contents = file.readAll();
+	data = contents.constData();
+	length = contents.size();
+    }
+
+    DeviceInfoParser	parser;
+    const bool parsed = (QFileInfo(path).suffix().toLower() == "cid") ? parser.parseCID(data, length)
+								      : (parser.feed(data, length) && parser.finish());
+    if( !parsed )
+    {
+	if( error )
+	    *error = parser.error();
+	return false;
+    }
+    return apply(parser, counts, error);
+}
+
+bool DeviceDatabase::apply(const DeviceInfoParser &parser, counts_type &counts, QString *error)
+{
+    // Work on a copy, so that nothing changes unless the snapshot is written
+    DeviceDatabase  updated(*this);
+    updated.merge(parser, counts);
+    if( !counts.changed() )
+	return true;
+
+    // The snapshot remembers the settings as they are now, so that later
+    //	edits to them can override the import (see load())
+    snapshot_source_t	stamp[NUM_SOURCES];
+    const bool stamped = get_stamp(stamp);
+    const QString path(snapshotPath());
+    if( !updated.saveSnapshot(path, stamped ? stamp : NULL, true) )
+    {
+	if( error )
+	    *error = QString("Could not write %1").arg(path);
+	return false;
+    }
+
+    swap(updated);
+    return true;
+}
+
+void DeviceDatabase::merge(const DeviceInfoParser &parser, counts_type &counts)
+{
+    counts = counts_type();
+
+    // Upserts. A full export marks each device that it has, and the rest get deleted.
+    std::vector<bool>	seen(devices.size(), false);
+    for(DeviceInfoParser::devices_type::const_iterator i = parser.devices().begin(); i != parser.devices().end(); ++i)
+    {
+	const chipinfo::chipinfo &chip_info = i->second;
+	QHash<QString, size_type>::const_iterator j = byName.find(QString(chip_info.name.c_str()));
+	if( j == byName.end() )
+	{
+	    add(chip_info);
+	    seen.push_back(true);
+	    ++counts.inserted;
+	    continue;
+	}
+
+	const size_type index = j.value();
+	if( seen[index] )
+	    continue;		// Duplicate name in the export, and the first one wins
+	seen[index] = true;
+
+	chipinfo::chipinfo &device = devices[index];
+	if( !chip_info.stamp.empty() && (chip_info.stamp == device.stamp) )
+	{
+	    ++counts.unchanged;
+	    continue;
+	}
+
+	if( device.chip_id != chip_info.chip_id )
+	{
+	    byChipID.remove(device.chip_id, index);
+	    if( chip_info.chip_id )
+		byChipID.insert(chip_info.chip_id, index);
+	}
+	device = chip_info;
+	++counts.updated;
+    }
+
+    // Deletes
+    if( parser.isDelta() )
+    {
+	std::fill(seen.begin(), seen.end(), true);
+	for(std::vector<std::string>::const_iterator i = parser.deleted().begin(); i != parser.deleted().end(); ++i)
+	{
+	    QHash<QString, size_type>::const_iterator j = byName.find(QString(i->c_str()));
+	    if( j != byName.end() )
+		seen[j.value()] = false;
+	}
+    }
+
+    size_type kept = 0;
+    for(size_type i=0; i < devices.size(); ++i)
+	if( seen[i] )
+	{
+	    if( kept != i )
+		devices[kept] = devices[i];
+	    ++kept;
+	}
+    counts.deleted = devices.size() - kept;
+    if( counts.deleted )
+    {
+	devices.resize(kept);
+	reindex();		// Everything after the first deleted device moved
+    }
+}
+
+std::string DeviceDatabase::newestStamp() const
+{
+    std::string newest;
+    for(devices_type::const_iterator i = devices.begin(); i != devices.end(); ++i)
+	if( i->stamp > newest )
+	    newest = i->stamp;
+    return newest;
+}
+
+void DeviceDatabase::reindex()
+{
+    byName.clear();
+    byChipID.clear();
+    for(size_type i=0; i < devices.size(); ++i)
+    {
+	byName.insert(QString(devices[i].name.c_str()), i);
+	if( devices[i].chip_id )
+	    byChipID.insert(devices[i].chip_id, i);
+    }
+}
+
+void DeviceDatabase::swap(DeviceDatabase &other)
+{
+    devices.swap(other.devices);
+    qSwap(byName, other.byName);
+    qSwap(byChipID, other.byChipID);
+}
+
+const chipinfo::chipinfo* DeviceDatabase::find(const QString &name) const
+{
+    QHash<QString, size_type>::const_iterator i = byName.find(name);
+    return (i == byName.end()) ? NULL : &devices[i.value()];
+}
+
+QList<const chipinfo::chipinfo*> DeviceDatabase::findChipID(uint16_t chip_id) const
+{
+    QList<const chipinfo::chipinfo*>	result;
+    QMultiHash<uint16_t, size_type>::const_iterator i = byChipID.find(chip_id);
+    for(; (i != byChipID.end()) && (i.key() == chip_id); ++i)
+	result.append(&devices[i.value()]);
+    return result;
+}
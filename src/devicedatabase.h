@@ -0,0 +1,176 @@
+/*  In-memory copy of the device info database
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	DEVICEDATABASE_H
+#define	DEVICEDATABASE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QThread>
+
+#include "chipinfo.h"
+
+class QSettings;
+struct snapshot_source_t;
+
+// Parse a device info export (lines of DeviceInfo/Devices/N/Key=Value) as it
+//  arrives. The chunks passed to feed() can split lines anywhere.
+//
+//  A full export lists every device. An export that has a DeviceInfo/Since
+//  key is a delta: it only has the devices that changed after that time, plus
+//  a DeviceInfo/Deleted/N=Name line for each device that was removed.
+//
+//  It can also parse a chipinfo.cid file from the original programmer
+//  software, which has the same keys but a different layout (see parseCID()).
+class DeviceInfoParser
+{
+public:
+    // Devices by number. The numbers come from the export and needn't be contiguous.
+    typedef std::map<unsigned, chipinfo::chipinfo>	devices_type;
+
+    DeviceInfoParser() : line_number(0), failed(false), delta(false) {}
+
+    // Returns false, and ignores anything else it's given, once a line fails to parse
+    bool    feed(const char *data, size_t length);
+    // Parse whatever's left and check the result. Returns false if it's unusable.
+    bool    finish();
+    // Parse and finish() an entire chipinfo.cid. Each device is a block of
+    //	Key=Value lines that starts with CHIPname, and the file always lists
+    //	every device. The keys and values are handed to chipinfo::set() where
+    //	they sit in the buffer, so the whole file should be mapped rather than
+    //	read a chunk at a time.
+    bool    parseCID(const char *data, size_t length);
+
+    const devices_type&	devices() const { return parsed;	}
+    const std::vector<std::string>& deleted() const { return deleted_names;	}
+    bool    isDelta() const { return delta;	}
+    const QString&  error() const { return error_string;	}
+
+private:
+    devices_type    parsed;
+    std::vector<std::string>	deleted_names;
+    std::string	partial;	// The start of a line that was split between chunks
+    unsigned	line_number;
+    QString	error_string;
+    bool	failed;
+    bool	delta;
+
+    bool    fail(const QString &);
+    bool    parse_line(const char *begin, const char *end);
+};
+
+// The device info lives in QSettings, which is slow to search. DeviceDatabase
+//  reads all of it once into a table of chipinfo records and indexes the
+//  table by name and by chip ID. Call load() again after the settings change.
+//
+//  Walking the settings is still slow with the full database, so the table is
+//  also saved as a binary snapshot next to the settings. The snapshot records
+//  the size and a hash of each settings file that device info can come
+//  from, and load() uses it for as long as none of those have changed.
+//
+//  An export imported with import() doesn't go into the settings at all. It's
+//  written straight to a snapshot that's marked as imported, along with the
+//  state of the settings files at the time. When load() finds that one of
+//  those files has changed since, the devices in that file replace the
+//  imported ones with the same names. On Windows the settings are in the
+//  registry, where changes can't be seen, so an imported snapshot always wins.
+class DeviceDatabase
+{
+public:
+    typedef std::vector<chipinfo::chipinfo>	devices_type;
+    typedef devices_type::size_type		size_type;
+
+    // What apply() did to each device
+    struct counts_type
+    {
+	unsigned    inserted;
+	unsigned    updated;
+	unsigned    deleted;
+	unsigned    unchanged;
+	counts_type() : inserted(0), updated(0), deleted(0), unchanged(0) {}
+	bool	changed() const { return inserted || updated || deleted;	}
+    };
+
+    bool    load();	    // (Re)load from the snapshot, or the settings if the snapshot is stale
+    // Apply an export from the server, or a chipinfo.cid if the file name
+    //	ends in .cid (see DeviceInfoParser). Nothing is changed unless all of
+    //	it is valid, and on failure error is set to the reason.
+    bool    import(const QString &path, counts_type &, QString *error = NULL);
+    // Merge the result of a successful parse into the database. Devices are
+    //	matched by name, and a device with the same CreateTimeStamp as the one
+    //	it matches is left alone. A full export deletes the devices that it
+    //	doesn't have, a delta only deletes the ones that it lists. The
+    //	snapshot is rewritten if anything changed, and the database is left
+    //	alone if that fails.
+    bool    apply(const DeviceInfoParser &, counts_type &, QString *error = NULL);
+    // The newest CreateTimeStamp, for asking the server for a delta
+    std::string	newestStamp() const;
+    // Exchange contents with another database. This is cheap, so a database
+    //	can be built somewhere else and then swapped in all at once.
+    void    swap(DeviceDatabase &);
+
+    bool    empty() const { return devices.empty();	}
+    size_type	size() const { return devices.size();	}
+    const chipinfo::chipinfo&	operator[](size_type i) const { return devices[i];	}
+
+    // Returns NULL if there's no device with the given name
+    const chipinfo::chipinfo*	find(const QString &name) const;
+    // All of the devices with the given chip ID
+    QList<const chipinfo::chipinfo*>	findChipID(uint16_t chip_id) const;
+
+    static QString	snapshotPath();
+
+private:
+    devices_type    devices;
+    QHash<QString, size_type>	byName;
+    QMultiHash<uint16_t, size_type>	byChipID;
+
+    void    clear();
+    void    add(const chipinfo::chipinfo &);
+    void    put(const chipinfo::chipinfo &);
+    void    reindex();
+    void    merge(const DeviceInfoParser &, counts_type &);
+    bool    loadSettings();
+    bool    readSettings(QSettings &, bool replace);
+    void    overlaySettings(const snapshot_source_t *then, const snapshot_source_t *now);
+    // Load a snapshot that's still good for stamp. An imported snapshot is
+    //	always good. For one of those imported is set, and sources is set to
+    //	the stamp that was current when it was written.
+    bool    loadSnapshot(const QString &path, const snapshot_source_t *stamp, bool &imported, snapshot_source_t *sources);
+    bool    saveSnapshot(const QString &path, const snapshot_source_t *stamp, bool imported) const;
+};
+
+// Apply a finished parse to a copy of a database on another thread, and write
+//  its snapshot, so that the GUI only has to swap() the result in afterwards
+class DeviceDatabaseBuilder : public QThread
+{
+public:
+    DeviceDatabaseBuilder(const DeviceDatabase &base, const DeviceInfoParser &p) : database(base), parser(p), success(false) {}
+
+    DeviceDatabase  database;
+    DeviceDatabase::counts_type	counts;
+    QString	error;
+
+    bool    succeeded() const { return success;	}
+
+protected:
+    virtual void run() { success = database.apply(parser, counts, &error);	}
+
+private:
+    const DeviceInfoParser  &parser;
+    bool    success;
+};
+
+extern DeviceDatabase deviceDatabase;
+
+#endif	// DEVICEDATABASE_H
@@ -0,0 +1,186 @@
+/*  Searchable list of the devices in the device database
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <algorithm>
+
+#include <ctype.h>
+
+#include "coretraits.h"
+#include "devicelistmodel.h"
+
+static std::string lower(const std::string &s)
+{
+    std::string result(s);
+    for(std::string::iterator i = result.begin(); i != result.end(); ++i)
+	*i = tolower((unsigned char)*i);
+    return result;
+}
+
+// Pack three characters into an index key
+static uint32_t trigram(const char *p)
+{
+    return ((uint32_t)(uint8_t)p[0] << 16) | ((uint32_t)(uint8_t)p[1] << 8) | (uint8_t)p[2];
+}
+
+static unsigned family_bit(const chipinfo::chipinfo &chip)
+{
+    switch( coretraits::family(chip.core_type) )
+    {
+	case coretraits::CORE10:
+	case coretraits::CORE12:    return DeviceListModel::FAMILY_12BIT;
+	case coretraits::CORE16:    return DeviceListModel::FAMILY_16BIT;
+	default:		    return DeviceListModel::FAMILY_14BIT;
+    }
+}
+
+DeviceListModel::DeviceListModel(QObject *parent) : QAbstractListModel(parent), family_mask(ALL_FAMILIES)
+{
+    reload();
+}
+
+int DeviceListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+QVariant DeviceListModel::data(const QModelIndex &index, int role) const
+{
+    if( !index.isValid() || (index.row() < 0) || ((size_type)index.row() >= rows.size()) )
+	return QVariant();
+
+    // The database may have been swapped out from under the model before reload() was called
+    const size_type i = sorted[rows[index.row()]].second;
+    if( i >= deviceDatabase.size() )
+	return QVariant();
+
+    switch( role )
+    {
+	case Qt::DisplayRole:
+	case Qt::EditRole:
+	    return QString(deviceDatabase[i].name.c_str());
+	case DeviceIndexRole:
+	    return (unsigned)i;
+	default:
+	    return QVariant();
+    }
+}
+
+int DeviceListModel::rowOf(const QString &name) const
+{
+    const std::string key = lower(name.toStdString());
+    const size_type pos = lowerBound(key);
+    if( (pos == sorted.size()) || (sorted[pos].first != key) )
+	return -1;
+
+    rows_type::const_iterator i;
+    if( filter_text.isEmpty() )		// The rows are in order
+    {
+	i = std::lower_bound(rows.begin(), rows.end(), pos);
+	if( (i != rows.end()) && (*i != pos) )
+	    i = rows.end();
+    }
+    else
+	i = std::find(rows.begin(), rows.end(), pos);
+
+    return (i == rows.end()) ? -1 : (int)(i - rows.begin());
+}
+
+// Rebuild the sorted names and the index from deviceDatabase
+void DeviceListModel::reload()
+{
+    beginResetModel();
+
+    sorted.clear();
+    trigrams.clear();
+    sorted.reserve(deviceDatabase.size());
+    for(size_type i=0; i < deviceDatabase.size(); ++i)
+	sorted.push_back(name_type(lower(deviceDatabase[i].name), i));
+    std::sort(sorted.begin(), sorted.end());
+
+    family.resize(sorted.size());
+    for(size_type pos=0; pos < sorted.size(); ++pos)
+    {
+	family[pos] = family_bit(deviceDatabase[sorted[pos].second]);
+
+	const std::string &name = sorted[pos].first;
+	for(size_type j=0; j + 3 <= name.size(); ++j)
+	{
+	    rows_type &postings = trigrams[trigram(name.data() + j)];
+	    if( postings.empty() || (postings.back() != pos) )
+		postings.push_back(pos);
+	}
+    }
+
+    filter();
+    endResetModel();
+}
+
+void DeviceListModel::setFamilies(unsigned mask)
+{
+    if( mask == family_mask )
+	return;
+    beginResetModel();
+    family_mask = mask;
+    filter();
+    endResetModel();
+}
+
+void DeviceListModel::setFilterText(const QString &text)
+{
+    if( text == filter_text )
+	return;
+    beginResetModel();
+    filter_text = text;
+    filter();
+    endResetModel();
+}
+
+void DeviceListModel::filter()
+{
+    rows.clear();
+
+    const std::string needle = lower(filter_text.toStdString());
+    if( needle.empty() )
+    {
+	for(size_type pos=0; pos < sorted.size(); ++pos)
+	    if( family[pos] & family_mask )
+		rows.push_back(pos);
+	return;
+    }
+
+    // The names that start with needle are all together in sorted
+    const size_type first = lowerBound(needle);
+    size_type last = first;
+    for(; (last < sorted.size()) && (sorted[last].first.compare(0, needle.size(), needle) == 0); ++last)
+	if( family[last] & family_mask )
+	    rows.push_back(last);
+
+    // Shorter strings aren't in the index, and would match nearly everything anyway
+    if( needle.size() < 3 )
+	return;
+
+    // A name that contains needle has every sequence in it, so the shortest
+    //	list of names for any one sequence has all of the candidates
+    const rows_type *shortest = NULL;
+    for(size_type j=0; j + 3 <= needle.size(); ++j)
+    {
+	QHash<uint32_t, rows_type>::const_iterator i = trigrams.constFind(trigram(needle.data() + j));
+	if( i == trigrams.constEnd() )
+	    return;
+	if( !shortest || (i.value().size() < shortest->size()) )
+	    shortest = &i.value();
+    }
+
+    for(rows_type::const_iterator i = shortest->begin(); i != shortest->end(); ++i)
+	if( ((*i < first) || (*i >= last)) && (family[*i] & family_mask) && (sorted[*i].first.find(needle) != std::string::npos) )
+	    rows.push_back(*i);
+}
+
+DeviceListModel::size_type DeviceListModel::lowerBound(const std::string &name) const
+{
+    return std::lower_bound(sorted.begin(), sorted.end(), name_type(name, 0)) - sorted.begin();
+}
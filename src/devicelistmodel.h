@@ -0,0 +1,82 @@
+/*  Searchable list of the devices in the device database
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	DEVICELISTMODEL_H
+#define	DEVICELISTMODEL_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QString>
+
+#include "devicedatabase.h"
+
+// A list model over deviceDatabase, sorted by name, that views (the target
+//  combo, a completer) query a row at a time instead of holding an item per
+//  device. Call reload() after the database changes.
+//
+//  The rows can be filtered by core family and by a search string. Devices
+//  whose names start with the search string come first, in name order,
+//  followed by the devices whose names contain it somewhere else. Searches
+//  are case insensitive. Prefix matches are found by binary search on the
+//  sorted names, and the rest with an index of the three character sequences
+//  in each name, so neither has to look at every device.
+class DeviceListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    typedef DeviceDatabase::size_type	size_type;
+
+    // Core families, as bits so that they can be combined
+    enum
+    {
+	FAMILY_12BIT = 1,	// 10Fxxx, 12C50x, 16F57
+	FAMILY_14BIT = 2,
+	FAMILY_16BIT = 4,
+	ALL_FAMILIES = FAMILY_12BIT | FAMILY_14BIT | FAMILY_16BIT
+    };
+
+    // data() returns the device's index in deviceDatabase for this role
+    enum { DeviceIndexRole = Qt::UserRole };
+
+    DeviceListModel(QObject *parent = NULL);
+
+    virtual int	rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual QVariant	data(const QModelIndex &, int role = Qt::DisplayRole) const;
+
+    unsigned	families() const { return family_mask;	}
+    const QString&  filterText() const { return filter_text;	}
+
+    // The row of the device with the given name, ignoring case, or -1 if it
+    //	isn't in the database or is filtered out
+    int	rowOf(const QString &name) const;
+
+public slots:
+    void    reload();
+    void    setFamilies(unsigned);
+    void    setFilterText(const QString &);
+
+private:
+    typedef std::vector<size_type>	rows_type;	// Positions in sorted
+    typedef std::pair<std::string, size_type>	name_type;	// Lower case name and database index
+
+    std::vector<name_type>  sorted;
+    std::vector<unsigned>   family;		// Family bit of each entry in sorted
+    QHash<uint32_t, rows_type>	trigrams;	// Entries in sorted that contain each sequence, in order
+    rows_type	rows;
+
+    unsigned	family_mask;
+    QString	filter_text;
+
+    void    filter();
+    size_type	lowerBound(const std::string &) const;
+};
+
+#endif	// DEVICELISTMODEL_H
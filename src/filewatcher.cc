@@ -0,0 +1,145 @@
+/*  Watch a file for content changes
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+
+#ifdef	Q_OS_LINUX
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif	//Q_OS_LINUX
+
+#include "filewatcher.h"
+
+// Editors tend to save in several steps, so wait for things to settle
+#define	DEFAULT_DELAY	100
+
+FileWatcher::FileWatcher(QObject *parent) : QObject(parent), inotify_fd(-1), notifier(NULL), fallback(NULL)
+{
+    timer.setSingleShot(true);
+    timer.setInterval(DEFAULT_DELAY);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+}
+
+FileWatcher::~FileWatcher()
+{
+    unwatch();
+}
+
+void FileWatcher::watch(const QString &path)
+{
+    const QFileInfo info(path);
+    if( info.absoluteFilePath() == filePath )
+	return;
+    unwatch();
+
+    filePath = info.absoluteFilePath();
+    fileName = info.fileName();
+    digest = hash();
+
+#ifdef	Q_OS_LINUX
+    // Watch the directory rather than the file itself so that the watch
+    //  survives editors that replace the file on save
+    inotify_fd = inotify_init();
+    if( inotify_fd != -1 )
+    {
+	fcntl(inotify_fd, F_SETFL, fcntl(inotify_fd, F_GETFL) | O_NONBLOCK);
+	fcntl(inotify_fd, F_SETFD, FD_CLOEXEC);
+	if( inotify_add_watch(inotify_fd, QFile::encodeName(info.absolutePath()).constData(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY) != -1 )
+	{
+	    notifier = new QSocketNotifier(inotify_fd, QSocketNotifier::Read, this);
+	    connect(notifier, SIGNAL(activated(int)), this, SLOT(onInotifyActivated(int)));
+	    return;
+	}
+	::close(inotify_fd);
+	inotify_fd = -1;
+    }
+#endif	//Q_OS_LINUX
+
+    fallback = new QFileSystemWatcher(this);
+    fallback->addPath(filePath);
+    fallback->addPath(info.absolutePath());
+    connect(fallback, SIGNAL(fileChanged(const QString &)), this, SLOT(onPathChanged(const QString &)));
+    connect(fallback, SIGNAL(directoryChanged(const QString &)), this, SLOT(onPathChanged(const QString &)));
+}
+
+void FileWatcher::unwatch()
+{
+    timer.stop();
+    if( notifier )
+    {
+	delete notifier;
+	notifier = NULL;
+    }
+#ifdef	Q_OS_LINUX
+    if( inotify_fd != -1 )
+    {
+	::close(inotify_fd);
+	inotify_fd = -1;
+    }
+#endif	//Q_OS_LINUX
+    if( fallback )
+    {
+	delete fallback;
+	fallback = NULL;
+    }
+    filePath.clear();
+    fileName.clear();
+    digest.clear();
+}
+
+// Drain the inotify queue and restart the timer if any event was for the watched file
+void FileWatcher::onInotifyActivated(int)
+{
+#ifdef	Q_OS_LINUX
+    char buffer[4096];
+    ssize_t length;
+    const QByteArray name(QFile::encodeName(fileName));
+
+    while( (length = ::read(inotify_fd, buffer, sizeof(buffer))) > 0 )
+    {
+	for(char *p = buffer; p < buffer + length; )
+	{
+	    const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(p);
+	    if( event->len && (name == event->name) )
+		timer.start();
+	    p += sizeof(struct inotify_event) + event->len;
+	}
+    }
+#endif	//Q_OS_LINUX
+}
+
+void FileWatcher::onPathChanged(const QString &)
+{
+    // QFileSystemWatcher drops the file when it's replaced, so put it back
+    if( !fallback->files().contains(filePath) && QFile::exists(filePath) )
+	fallback->addPath(filePath);
+    timer.start();
+}
+
+// The writes have settled, so check if the contents actually changed
+void FileWatcher::onTimeout()
+{
+    const QByteArray h(hash());
+    if( h.isEmpty() || (h == digest) )
+	return;
+    digest = h;
+    emit fileChanged(filePath);
+}
+
+QByteArray FileWatcher::hash()
+{
+    QFile file(filePath);
+    if( !file.open(QIODevice::ReadOnly) )
+	return QByteArray();
+    return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5);
+}
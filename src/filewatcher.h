@@ -0,0 +1,59 @@
+/*  Watch a file for content changes
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	FILEWATCHER_H
+#define	FILEWATCHER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+
+// Emits fileChanged() once an editor or compiler has finished writing to the
+//  watched file, and only if the file's contents actually changed.
+//  On Linux the file's directory is watched with inotify so that editors that
+//  save by writing a new file and renaming it are caught. Everywhere else, or
+//  if inotify isn't available, QFileSystemWatcher is used instead.
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    FileWatcher(QObject *parent = NULL);
+    ~FileWatcher();
+
+    void    watch(const QString &);
+    void    unwatch();
+    // How long to wait for a burst of writes to settle, in milliseconds
+    void    setDelay(int msec)	{ timer.setInterval(msec);	}
+
+    const QString&  path() const    { return filePath;	}
+
+signals:
+    void    fileChanged(const QString &);
+
+private slots:
+    void    onInotifyActivated(int);
+    void    onPathChanged(const QString &);
+    void    onTimeout();
+
+private:
+    QString	filePath;
+    QString	fileName;	// filePath without the leading directory
+    QByteArray	digest;		// Hash of the most recently seen contents
+    QTimer	timer;
+
+    int		inotify_fd;
+    QSocketNotifier*	notifier;
+    QFileSystemWatcher*	fallback;
+
+    QByteArray	hash();
+};
+
+#endif	// FILEWATCHER_H
@@ -0,0 +1,68 @@
+/*  Program the same image into several programmers at once
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <QTime>
+
+#include "gang.h"
+#include "session.h"
+
+namespace gang
+{
+    socket_t::socket_t(const QString &port, const chipinfo::chipinfo &chip, const chipimage::chipimage_t &i, bool e, bool v) : chip_info(chip), image(i), erase(e), verify(v)
+    {
+	result.port = port;
+    }
+
+    void socket_t::run()
+    {
+	QTime	timer;
+	timer.start();
+
+	// The session, and the serial port in it, belong to this thread
+	session::session_t  s(result.port, chip_info);
+	if( !s.open() || !s.write(image, NULL, erase) )
+	    result.error = s.error();
+	else if( !verify )
+	    result.status = RESULT_OK;
+	else
+	{
+	    chipimage::chipimage_t  readback;
+	    if( !s.verify(image, readback, result.changes) )
+		result.error = s.error();
+	    else
+		result.status = result.changes.empty() ? RESULT_OK : RESULT_FAILED;
+	}
+
+	result.elapsed = timer.elapsed();
+    }
+
+    void program(const QStringList &ports, const chipinfo::chipinfo &chip, const chipimage::chipimage_t &image, bool erase, bool verify, std::vector<result_t> &results)
+    {
+	// The copies share image's storage
+	program(ports, chip, std::vector<chipimage::chipimage_t>(ports.size(), image), erase, verify, results);
+    }
+
+    void program(const QStringList &ports, const chipinfo::chipinfo &chip, const std::vector<chipimage::chipimage_t> &images, bool erase, bool verify, std::vector<result_t> &results)
+    {
+	std::vector<socket_t*>	sockets;
+	sockets.reserve(ports.size());
+	for(int i=0; i < ports.size(); ++i)
+	{
+	    sockets.push_back(new socket_t(ports.at(i), chip, images[i], erase, verify));
+	    sockets.back()->start();
+	}
+
+	results.clear();
+	results.reserve(sockets.size());
+	for(std::vector<socket_t*>::iterator i = sockets.begin(); i != sockets.end(); ++i)
+	{
+	    (*i)->wait();
+	    results.push_back((*i)->result);
+	    delete *i;
+	}
+    }
+}
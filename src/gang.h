@@ -0,0 +1,70 @@
+/*  Program the same image into several programmers at once
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	GANG_H
+#define	GANG_H
+
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include "chipimage.h"
+#include "chipinfo.h"
+#include "imagediff.h"
+
+namespace gang
+{
+    enum status_t
+    {
+	RESULT_OK,
+	RESULT_FAILED,	// Programmed, but didn't verify
+	RESULT_ERROR	// Something went wrong before the chip could be checked, see error
+    };
+
+    // What happened in one socket
+    struct result_t
+    {
+	QString	port;
+	status_t    status;
+	QString	error;
+	imagediff::changes_t	changes;    // Blocks that didn't verify
+	int	elapsed;		    // Milliseconds from opening the port to the last step
+	result_t() : status(RESULT_ERROR), elapsed(0) {}
+    };
+
+    // Runs one session on its own thread. The chip info and the image are
+    //	only read, and are shared by every socket, so they have to outlive the
+    //	thread.
+    class socket_t : public QThread
+    {
+    public:
+	socket_t(const QString &port, const chipinfo::chipinfo &, const chipimage::chipimage_t &, bool erase, bool verify);
+
+	result_t    result;
+
+    protected:
+	virtual void run();
+
+    private:
+	const chipinfo::chipinfo    &chip_info;
+	const chipimage::chipimage_t	&image;
+	bool	erase;
+	bool	verify;
+    };
+
+    // Program image into the chip on each port, all at the same time, and
+    //	wait for them to finish. results gets one entry per port, in the same
+    //	order.
+    void program(const QStringList &ports, const chipinfo::chipinfo &, const chipimage::chipimage_t &, bool erase, bool verify, std::vector<result_t> &results);
+    // Like program(), but each port gets its own image (the same image with a
+    //	different serial number, for instance). images has one per port.
+    void program(const QStringList &ports, const chipinfo::chipinfo &, const std::vector<chipimage::chipimage_t> &images, bool erase, bool verify, std::vector<result_t> &results);
+}
+
+#endif	// GANG_H
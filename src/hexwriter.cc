@@ -0,0 +1,176 @@
+/*  Streaming Intel HEX writer
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hexwriter.h"
+
+// Two ASCII hex digits for every byte value
+static const char hex_table[] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+// Intel HEX record types
+#define	RECORD_DATA		0x00
+#define	RECORD_EOF		0x01
+#define	RECORD_EXTENDED_LINEAR	0x04
+
+// The longest record is ":", 4 header bytes, 16 data bytes, a checksum and a newline
+#define	MAX_RECORD_LENGTH	(1 + 2*(4 + 16 + 1) + 1)
+
+namespace hexwriter
+{
+    hexwriter_t::hexwriter_t(std::string *s) : fd(-1), text(s), failed(false), length(0), record_address(0), record_length(0), segment(0) {}
+
+    hexwriter_t::~hexwriter_t()
+    {
+	if( fd != -1 )
+	    ::close(fd);
+    }
+
+    bool hexwriter_t::open(const char *path)
+    {
+	fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	return fd != -1;
+    }
+
+    bool hexwriter_t::finish()
+    {
+	emit_record();
+	format_record(RECORD_EOF, 0, NULL, 0);
+	flush();
+	if( (fd != -1) && (::close(fd) != 0) )
+	    failed = true;
+	fd = -1;
+	return !failed;
+    }
+
+    void hexwriter_t::skip_blank(address_t begin, address_t end, uint16_t blank, unsigned width)
+    {
+	blank_rule rule = {begin, end, blank, width};
+	blanks.push_back(rule);
+    }
+
+    void hexwriter_t::put(address_t address, uint8_t value)
+    {
+	// Start a new record if this byte doesn't belong in the current one
+	if( record_length && ((address != record_address + record_length) || ((address & 0x0F) == 0)) )
+	    emit_record();
+	if( record_length == 0 )
+	    record_address = address;
+	record[record_length++] = value;
+    }
+
+    // A record is blank if it falls inside a blank rule and every word matches
+    //  the rule's blank value
+    bool hexwriter_t::is_blank() const
+    {
+	const address_t end = record_address + record_length;
+	for(std::vector<blank_rule>::const_iterator i = blanks.begin(); i != blanks.end(); ++i)
+	{
+	    if( (record_address < i->begin) || (end > i->end) )
+		continue;
+	    if( (i->width == 2) && (((record_address - i->begin) & 1) || (record_length & 1)) )
+		return false;		// Partial words can't be blank
+	    for(unsigned j=0; j < record_length; j += i->width)
+	    {
+		uint16_t word = record[j];
+		if( i->width == 2 )
+		    word |= record[j+1] << 8;
+		if( word != i->blank )
+		    return false;
+	    }
+	    return true;
+	}
+	return false;
+    }
+
+    void hexwriter_t::emit_record()
+    {
+	if( record_length == 0 )
+	    return;
+
+	if( !is_blank() )
+	{
+	    // Addresses above 64K need an extended linear address record first
+	    const uint16_t upper = record_address >> 16;
+	    if( upper != segment )
+	    {
+		const uint8_t a[2] = {(uint8_t)(upper >> 8), (uint8_t)(upper & 0xFF)};
+		format_record(RECORD_EXTENDED_LINEAR, 0, a, 2);
+		segment = upper;
+	    }
+	    format_record(RECORD_DATA, record_address & 0xFFFF, record, record_length);
+	}
+	record_length = 0;
+    }
+
+    void hexwriter_t::format_record(uint8_t type, uint16_t address, const uint8_t *data, unsigned count)
+    {
+	if( length + MAX_RECORD_LENGTH > sizeof(buffer) )
+	    flush();
+
+	char *p = buffer + length;
+	uint8_t checksum = count + (address >> 8) + (address & 0xFF) + type;
+	*p++ = ':';
+	memcpy(p, hex_table + 2*count, 2);		p += 2;
+	memcpy(p, hex_table + 2*(address >> 8), 2);	p += 2;
+	memcpy(p, hex_table + 2*(address & 0xFF), 2);	p += 2;
+	memcpy(p, hex_table + 2*type, 2);		p += 2;
+	for(unsigned i=0; i < count; ++i, p += 2)
+	{
+	    memcpy(p, hex_table + 2*data[i], 2);
+	    checksum += data[i];
+	}
+	checksum = 0x100 - checksum;
+	memcpy(p, hex_table + 2*checksum, 2);		p += 2;
+	*p++ = '\n';
+	length = p - buffer;
+    }
+
+    void hexwriter_t::flush()
+    {
+	if( text )
+	    text->append(buffer, length);
+	else if( fd != -1 )
+	{
+	    const char *p = buffer;
+	    size_t remaining = length;
+	    while( remaining )
+	    {
+		const ssize_t n = ::write(fd, p, remaining);
+		if( n < 0 )
+		{
+		    if( errno == EINTR )
+			continue;
+		    failed = true;
+		    break;
+		}
+		p += n;
+		remaining -= n;
+	    }
+	}
+	length = 0;
+    }
+}
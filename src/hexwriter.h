@@ -0,0 +1,77 @@
+/*  Streaming Intel HEX writer
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	HEXWRITER_H
+#define	HEXWRITER_H
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace hexwriter
+{
+    // Formats Intel HEX records as bytes arrive, instead of collecting
+    //	everything in a hex_data and writing it out at the end.
+    //	Bytes are grouped into 16 byte records aligned to 16 byte addresses.
+    //	A record is emitted when it fills up, when the next byte isn't
+    //	contiguous, or when finish() is called. Output is buffered and written
+    //	to a file descriptor (or appended to a string) in large chunks.
+    class hexwriter_t
+    {
+    public:
+	typedef	uint32_t	address_t;
+
+	// If text is given, output is appended to it instead of written to a file
+	explicit hexwriter_t(std::string *text = NULL);
+	~hexwriter_t();
+
+	bool	open(const char *path);
+	bool	finish();		// Flush the last record, write EOF and close
+
+	// Records in [begin, end) that consist entirely of blank words are
+	//  dropped. width is the word size in bytes (1 or 2, little-endian)
+	void	skip_blank(address_t begin, address_t end, uint16_t blank, unsigned width);
+
+	void	put(address_t, uint8_t);
+
+    private:
+	struct blank_rule
+	{
+	    address_t	begin;
+	    address_t	end;
+	    uint16_t	blank;
+	    unsigned	width;
+	};
+
+	int	fd;
+	std::string*	text;
+	bool	failed;
+
+	// Output buffer
+	char	buffer[4096];
+	size_t	length;
+
+	// The record being assembled
+	address_t   record_address;	// Address of record[0]
+	uint8_t	record[16];
+	unsigned    record_length;	// Number of bytes in record
+
+	uint16_t    segment;		// Upper 16 bits of the last emitted record's address
+
+	std::vector<blank_rule>	blanks;
+
+	hexwriter_t(const hexwriter_t&);	// No copy
+
+	bool	is_blank() const;
+	void	emit_record();
+	void	format_record(uint8_t type, uint16_t address, const uint8_t *data, unsigned count);
+	void	flush();
+    };
+}
+
+#endif	// HEXWRITER_H
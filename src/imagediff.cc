@@ -0,0 +1,174 @@
+/*  Compare chip images at the granularity the programmer writes them
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <iomanip>
+
+#include <string.h>
+
+#include "imagediff.h"
+
+// Equal spans are skipped this many bytes at a time before looking at
+//  individual blocks. memcmp() is vectorized on every libc worth using, so
+//  big spans keep it in its fast path.
+#define	SPAN_SIZE	256
+
+namespace imagediff
+{
+    static const char *const region_names[chipimage::NUM_REGIONS] = {"ROM", "EEPROM", "ID", "CONFIG"};
+
+    const char* region_name(chipimage::region_t r)
+    {
+	return region_names[r];
+    }
+
+    size_type block_size(chipimage::region_t r)
+    {
+	switch(r)
+	{
+	    case chipimage::ROM:    return 32;
+	    case chipimage::EEPROM: return 2;
+	    default:		    return 2;
+	}
+    }
+
+    // Add a changed block, extending the previous run if it's adjacent
+    static void append(changes_t &changes, chipimage::region_t r, size_type offset, size_type length)
+    {
+	if( !changes.empty() )
+	{
+	    change_t &last = changes.back();
+	    if( (last.region == r) && (last.offset + last.length == offset) )
+	    {
+		last.length += length;
+		return;
+	    }
+	}
+	change_t c = {r, offset, length};
+	changes.push_back(c);
+    }
+
+    void diff(const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, chipimage::region_t r, changes_t &changes)
+    {
+	const size_type size = a.size(r);
+	if( size == 0 )
+	    return;
+
+	if( a.empty() || b.empty() || (a.begin(r) != b.begin(r)) || (size != b.size(r)) )
+	{
+	    append(changes, r, 0, size);
+	    return;
+	}
+
+	const uint8_t *const p = a.data(r);
+	const uint8_t *const q = b.data(r);
+	if( p == q )
+	    return;		// Shared storage is always equal
+
+	const size_type block = block_size(r);
+	for(size_type span=0; span < size; span += SPAN_SIZE)
+	{
+	    const size_type span_end = (span + SPAN_SIZE < size) ? span + SPAN_SIZE : size;
+	    if( memcmp(p + span, q + span, span_end - span) == 0 )
+		continue;
+
+	    // Something in this span changed, so look at each block
+	    for(size_type i=span; i < span_end; i += block)
+	    {
+		const size_type length = (i + block < size) ? block : size - i;
+		if( memcmp(p + i, q + i, length) != 0 )
+		    append(changes, r, i, length);
+	    }
+	}
+    }
+
+    void diff(const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, changes_t &changes)
+    {
+	for(unsigned r=0; r < chipimage::NUM_REGIONS; ++r)
+	    diff(a, b, (chipimage::region_t)r, changes);
+    }
+
+    void diff_config(const chipinfo::chipinfo &chip, const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, changes_t &changes)
+    {
+	const chipimage::region_t r = chipimage::CONFIG;
+	const size_type used = a.used(r);
+	if( used == 0 )
+	    return;
+
+	if( a.empty() || b.empty() || (a.begin(r) != b.begin(r)) || (a.size(r) != b.size(r)) )
+	{
+	    append(changes, r, 0, a.size(r));
+	    return;
+	}
+
+	// Config words are stored low byte first
+	const uint8_t *const p = a.data(r);
+	const uint8_t *const q = b.data(r);
+	for(size_type i=0; (i < used) && (i + 1 < a.size(r)); i += 2)
+	{
+	    const uint16_t mask = chip.configMask(i/2);
+	    const uint16_t x = p[i] | (p[i+1] << 8);
+	    const uint16_t y = q[i] | (q[i+1] << 8);
+	    if( (x ^ y) & mask )
+		append(changes, r, i, 2);
+	}
+    }
+
+    bool sets_bits(const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, chipimage::region_t r)
+    {
+	const size_type size = a.size(r);
+	if( a.empty() || b.empty() || (a.begin(r) != b.begin(r)) || (size != b.size(r)) )
+	    return size != 0;
+
+	const uint8_t *const p = a.data(r);
+	const uint8_t *const q = b.data(r);
+	for(size_type i=0; (p != q) && (i < size); ++i)
+	    if( p[i] & ~q[i] )
+		return true;
+	return false;
+    }
+
+    size_type extent(const changes_t &changes, chipimage::region_t r)
+    {
+	size_type end = 0;
+	for(changes_t::const_iterator i = changes.begin(); i != changes.end(); ++i)
+	    if( (i->region == r) && (i->offset + i->length > end) )
+		end = i->offset + i->length;
+	return end;
+    }
+
+    static void print_bytes(std::ostream &out, const chipimage::chipimage_t &image, const change_t &c)
+    {
+	if( image.empty() || (c.offset + c.length > image.size(c.region)) )
+	{
+	    out << " -";
+	    return;
+	}
+	const uint8_t *const p = image.data(c.region) + c.offset;
+	for(size_type i=0; i < c.length; ++i)
+	    out << ' ' << std::setw(2) << (unsigned)p[i];
+    }
+
+    void print(std::ostream &out, const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, const changes_t &changes)
+    {
+	const std::ios::fmtflags flags = out.flags();
+	const char fill = out.fill('0');
+	out << std::hex << std::uppercase;
+
+	for(changes_t::const_iterator i = changes.begin(); i != changes.end(); ++i)
+	{
+	    out << region_names[i->region] << "\t0x" << std::setw(6) << (a.begin(i->region) + i->offset)
+		<< "\t" << std::dec << i->length << std::hex << "\n\t<";
+	    print_bytes(out, a, *i);
+	    out << "\n\t>";
+	    print_bytes(out, b, *i);
+	    out << "\n";
+	}
+
+	out.fill(fill);
+	out.flags(flags);
+    }
+}
@@ -0,0 +1,58 @@
+/*  Compare chip images at the granularity the programmer writes them
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	IMAGEDIFF_H
+#define	IMAGEDIFF_H
+
+#include <ostream>
+#include <vector>
+
+#include "chipimage.h"
+
+namespace imagediff
+{
+    typedef chipimage::chipimage_t::address_t	address_t;
+    typedef chipimage::chipimage_t::size_type	size_type;
+
+    // A run of changed blocks in one region
+    struct change_t
+    {
+	chipimage::region_t	region;
+	size_type	offset;		// Offset of the first changed block in the region
+	size_type	length;		// A whole number of blocks
+    };
+    typedef std::vector<change_t>	changes_t;
+
+    // Size of the unit that each region is written in: 32 byte ROM blocks
+    //	(as write_rom sends them), EEPROM byte pairs, and single ID and config words
+    size_type	block_size(chipimage::region_t);
+
+    // Append the blocks of a that differ from b to changes, merging adjacent
+    //	blocks into runs. Regions that aren't the same shape in both images are
+    //	reported as entirely changed.
+    void	diff(const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, changes_t &changes);
+    void	diff(const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, chipimage::region_t, changes_t &changes);
+
+    // Append the config words that a sets and that differ from b, comparing
+    //	only the bits that chip implements (see chipinfo::configMask()). Other
+    //	config bits read back as zero whatever a has in them.
+    void	diff_config(const chipinfo::chipinfo &chip, const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, changes_t &changes);
+
+    // True if going from b to a turns on a bit anywhere in region, which flash
+    //	can't do without an erase. Regions that aren't the same shape count.
+    bool	sets_bits(const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, chipimage::region_t);
+
+    // One past the end of the last change in region, or zero if it didn't change
+    size_type	extent(const changes_t &, chipimage::region_t);
+
+    // Human readable report, one run per line, with the bytes from both images
+    void	print(std::ostream &, const chipimage::chipimage_t &a, const chipimage::chipimage_t &b, const changes_t &);
+
+    const char*	region_name(chipimage::region_t);
+}
+
+#endif	// IMAGEDIFF_H
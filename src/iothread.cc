@@ -0,0 +1,339 @@
+/*  A thread of its own for each programmer's port
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifdef	Q_WS_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif	//Q_WS_WIN
+
+#ifdef	Q_OS_LINUX
+#include <sched.h>
+#endif	//Q_OS_LINUX
+
+#include "iothread.h"
+
+#define	IO_CHUNK	256	// Bytes moved between the port and a ring at a time
+#define	IO_RING_SIZE	4096
+
+// Milliseconds
+#define	IO_IDLE_WAIT	100	// The I/O thread sleeps this long when there's nothing to wait for
+#define	IO_POLL_WAIT	1	// How often to look at a port that can't be waited on
+#define	CALLER_WAIT	100	// How often a blocked read() checks that the port still works
+
+namespace transport
+{
+    io_options_t    io_options;
+
+    wakeup_t::wakeup_t() : armed(0)
+    {
+#ifdef	Q_WS_WIN
+	event = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+	// If there's no pipe, wait() just times out every time
+	if( pipe(pipe_fds) == 0 )
+	    for(unsigned i=0; i < 2; ++i)
+	    {
+		fcntl(pipe_fds[i], F_SETFL, fcntl(pipe_fds[i], F_GETFL) | O_NONBLOCK);
+		fcntl(pipe_fds[i], F_SETFD, FD_CLOEXEC);
+	    }
+	else
+	    pipe_fds[0] = pipe_fds[1] = -1;
+#endif	//Q_WS_WIN
+    }
+
+    wakeup_t::~wakeup_t()
+    {
+#ifdef	Q_WS_WIN
+	CloseHandle(event);
+#else
+	if( pipe_fds[0] != -1 )
+	{
+	    ::close(pipe_fds[0]);
+	    ::close(pipe_fds[1]);
+	}
+#endif	//Q_WS_WIN
+    }
+
+    void wakeup_t::wait(int timeout, int fd)
+    {
+#ifdef	Q_WS_WIN
+	WaitForSingleObject(event, timeout);
+#else
+	struct pollfd	fds[2];
+	fds[0].fd = pipe_fds[0];
+	fds[0].events = POLLIN;
+	fds[1].fd = fd;		// poll() skips it if it's -1
+	fds[1].events = POLLIN;
+	poll(fds, 2, timeout);
+
+	// A wake() that comes after this leaves a byte behind, which only
+	//  costs an extra trip around the caller's loop
+	char buffer[16];
+	while( ::read(pipe_fds[0], buffer, sizeof(buffer)) > 0 )
+	    ;
+#endif	//Q_WS_WIN
+	disarm();
+    }
+
+    void wakeup_t::wake()
+    {
+	if( !armed.fetchAndStoreOrdered(0) )
+	    return;
+#ifdef	Q_WS_WIN
+	SetEvent(event);
+#else
+	const char c = 0;
+	if( ::write(pipe_fds[1], &c, 1) < 0 )
+	    return;	// The pipe is full, so it's going to wake up anyway
+#endif	//Q_WS_WIN
+    }
+
+    threaded_t::threaded_t(const QString &p, const io_options_t &options) : port(p), cpu(options.cpu), thread(*this), com(NULL), is_open(false), tx(IO_RING_SIZE), rx(IO_RING_SIZE), commands(4), results(4), failed(0), sent(0)
+    {
+	thread.start(options.priority);
+    }
+
+    threaded_t::~threaded_t()
+    {
+	command(IO_STOP);
+	thread.wait();
+    }
+
+    // Hand a command to the I/O thread and wait for its result. There's
+    //	never more than one in the ring.
+    bool threaded_t::command(command_t c)
+    {
+	send();
+	commands.push(&c, 1);
+	io_wakeup.wake();
+
+	bool result;
+	while( !results.pop(&result, 1) )
+	{
+	    caller_wakeup.arm();
+	    if( !results.empty() )
+	    {
+		caller_wakeup.disarm();
+		continue;
+	    }
+	    caller_wakeup.wait(CALLER_WAIT);
+	}
+	return result;
+    }
+
+    // Give the I/O thread everything that's been written
+    void threaded_t::send()
+    {
+	if( pending.isEmpty() )
+	    return;
+	if( !sent )
+	    sent = now();
+
+	for(int offset = 0; offset < pending.size(); )
+	{
+	    offset += tx.push(pending.constData() + offset, pending.size() - offset);
+	    io_wakeup.wake();
+	    if( failed )
+		break;
+	    if( offset < pending.size() )	// Only for writes bigger than the ring
+		QThread::yieldCurrentThread();
+	}
+	pending.clear();
+    }
+
+    bool threaded_t::open()
+    {
+	pending.clear();
+	char buffer[IO_CHUNK];
+	while( rx.pop(buffer, sizeof(buffer)) )	// Left over from the last time it was open
+	    ;
+	sent = 0;
+	return command(IO_OPEN);
+    }
+
+    void threaded_t::close()
+    {
+	command(IO_CLOSE);
+    }
+
+    bool threaded_t::write(const char *data, size_t length)
+    {
+	pending.append(data, length);
+	return !failed;
+    }
+
+    int threaded_t::read(char *data, size_t length)
+    {
+	send();
+	size_t	count = 0;
+	while( count < length )
+	{
+	    const unsigned n = rx.pop(data + count, length - count);
+	    if( n )
+	    {
+		if( sent )
+		{
+		    round_trip.add(now() - sent);
+		    sent = 0;
+		}
+		count += n;
+		continue;
+	    }
+	    if( failed )
+		break;
+
+	    caller_wakeup.arm();
+	    if( !rx.empty() || failed )
+	    {
+		caller_wakeup.disarm();
+		continue;
+	    }
+	    caller_wakeup.wait(CALLER_WAIT);
+	}
+	return count;
+    }
+
+    int threaded_t::available()
+    {
+	send();
+	return rx.size();
+    }
+
+    bool threaded_t::flush()
+    {
+	send();
+	return !failed;
+    }
+
+    bool threaded_t::set_dtr(bool on)
+    {
+	return command(on ? IO_DTR_ON : IO_DTR_OFF);
+    }
+
+    void threaded_t::fail()
+    {
+	failed = 1;
+	caller_wakeup.wake();
+    }
+
+    bool threaded_t::execute(command_t c)
+    {
+	switch( c )
+	{
+	    case IO_OPEN:
+		if( !com )
+		    com = direct(port);	// Made here so that it belongs to this thread
+		is_open = com && com->open();
+		failed = is_open ? 0 : 1;
+		return is_open;
+	    case IO_CLOSE:
+		if( com && is_open )
+		    com->close();
+		is_open = false;
+		return true;
+	    case IO_DTR_ON:
+	    case IO_DTR_OFF:
+		return is_open && com->set_dtr(c == IO_DTR_ON);
+	    case IO_STOP:
+		delete com;
+		com = NULL;
+		is_open = false;
+		return true;
+	}
+	return false;
+    }
+
+    // Send everything in tx to the programmer. Anything written while the
+    //	port is closed is dropped.
+    void threaded_t::transmit(char *buffer, unsigned size)
+    {
+	bool	wrote = false;
+	unsigned    n;
+	while( (n = tx.pop(buffer, size)) )
+	    if( is_open && !failed )
+	    {
+		if( !com->write(buffer, n) )
+		    fail();
+		wrote = true;
+	    }
+	if( wrote && !com->flush() )
+	    fail();
+    }
+
+    // The I/O thread: move bytes between the port and the rings, and do what
+    //	the commands say, until told to stop
+    void threaded_t::io()
+    {
+#ifdef	Q_OS_LINUX
+	if( cpu >= 0 )
+	{
+	    cpu_set_t	set;
+	    CPU_ZERO(&set);
+	    CPU_SET(cpu, &set);
+	    sched_setaffinity(0, sizeof(set), &set);
+	}
+#endif	//Q_OS_LINUX
+#ifdef	Q_WS_WIN
+	if( cpu >= 0 )
+	    SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+#endif	//Q_WS_WIN
+
+	char	buffer[IO_CHUNK];
+	for(;;)
+	{
+	    transmit(buffer, sizeof(buffer));
+
+	    // Commands come after the bytes that were written before them. The
+	    //	caller hands over those bytes before the command, but they may
+	    //	have arrived after tx was emptied above, so empty it again.
+	    command_t	c;
+	    if( commands.pop(&c, 1) )
+	    {
+		transmit(buffer, sizeof(buffer));
+		const bool result = execute(c);
+		results.push(&result, 1);
+		caller_wakeup.wake();
+		if( c == IO_STOP )
+		    return;
+		continue;
+	    }
+
+	    // Bytes from the programmer
+	    const bool	reading = is_open && !failed && rx.space();
+	    if( reading )
+	    {
+		const int ready = com->available();
+		if( ready > 0 )
+		{
+		    const int got = com->read(buffer, qMin(qMin((unsigned)ready, (unsigned)sizeof(buffer)), rx.space()));
+		    if( got > 0 )
+		    {
+			rx.push(buffer, got);
+			caller_wakeup.wake();
+		    }
+		    else
+			fail();
+		    continue;
+		}
+	    }
+
+	    // Nothing to do until the port or the caller has something
+	    io_wakeup.arm();
+	    if( !tx.empty() || !commands.empty() )
+	    {
+		io_wakeup.disarm();
+		continue;
+	    }
+	    const int fd = reading ? com->descriptor() : -1;
+	    const bool	polling = is_open && !failed && (fd == -1);	// A full ring, or no descriptor
+	    io_wakeup.wait(polling ? IO_POLL_WAIT : IO_IDLE_WAIT, fd);
+	}
+    }
+}
@@ -0,0 +1,131 @@
+/*  A thread of its own for each programmer's port
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	IOTHREAD_H
+#define	IOTHREAD_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+#include <QThread>
+
+#include "ring.h"
+#include "transport.h"
+
+namespace transport
+{
+    // How transport::create() sets up serial ports
+    struct io_options_t
+    {
+	bool	enabled;	// Give each port an I/O thread
+	int	cpu;		// Pin the I/O threads to this CPU, or -1 to let them float
+	QThread::Priority   priority;
+	io_options_t() : enabled(false), cpu(-1), priority(QThread::InheritPriority) {}
+    };
+    extern io_options_t	io_options;
+
+    // Lets a thread sleep until another one has something for it, without a
+    //	lock. The sleeper calls arm(), checks for work one last time, and then
+    //	wait()s. wake() only costs a system call if the other thread is asleep,
+    //	or about to be.
+    class wakeup_t
+    {
+    public:
+	wakeup_t();
+	~wakeup_t();
+
+	void	arm()	    { armed.fetchAndStoreOrdered(1);	}
+	void	disarm()    { armed.fetchAndStoreOrdered(0);	}
+	// Return after a wake(), timeout milliseconds, or when fd (if it isn't
+	//  -1) can be read. Windows doesn't have anything like poll() for
+	//  serial ports, so it's ignored there.
+	void	wait(int timeout, int fd = -1);
+	void	wake();
+
+    private:
+	QAtomicInt  armed;
+#ifdef	Q_WS_WIN
+	void	*event;
+#else
+	int	pipe_fds[2];
+#endif	//Q_WS_WIN
+
+	wakeup_t(const wakeup_t &);	// No copy
+    };
+
+    // A serial port that's only touched by its own thread, so that a protocol
+    //	engine that's busy (or preempted) never delays the bytes, and a
+    //	blocking read never delays the protocol engine. Bytes go back and
+    //	forth through a pair of rings, and open, close and DTR changes go
+    //	through a command ring and come back through a result ring. The
+    //	caller's side of the transport_t interface is unchanged: read() still
+    //	blocks, and writes are still held until the next read().
+    //
+    //	The time from each command to the first byte of its reply, as the
+    //	protocol engine sees it, is kept in latency().
+    class threaded_t : public transport_t
+    {
+    public:
+	threaded_t(const QString &port, const io_options_t &);
+	~threaded_t();
+
+	virtual bool	open();
+	virtual void	close();
+	virtual bool	write(const char *, size_t);
+	virtual int	read(char *, size_t);
+	virtual int	available();
+	virtual bool	flush();
+	virtual bool	set_dtr(bool);
+	virtual const latency_t*    latency() const { return &round_trip;	}
+
+    private:
+	enum command_t { IO_OPEN, IO_CLOSE, IO_DTR_ON, IO_DTR_OFF, IO_STOP };
+
+	class thread_t : public QThread
+	{
+	public:
+	    thread_t(threaded_t &t) : owner(t) {}
+	protected:
+	    virtual void run()	{ owner.io();	}
+	private:
+	    threaded_t	&owner;
+	};
+
+	QString	port;
+	int	cpu;
+	thread_t    thread;
+
+	// Owned by the I/O thread
+	transport_t *com;
+	bool	is_open;
+
+	// Shared
+	ring_t<char>	tx;
+	ring_t<char>	rx;
+	ring_t<command_t>   commands;
+	ring_t<bool>	results;
+	QAtomicInt  failed;	// The port stopped working
+	wakeup_t    io_wakeup;	// For the I/O thread
+	wakeup_t    caller_wakeup;	// For the thread that's using the transport
+
+	// Owned by the caller
+	QByteArray  pending;	// Written, but not yet handed to the I/O thread
+	latency_t   round_trip;
+	double	sent;		// When a command went out that hasn't been answered yet, or 0
+
+	bool	command(command_t);
+	void	send();
+	void	io();
+	void	transmit(char *buffer, unsigned size);
+	bool	execute(command_t);
+	void	fail();
+
+	threaded_t(const threaded_t &);	// No copy
+    };
+}
+
+#endif	// IOTHREAD_H
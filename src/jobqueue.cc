@@ -0,0 +1,254 @@
+/*  Queue of programming jobs for a set of programmers
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <QMetaObject>
+#include <QTime>
+
+#include "imagediff.h"
+#include "jobqueue.h"
+
+JobRunner::JobRunner(const Job &job, const QString &port, QObject *parent) : QThread(parent), succeeded(false), opened(false), incompatible(false), firmware(-1), elapsed(0), running(job), port_name(port), percent(-1), held(false), held_i(0), held_max(0), cancelled(0)
+{
+}
+
+void JobRunner::stage(const char *label)
+{
+    report();
+    current_stage = label;
+    percent = -1;
+    emit progressed(running.id, current_stage, 0, 0);
+}
+
+// The session reports every byte, and each report is an event on another
+//  thread and a line to every watcher, so only whole percents are passed on
+//  as they happen. The rest are held, and the last one goes out when the
+//  stage ends, so that watchers see where it finished.
+bool JobRunner::progress(int i, int max)
+{
+    const int p = (max > 0) ? (int)((qint64)i*100/max) : 0;
+    held = true;
+    held_i = i;
+    held_max = max;
+    if( (p != percent) || (i == max) )
+    {
+	percent = p;
+	report();
+    }
+    return !cancelled;
+}
+
+void JobRunner::report()
+{
+    if( !held )
+	return;
+    held = false;
+    emit progressed(running.id, current_stage, held_i, held_max);
+}
+
+// Verify and say why if it didn't
+bool JobRunner::check(session::session_t &s)
+{
+    chipimage::chipimage_t  readback;
+    imagediff::changes_t    changes;
+    if( !s.verify(running.image, readback, changes) )
+    {
+	error = s.error();
+	return false;
+    }
+    if( !changes.empty() )
+    {
+	error = QString("%1 blocks didn't verify").arg((int)changes.size());
+	return false;
+    }
+    return true;
+}
+
+void JobRunner::run()
+{
+    QTime   timer;
+    timer.start();
+
+    session::session_t	s(port_name, running.chip_info, this);
+    if( !s.open() )
+    {
+	error = s.error();
+	return;
+    }
+    opened = true;
+
+    firmware = s.firmware();
+    if( !Scheduler::supports(firmware, coretraits::family(running.chip_info.core_type)) )
+    {
+	incompatible = true;
+	error = QString("The programmer on %1 can't program a %2").arg(port_name).arg(running.chip_info.name.c_str());
+	return;
+    }
+
+    switch( running.operation )
+    {
+	case Job::OP_ERASE:
+	    succeeded = s.erase();
+	    break;
+	case Job::OP_VERIFY:
+	    succeeded = check(s);
+	    break;
+	default:
+	    succeeded = s.write(running.image, NULL, running.erase) && (!running.verify || check(s));
+	    break;
+    }
+    report();
+    if( !succeeded && error.isEmpty() )
+	error = s.error();
+    elapsed = timer.elapsed();
+}
+
+JobQueue::JobQueue(const QStringList &ports, QObject *parent) : QObject(parent), programmers(ports), scheduler(ports), last_id(0)
+{
+}
+
+JobQueue::~JobQueue()
+{
+    for(QMap<QString, JobRunner*>::iterator i = runners.begin(); i != runners.end(); ++i)
+	i.value()->cancel();
+    for(QMap<QString, JobRunner*>::iterator i = runners.begin(); i != runners.end(); ++i)
+	i.value()->wait();
+}
+
+unsigned JobQueue::submit(const Job &job, QString *error)
+{
+    if( coretraits::family(job.chip_info.core_type) == coretraits::CORE_UNKNOWN )
+    {
+	if( error )
+	    *error = QString("%1 has an unknown core type").arg(job.chip_info.name.c_str());
+	return 0;
+    }
+    if( !scheduler.add(last_id + 1, job.port, coretraits::family(job.chip_info.core_type)) )
+    {
+	if( error )
+	    *error = job.port.isEmpty() ? QString("None of the programmers can run this job") : QString("The programmer on %1 can't run this job").arg(job.port);
+	return 0;
+    }
+
+    Job &queued = jobs[++last_id];
+    queued = job;
+    queued.id = last_id;
+    queued.programmer = QString();
+    queued.state = Job::JOB_QUEUED;
+    queued.error = QString();
+    QMetaObject::invokeMethod(this, "schedule", Qt::QueuedConnection);
+    return last_id;
+}
+
+bool JobQueue::cancel(unsigned id)
+{
+    QMap<unsigned, Job>::iterator i = jobs.find(id);
+    if( (i == jobs.end()) || i.value().finished() )
+	return false;
+
+    if( i.value().state == Job::JOB_RUNNING )
+    {
+	runners.value(i.value().programmer)->cancel();	// onRunnerFinished() does the rest
+	return true;
+    }
+
+    scheduler.remove(id);
+    finish(i.value(), Job::JOB_CANCELLED);
+    return true;
+}
+
+const Job* JobQueue::find(unsigned id) const
+{
+    QMap<unsigned, Job>::const_iterator i = jobs.constFind(id);
+    return (i == jobs.constEnd()) ? NULL : &i.value();
+}
+
+unsigned JobQueue::runningOn(const QString &port) const
+{
+    JobRunner *const runner = runners.value(port);
+    return runner ? runner->job().id : 0;
+}
+
+// Give every idle programmer its next job
+void JobQueue::schedule()
+{
+    for(QStringList::const_iterator i = programmers.begin(); i != programmers.end(); ++i)
+    {
+	if( runners.contains(*i) )
+	    continue;
+	const unsigned id = scheduler.next(*i);
+	if( id )
+	    start(jobs[id], *i);
+    }
+}
+
+void JobQueue::start(Job &job, const QString &port)
+{
+    job.state = Job::JOB_RUNNING;
+    job.programmer = port;
+    JobRunner *const runner = new JobRunner(job, port, this);
+    runners.insert(port, runner);
+    connect(runner, SIGNAL(progressed(unsigned, const QString&, int, int)), this, SIGNAL(jobProgress(unsigned, const QString&, int, int)));
+    connect(runner, SIGNAL(finished()), this, SLOT(onRunnerFinished()));
+    emit jobStarted(job.id);
+    runner->start();
+}
+
+void JobQueue::onRunnerFinished()
+{
+    JobRunner *const runner = qobject_cast<JobRunner*>(sender());
+    if( !runner )
+	return;
+    runners.remove(runner->port());
+    runner->deleteLater();
+
+    std::vector<Scheduler::job_id>  orphans;
+    if( runner->firmware >= 0 )
+	scheduler.setFirmware(runner->port(), runner->firmware, orphans);
+    if( runner->opened )
+	scheduler.finished(runner->port(), runner->incompatible ? -1 : runner->elapsed);
+    else
+	scheduler.failed(runner->port(), orphans);
+
+    Job &job = jobs[runner->job().id];
+    if( runner->succeeded )
+	finish(job, Job::JOB_DONE);
+    else if( runner->wasCancelled() )
+	finish(job, Job::JOB_CANCELLED);
+    else if( (!runner->opened || runner->incompatible) && scheduler.add(job.id, job.port, coretraits::family(job.chip_info.core_type)) )
+    {
+	// Not the job's fault, so try again
+	job.state = Job::JOB_QUEUED;
+	job.programmer = QString();
+	emit jobRequeued(job.id, runner->error);
+    }
+    else
+	finish(job, Job::JOB_FAILED, runner->error);
+
+    for(std::vector<Scheduler::job_id>::const_iterator i = orphans.begin(); i != orphans.end(); ++i)
+	finish(jobs[*i], Job::JOB_FAILED, "None of the programmers can run this job");
+
+    schedule();
+}
+
+void JobQueue::finish(Job &job, Job::state_t state, const QString &error)
+{
+    const unsigned id = job.id;
+    job.state = state;
+    job.error = error;
+    retire(job);
+    emit jobFinished(id);
+}
+
+// Drop the image, which could be large, and forget the oldest finished job
+//  if there are too many
+void JobQueue::retire(Job &job)
+{
+    job.image = chipimage::chipimage_t();
+    history.append(job.id);
+    if( history.size() > JOB_HISTORY )
+	jobs.remove(history.takeFirst());
+}
@@ -0,0 +1,144 @@
+/*  Queue of programming jobs for a set of programmers
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	JOBQUEUE_H
+#define	JOBQUEUE_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include "chipimage.h"
+#include "chipinfo.h"
+#include "scheduler.h"
+#include "session.h"
+
+struct Job
+{
+    enum operation_t { OP_PROGRAM, OP_VERIFY, OP_ERASE };
+    enum state_t { JOB_QUEUED, JOB_RUNNING, JOB_DONE, JOB_FAILED, JOB_CANCELLED };
+
+    unsigned	id;
+    operation_t	operation;
+    QString	port;		// The programmer the job has to run on, or empty for any of them
+    QString	programmer;	// The one that's running it, once it starts
+    chipinfo::chipinfo	chip_info;
+    chipimage::chipimage_t  image;  // Not needed for an erase
+    bool	erase;		// Erase before programming
+    bool	verify;		// Verify after programming
+
+    state_t	state;
+    QString	error;		// Why the job failed
+
+    Job() : id(0), operation(OP_PROGRAM), erase(false), verify(false), state(JOB_QUEUED) {}
+    bool    finished() const { return state > JOB_RUNNING;	}
+};
+
+// Runs one job on its own thread
+class JobRunner : public QThread, private session::progress_t
+{
+    Q_OBJECT
+public:
+    JobRunner(const Job &, const QString &port, QObject *parent = NULL);
+
+    const Job&	job() const { return running;	}
+    const QString&  port() const { return port_name;	}
+    // The job stops at its next progress report
+    void    cancel()	{ cancelled = 1;	}
+    bool    wasCancelled() const { return cancelled;	}
+
+    // Set once the thread has finished
+    bool    succeeded;
+    bool    opened;		// False if the programmer couldn't be opened or reset
+    bool    incompatible;	// The programmer's firmware can't program the part
+    int	    firmware;		// As reported by the programmer, -1 if it wasn't opened
+    int	    elapsed;		// Milliseconds
+    QString error;
+
+signals:
+    void    progressed(unsigned id, const QString &stage, int i, int max);
+
+protected:
+    virtual void run();
+
+private:
+    Job	running;
+    QString port_name;
+    QString current_stage;
+    int	    percent;	    // Of current_stage that was last reported
+    bool    held;	    // A progress report hasn't been passed on yet
+    int	    held_i;
+    int	    held_max;
+    QAtomicInt	cancelled;
+
+    virtual void    stage(const char *);
+    virtual bool    progress(int, int);
+    void    report();
+    bool    check(session::session_t &);
+};
+
+// Jobs are handed to the programmers by a Scheduler, and each programmer runs
+//  one job at a time, on a thread of its own. A job that couldn't run because
+//  its programmer didn't respond, or turned out to have firmware that can't
+//  program the part, is given back to the scheduler to try again somewhere
+//  else, or on the same programmer if it has to run there. Everything else
+//  happens on the queue's
+//  thread, and the runners report back to it with queued signals. Jobs are
+//  only started from the event loop, so whoever submits a job can connect to
+//  it before anything happens to it.
+class JobQueue : public QObject
+{
+    Q_OBJECT
+public:
+    JobQueue(const QStringList &ports, QObject *parent = NULL);
+    ~JobQueue();	// Cancels the running jobs and waits for them
+
+    // Queue a job and return its ID, which is never 0. Returns 0, and sets
+    //	error, if none of the programmers can run it.
+    unsigned	submit(const Job &, QString *error = NULL);
+    // Returns false if the job doesn't exist or has already finished
+    bool    cancel(unsigned id);
+
+    // Returns NULL once a job has been forgotten. The most recent
+    //	JOB_HISTORY finished jobs are kept.
+    const Job*	find(unsigned id) const;
+    const QStringList&	ports() const { return programmers;	}
+    // Each programmer's state, firmware, queue and speed, in the same order as ports()
+    const Scheduler::programmers_type&	programmerStats() const { return scheduler.programmers();	}
+    // The job a programmer is running, or 0 if it's idle
+    unsigned	runningOn(const QString &port) const;
+
+signals:
+    void    jobStarted(unsigned id);
+    void    jobRequeued(unsigned id, const QString &reason);
+    void    jobProgress(unsigned id, const QString &stage, int i, int max);
+    void    jobFinished(unsigned id);
+
+private slots:
+    void    onRunnerFinished();
+    void    schedule();
+
+private:
+    QStringList	programmers;
+    QMap<unsigned, Job>	jobs;
+    Scheduler	scheduler;
+    QList<unsigned> history;	// Finished jobs, oldest first
+    QMap<QString, JobRunner*>	runners;    // By port
+    unsigned	last_id;
+
+    void    start(Job &, const QString &port);
+    void    retire(Job &);
+    void    finish(Job &, Job::state_t, const QString &error = QString());
+};
+
+#define	JOB_HISTORY	1000
+
+#endif	// JOBQUEUE_H
@@ -0,0 +1,250 @@
+/*  Accept programming jobs from other programs over a local socket
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <QLocalSocket>
+
+#include "binimage.h"
+#include "devicedatabase.h"
+#include "jobserver.h"
+
+// Longest request line, in bytes. A client that sends more without a newline is dropped.
+#define	MAX_REQUEST	4096
+
+typedef QMap<QByteArray, QByteArray>	args_type;
+
+static const char *const state_names[] = {"queued", "running", "done", "failed", "cancelled"};
+
+static QByteArray encode(const QString &s)
+{
+    return s.toUtf8().toPercentEncoding();
+}
+
+static QString decode(const QByteArray &s)
+{
+    return QString::fromUtf8(QByteArray::fromPercentEncoding(s));
+}
+
+static QByteArray error_reply(const QString &message)
+{
+    return "error message=" + encode(message);
+}
+
+JobServer::JobServer(JobQueue &q, QObject *parent) : QObject(parent), queue(q)
+{
+    connect(&server, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+    connect(&queue, SIGNAL(jobStarted(unsigned)), this, SLOT(onJobStarted(unsigned)));
+    connect(&queue, SIGNAL(jobRequeued(unsigned, const QString&)), this, SLOT(onJobRequeued(unsigned, const QString&)));
+    connect(&queue, SIGNAL(jobProgress(unsigned, const QString&, int, int)), this, SLOT(onJobProgress(unsigned, const QString&, int, int)));
+    connect(&queue, SIGNAL(jobFinished(unsigned)), this, SLOT(onJobFinished(unsigned)));
+}
+
+bool JobServer::listen(const QString &name)
+{
+    if( server.listen(name) )
+	return true;
+
+    // Don't take the name away from a server that's still running
+    QLocalSocket    probe;
+    probe.connectToServer(name);
+    if( probe.waitForConnected(1000) )
+	return false;
+
+    QLocalServer::removeServer(name);
+    return server.listen(name);
+}
+
+void JobServer::onNewConnection()
+{
+    QLocalSocket *client;
+    while( (client = server.nextPendingConnection()) )
+    {
+	connect(client, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+	connect(client, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+    }
+}
+
+void JobServer::onReadyRead()
+{
+    QLocalSocket *const client = qobject_cast<QLocalSocket*>(sender());
+    if( !client )
+	return;
+
+    while( client->canReadLine() )
+	client->write(handle(client, client->readLine()) + '\n');
+
+    if( client->bytesAvailable() > MAX_REQUEST )
+    {
+	client->write(error_reply("Request too long") + '\n');
+	client->disconnectFromServer();
+    }
+}
+
+void JobServer::onDisconnected()
+{
+    QLocalSocket *const client = qobject_cast<QLocalSocket*>(sender());
+    if( !client )
+	return;
+
+    for(QMultiHash<unsigned, QLocalSocket*>::iterator i = watchers.begin(); i != watchers.end();)
+    {
+	if( i.value() == client )
+	    i = watchers.erase(i);
+	else
+	    ++i;
+    }
+    client->deleteLater();
+}
+
+QByteArray JobServer::handle(QLocalSocket *client, const QByteArray &line)
+{
+    QList<QByteArray>	words = line.simplified().split(' ');
+    const QByteArray	command = words.takeFirst();
+    if( command.isEmpty() )
+	return error_reply("Empty request");
+
+    args_type	args;
+    for(QList<QByteArray>::const_iterator i = words.begin(); i != words.end(); ++i)
+    {
+	const int equals = i->indexOf('=');
+	if( equals <= 0 )
+	    return error_reply(QString("Bad argument %1").arg(decode(*i)));
+	args.insert(i->left(equals), i->mid(equals + 1));
+    }
+
+    if( command == "submit" )
+	return submit(client, args);
+
+    if( command == "programmers" )
+    {
+	const Scheduler::programmers_type &programmers = queue.programmerStats();
+	QByteArray  reply = "ok count=" + QByteArray::number((int)programmers.size());
+	for(unsigned i=0; i < programmers.size(); ++i)
+	{
+	    const Scheduler::programmer_t &p = programmers[i];
+	    const QByteArray n = QByteArray::number(i);
+	    reply += " port." + n + "=" + encode(p.port);
+	    reply += " state." + n + "=" + (p.faulted ? "faulted" : (p.busy ? "busy" : "idle"));
+	    reply += " job." + n + "=" + QByteArray::number(queue.runningOn(p.port));
+	    reply += " firmware." + n + "=" + QByteArray::number(p.firmware);
+	    reply += " queued." + n + "=" + QByteArray::number((int)p.queue.size());
+	    reply += " done." + n + "=" + QByteArray::number(p.completed);
+	    reply += " ms." + n + "=" + QByteArray::number((int)p.average_ms);
+	}
+	return reply;
+    }
+
+    if( (command != "status") && (command != "cancel") && (command != "watch") )
+	return error_reply(QString("Unknown command %1").arg(decode(command)));
+
+    bool valid;
+    const unsigned id = args.value("id").toUInt(&valid);
+    const Job *const job = valid ? queue.find(id) : NULL;
+    if( !job )
+	return error_reply(QString("No job %1").arg(decode(args.value("id"))));
+
+    const QByteArray ok = "ok id=" + QByteArray::number(id);
+    if( command == "status" )
+    {
+	QByteArray  reply = ok + " state=" + state_names[job->state];
+	if( !job->programmer.isEmpty() )
+	    reply += " port=" + encode(job->programmer);
+	if( !job->error.isEmpty() )
+	    reply += " error=" + encode(job->error);
+	return reply;
+    }
+    if( command == "cancel" )
+	return queue.cancel(id) ? ok : error_reply(QString("Job %1 has already finished").arg(id));
+
+    if( !job->finished() )
+	watch(client, id);
+    return ok;
+}
+
+QByteArray JobServer::submit(QLocalSocket *client, const args_type &args)
+{
+    Job	job;
+
+    const QString target = decode(args.value("target"));
+    const chipinfo::chipinfo *const chip = deviceDatabase.find(target);
+    if( !chip )
+	return error_reply(QString("Unknown target %1").arg(target));
+    job.chip_info = *chip;
+
+    const QByteArray op = args.value("op", "program");
+    if( op == "program" )
+	job.operation = Job::OP_PROGRAM;
+    else if( op == "verify" )
+	job.operation = Job::OP_VERIFY;
+    else if( op == "erase" )
+	job.operation = Job::OP_ERASE;
+    else
+	return error_reply(QString("Unknown operation %1").arg(decode(op)));
+
+    job.port = decode(args.value("port"));
+    if( !job.port.isEmpty() && !queue.ports().contains(job.port) )
+	return error_reply(QString("Unknown programmer %1").arg(job.port));
+    job.erase = (args.value("erase") == "1");
+    job.verify = (args.value("verify") == "1");
+
+    if( job.operation != Job::OP_ERASE )
+    {
+	const QString file = decode(args.value("file"));
+	QString	error;
+	if( file.isEmpty() )
+	    return error_reply("No file");
+	if( !binimage::load_file(file, job.chip_info, job.image, &error) )
+	    return error_reply(error);
+    }
+
+    QString error;
+    const unsigned id = queue.submit(job, &error);
+    if( !id )
+	return error_reply(error);
+    watch(client, id);
+    return "ok id=" + QByteArray::number(id);
+}
+
+void JobServer::watch(QLocalSocket *client, unsigned id)
+{
+    if( !watchers.contains(id, client) )
+	watchers.insert(id, client);
+}
+
+void JobServer::notify(unsigned id, const QByteArray &event)
+{
+    const QByteArray line = "event id=" + QByteArray::number(id) + " " + event + '\n';
+    for(QMultiHash<unsigned, QLocalSocket*>::const_iterator i = watchers.constFind(id); (i != watchers.constEnd()) && (i.key() == id); ++i)
+	i.value()->write(line);
+}
+
+void JobServer::onJobStarted(unsigned id)
+{
+    notify(id, "state=running port=" + encode(queue.find(id)->programmer));
+}
+
+void JobServer::onJobRequeued(unsigned id, const QString &reason)
+{
+    notify(id, "state=queued error=" + encode(reason));
+}
+
+void JobServer::onJobProgress(unsigned id, const QString &stage, int i, int max)
+{
+    notify(id, "stage=" + encode(stage) + " progress=" + QByteArray::number(i) + "/" + QByteArray::number(max));
+}
+
+void JobServer::onJobFinished(unsigned id)
+{
+    const Job *const job = queue.find(id);
+    if( job )
+    {
+	QByteArray  event = QByteArray("state=") + state_names[job->state];
+	if( !job->error.isEmpty() )
+	    event += " error=" + encode(job->error);
+	notify(id, event);
+    }
+    watchers.remove(id);
+}
@@ -0,0 +1,85 @@
+/*  Accept programming jobs from other programs over a local socket
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	JOBSERVER_H
+#define	JOBSERVER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QLocalServer>
+#include <QMap>
+#include <QMultiHash>
+#include <QObject>
+#include <QString>
+
+#include "jobqueue.h"
+
+class QLocalSocket;
+
+// Serves a JobQueue on a local socket (a UNIX domain socket, or a named pipe
+//  on Windows). Any number of clients can be connected at once.
+//
+//  Each request is one line of space separated words: a command followed by
+//  key=value arguments. Values are percent encoded, so they can contain
+//  spaces. The reply is one line that starts with "ok" or "error", also
+//  followed by key=value pairs. An error has message=.
+//
+//	submit target=<part> [op=program|verify|erase] [file=<path>] [port=<port>] [erase=1] [verify=1]
+//	    ok id=<id>. The file is loaded when the job is submitted, and it
+//	    isn't needed for erase. Without port= the scheduler picks the
+//	    programmer.
+//	status id=<id>
+//	    ok id=<id> state=queued|running|done|failed|cancelled [port=<port>] [error=<why>]
+//	cancel id=<id>
+//	    ok id=<id>
+//	watch id=<id>
+//	    ok id=<id>
+//	programmers
+//	    ok count=<n>, then for each programmer N from 0:
+//	    port.N=<port> state.N=idle|busy|faulted job.N=<id, 0 if idle>
+//	    firmware.N=<KIT_ value, -1 until known> queued.N=<jobs waiting>
+//	    done.N=<jobs finished> ms.N=<average milliseconds per job>
+//
+//  A client is sent event lines, which can come between any request and its
+//  reply, for the jobs it submitted or asked to watch:
+//
+//	event id=<id> state=running port=<port>
+//	event id=<id> state=queued error=<why>	    (to be tried again)
+//	event id=<id> stage=<what> progress=<i>/<max>
+//	event id=<id> state=done|failed|cancelled [error=<why>]
+class JobServer : public QObject
+{
+    Q_OBJECT
+public:
+    JobServer(JobQueue &, QObject *parent = NULL);
+
+    // Replaces a socket left behind by a server that didn't shut down cleanly
+    bool    listen(const QString &name);
+    QString errorString() const { return server.errorString();	}
+    QString fullServerName() const { return server.fullServerName();	}
+
+private slots:
+    void    onNewConnection();
+    void    onReadyRead();
+    void    onDisconnected();
+    void    onJobStarted(unsigned id);
+    void    onJobRequeued(unsigned id, const QString &reason);
+    void    onJobProgress(unsigned id, const QString &stage, int i, int max);
+    void    onJobFinished(unsigned id);
+
+private:
+    JobQueue	&queue;
+    QLocalServer    server;
+    QMultiHash<unsigned, QLocalSocket*>	watchers;   // Clients watching each job
+
+    QByteArray	handle(QLocalSocket *, const QByteArray &line);
+    QByteArray	submit(QLocalSocket *, const QMap<QByteArray, QByteArray> &args);
+    void    watch(QLocalSocket *, unsigned id);
+    void    notify(unsigned id, const QByteArray &event);
+};
+
+#endif	// JOBSERVER_H
@@ -7,6 +7,12 @@
 #include <fcntl.h>
 #include <iostream>
 
+#ifdef	Q_WS_WIN
+#include <windows.h>
+#endif
+
+#include <QTime>
+
 #include "kitsrus.h"
 #include "intelhex.h"
 
@@ -27,6 +33,19 @@ namespace kitsrus
     #define	LOBYTE(a)	(uint8_t)(a&0x00FF)
 #endif	//Q_WS_WIN
 
+    // Call the instantiation of a kernel for the target's core family
+    //	args is the parenthesized argument list. A part with an unknown core
+    //	type can't be read or written.
+    #define	DISPATCH(kernel, args)						\
+	switch(family)							\
+	{								\
+	    case coretraits::CORE10: return kernel<coretraits::Core10> args;	\
+	    case coretraits::CORE12: return kernel<coretraits::Core12> args;	\
+	    case coretraits::CORE14: return kernel<coretraits::Core14> args;	\
+	    case coretraits::CORE16: return kernel<coretraits::Core16> args;	\
+	    default:		     return false;				\
+	}
+
     // Switch from power-on mode to command mode
     bool kitsrus_t::command_mode()
     {
@@ -50,16 +69,33 @@ namespace kitsrus
 	    return false;
     }
 
-    //Do a hard reset of the device
-    bool kitsrus_t::hard_reset()
+    void msleep(unsigned ms)
     {
-	set_dtr();	//S et DTR high
+#ifdef	Q_WS_WIN
+	Sleep(ms);
+#else
+	usleep(ms*1000);
+#endif
+    }
+
+    // Pulse DTR to reset the programmer
+    bool kitsrus_t::pulse_dtr()
+    {
+	if( !set_dtr() )	//S et DTR high
+	    return false;
 #ifdef	Q_WS_WIN	// Deal with win32 stupidity
 	Sleep(100);
 #else
 	usleep(10);	// Delay
 #endif
-	clear_dtr();	// Set DTR low
+	return clear_dtr();	// Set DTR low
+    }
+
+    //Do a hard reset of the device
+    bool kitsrus_t::hard_reset()
+    {
+	if( !pulse_dtr() )
+	    return false;
 
 	if( read()=='B' )
 	{
@@ -71,6 +107,52 @@ namespace kitsrus
 	    return false;
     }
 
+    // Read without blocking for more than timeout milliseconds in all
+    bool kitsrus_t::read_within(char *data, size_t length, unsigned timeout)
+    {
+	QTime	timer;
+	timer.start();
+	for(size_t i=0; i < length;)
+	{
+	    if( com->available() > 0 )
+	    {
+		if( com->read(data + i, 1) != 1 )
+		    return false;
+		++i;
+	    }
+	    else if( (unsigned)timer.elapsed() >= timeout )
+		return false;
+	    else
+		msleep(PROBE_POLL_INTERVAL);
+	}
+	return true;
+    }
+
+    // The same as hard_reset(), command_mode() and get_protocol(), except
+    //	that each reply is given up on after timeout milliseconds
+    bool kitsrus_t::probe(unsigned timeout, std::string &protocol)
+    {
+	char	reply[4];
+	while( com->available() > 0 )	// Throw away whatever was already there
+	    com->read(reply, 1);
+
+	if( !pulse_dtr() )
+	    return false;
+	if( !read_within(reply, 2, timeout) || (reply[0] != 'B') )
+	    return false;
+	firmware = (uint8_t)reply[1];
+
+	write('P');
+	if( !read_within(reply, 1, timeout) || (reply[0] != 'P') )
+	    return false;
+
+	write(CMD_GET_PROTOCOL);
+	if( !read_within(reply, 4, timeout) )
+	    return false;
+	protocol.assign(reply, 4);
+	return true;
+    }
+
     bool kitsrus_t::init_program_vars()
     {
 	write(CMD_INITVAR);
@@ -124,16 +206,80 @@ namespace kitsrus
 
     bool kitsrus_t::write_rom(intelhex::hex_data &HexData)
     {
-	uint8_t i;
-	intelhex::hex_data::address_t	j(0);
-	uint16_t k;
-	intelhex::hex_data::size_type size;
+	//Figure out how many ROM words need to be written
+	const rom_size_type size = 1 + HexData.max_addr_below((info.rom_size-1)*2);
 
-	// Set the value for device to be programmed
-	HexData.fill(info.get_blank_value());
+	return write_rom(chipimage::chipimage_t(info, HexData), size);
+    }
 
-	//Figure out how many ROM words need to be written
-	size = 1 + HexData.max_addr_below((info.rom_size-1)*2);
+    bool kitsrus_t::write_eeprom(intelhex::hex_data &HexData)
+    {
+	//Figure out how many EEPROM bytes need to be written
+	const eeprom_size_type size = HexData.size_in_range(info.get_eeprom_start(), info.get_eeprom_start() + info.eeprom_size);
+
+	return write_eeprom(chipimage::chipimage_t(info, HexData), size);
+    }
+
+    bool kitsrus_t::write_config(intelhex::hex_data &HexData)
+    {
+	return write_config(chipimage::chipimage_t(info, HexData));
+    }
+
+    // Send a 22 byte config frame (4 ID bytes, 4 'F' bytes, then the config words)
+    bool kitsrus_t::send_config(const std::vector<uint8_t> &tmp_config)
+    {
+	DISPATCH(send_config_kernel, (tmp_config));
+    }
+
+    template<typename Core> bool kitsrus_t::send_config_kernel(const std::vector<uint8_t> &tmp_config)
+    {
+	unsigned i;
+	unsigned progress(0);
+	const unsigned finished(Core::has_fuse ? 50 : 25);
+	write(CMD_WRITE_CONFIG);	// 16F parts
+	write('0');
+	write('0');
+	progress += 3;
+	for( i=0; i<22; ++i, ++progress)
+	{
+	    write(tmp_config[i]);
+	    if( !emit_callback(progress, finished) )	//Emit callback and check for cancellation
+		return false;
+	}
+
+	read();	// Throw away the ack
+
+	if( Core::has_fuse )
+	{
+	    write(CMD_WRITE_FUSE);		// 18F parts
+	    write('0');
+	    write('0');
+	    progress += 3;
+	    for( i=0; i<22; ++i, ++progress)
+	    {
+		write(tmp_config[i]);
+		if( !emit_callback(progress, finished) )	//Emit callback and check for cancellation
+		    return false;
+	    }
+	    read();	//Throw away the ack
+	}
+
+	emit_callback(finished, finished);
+	return true;
+    }
+
+    bool kitsrus_t::write_rom(const chipimage::chipimage_t &image, rom_size_type size)
+    {
+	DISPATCH(write_rom_kernel, (image, size));
+    }
+
+    template<typename Core> bool kitsrus_t::write_rom_kernel(const chipimage::chipimage_t &image, rom_size_type size)
+    {
+	static const uint8_t blank[2] = {LOBYTE(Core::rom_blank), HIBYTE(Core::rom_blank)};
+	const uint8_t *const rom = image.data(chipimage::ROM);
+	const rom_size_type available = image.size(chipimage::ROM);
+	rom_size_type j(0);
+	uint16_t k;
 
 	//Send program rom command
 	write(CMD_WRITE_ROM);
@@ -161,8 +307,9 @@ namespace kitsrus
 		    std::cerr << std::endl;
 		    return false;
 		case 'Y':
-		    for(i=0; i < 32; ++i, ++j)
-			write( HexData.get(j) );
+		    // The last block may run past the end of the image, so pad it with blanks
+		    for(unsigned i=0; i < 32; ++i, ++j)
+			write( (j < available) ? rom[j] : blank[j & 1] );
 		    if( !emit_callback((j>size)?size:j,size) )	//Emit callback and check for cancellation
 			return false;
 		    break;
@@ -174,36 +321,15 @@ namespace kitsrus
 	return true;
     }
 
-//#define	WRITE_EEPROM_DEBUG
-    bool kitsrus_t::write_eeprom(intelhex::hex_data &HexData)
+    bool kitsrus_t::write_eeprom(const chipimage::chipimage_t &image, eeprom_size_type size)
     {
-	intelhex::hex_data::address_t	j(info.get_eeprom_start());
-	intelhex::hex_data::address_t	eeprom_start(info.get_eeprom_start());
-	intelhex::hex_data::address_t	eeprom_end;
-	uint16_t progress(0);
-	intelhex::hex_data::size_type size;
-
-	// Set the value for device to be programmed
-	HexData.fill(0xFF);
-
-	// Ideally we would figure out how many ROM words are going to be written
-	//  and then write only that. But, to make things simpler we'll just write
-	//  to all of the ROM.
-#if defined(WRITE_EEPROM_DEBUG)
-	std::cout << __FUNCTION__ << ": eeprom_start = " << std::hex << j << std::endl;
-	std::cout << __FUNCTION__ << ": eeprom_size = " << std::hex << info.eeprom_size << std::endl;
-#endif
-	size = HexData.size_in_range(j, info.get_eeprom_start() + info.eeprom_size);
+	eeprom_size_type j(0);
+
 	// Make size an even number
 	if( (size % 2) != 0 )
 	    ++size;
-	eeprom_end = j + size - 1;
-#if defined(WRITE_EEPROM_DEBUG)
-	std::cout << __FUNCTION__ << ": size = " << size << std::endl;
-	std::cout << __FUNCTION__ << ": eeprom_end = " << std::hex << eeprom_end << std::endl;
-#endif
 
-	// Send program rom command
+	// Send program eeprom command
 	write(CMD_WRITE_EEPROM);
 	write( (size & 0xFF00) >> 8);  //Send size hi
 	write(size & 0x00FF); //Send size low
@@ -213,22 +339,15 @@ namespace kitsrus
 	    switch(read())
 	    {
 		case 'P':
-		    emit_callback((progress>size)?size:progress,size);
+		    emit_callback((j>size)?size:j,size);
 		    return true;
 		case 'Y':
-		    write(HexData.get(j));
-#if defined(WRITE_EEPROM_DEBUG)
-		    std::cout << __FUNCTION__ << ": wrote " << std::hex << HexData[j] << "\n";
-#endif
+		    write( (j < image.size(chipimage::EEPROM)) ? image.get(chipimage::EEPROM, j) : info.eepromBlank() );
 		    ++j;
-		    write(HexData.get(j));
-#if defined(WRITE_EEPROM_DEBUG)
-		    std::cout << __FUNCTION__ << ": wrote " << std::hex << HexData[j] << "\n";
-#endif
+		    write( (j < image.size(chipimage::EEPROM)) ? image.get(chipimage::EEPROM, j) : info.eepromBlank() );
 		    ++j;
-		    progress = j - eeprom_start;
-		    if( !emit_callback((progress>size)?size:progress,size) )	//Emit callback and check for cancellation
-			    return false;
+		    if( !emit_callback((j>size)?size:j,size) )	//Emit callback and check for cancellation
+			return false;
 		    break;
 		default:
 		    std::cerr << __FUNCTION__ << ": Got unexpected character\n";
@@ -238,88 +357,71 @@ namespace kitsrus
 	return true;
     }
 
-    bool kitsrus_t::write_config(intelhex::hex_data &HexData)
+    bool kitsrus_t::write_config(const chipimage::chipimage_t &image)
     {
 	std::vector<uint8_t> tmp_config(22, 0xFF);
 
-	intelhex::hex_data::address_t	i;
 	// If the ID bits were specified use them
 	//  otherwise use blanks
-	i = info.get_id_start();
-	if( HexData.isset(i) )
-	{
-	    tmp_config[0] = HexData[i++];
-	    tmp_config[1] = HexData[i++];
-	    tmp_config[2] = HexData[i++];
-	    tmp_config[3] = HexData[i];
-	}
+	if( image.used(chipimage::ID) != 0 )
+	    for(unsigned i=0; i < 4; ++i)
+		tmp_config[i] = image.get(chipimage::ID, i);
 	tmp_config[4] = 'F';
 	tmp_config[5] = 'F';
 	tmp_config[6] = 'F';
 	tmp_config[7] = 'F';
 
-	i = info.get_config_start();
-	if( i == 0 )
+	if( image.begin(chipimage::CONFIG) == 0 )
 	    return false;		// Config bits are never at address zero
-	const intelhex::hex_data::address_t end(i + 2*info.numConfigWords());
-	for(unsigned j=8; i < end; ++i, ++j)
-	    tmp_config[j] = HexData[i];
+	for(unsigned i=0; (i < image.size(chipimage::CONFIG)) && (i < 14); ++i)
+	    tmp_config[8+i] = image.get(chipimage::CONFIG, i);
 
-	unsigned progress(0);
-	const unsigned finished(info.is16bit() ? 50 : 25);
-	write(CMD_WRITE_CONFIG);	// 16F parts
-	write('0');
-	write('0');
-	progress += 3;
-	for( i=0; i<22; ++i, ++progress)
-	{
-	    write(tmp_config[i]);
-	    if( !emit_callback(progress, finished) )	//Emit callback and check for cancellation
-		return false;
-	}
+	return send_config(tmp_config);
+    }
 
-	read();	// Throw away the ack
+    void kitsrus_t::write_calibration()
+    {}
 
-	if( info.is16bit() )
-	{
-	    write(CMD_WRITE_FUSE);		// 18F parts
-	    write('0');
-	    write('0');
-	    progress += 3;
-	    for( i=0; i<22; ++i, ++progress)
-	    {
-		write(tmp_config[i]);
-		if( !emit_callback(progress, finished) )	//Emit callback and check for cancellation
-		    return false;
-	    }
-	    read();	//Throw away the ack
-	}
+    // Readback sinks
+    //	The read loops are shared between hex_data and the streaming hex writer
+    static inline void store(intelhex::hex_data &HexData, intelhex::hex_data::address_t address, uint8_t value)
+    {
+	HexData[address] = value;
+    }
 
-	emit_callback(finished, finished);
-	return true;
+    static inline void store(hexwriter::hexwriter_t &writer, intelhex::hex_data::address_t address, uint8_t value)
+    {
+	writer.put(address, value);
     }
 
-    void kitsrus_t::write_calibration()
-    {}
+    static inline void store(chipimage::chipimage_t &image, intelhex::hex_data::address_t address, uint8_t value)
+    {
+	image.put(address, value);
+    }
 
-    //Read from a PIC into a hex_data structure
-    bool kitsrus_t::read_rom(intelhex::hex_data &HexData)
+    //Read from a PIC into a sink
+    template<typename T> bool kitsrus_t::read_rom_into(T &sink)
     {
 	const unsigned length = 2*info.rom_size;
 
 	write(CMD_READ_ROM);
 	for(unsigned i=0; i < length; ++i)
 	{
-	    HexData[i] = read();
+	    store(sink, i, read());
 	    if( !emit_callback(i+1, length) )	//Emit callback and check for cancellation
 		return false;
 	}
 	return true;
     }
 
-    bool kitsrus_t::read_eeprom(intelhex::hex_data &HexData)
+    template<typename T> bool kitsrus_t::read_eeprom_into(T &sink)
     {
-	intelhex::hex_data::address_t i(info.get_eeprom_start());
+	DISPATCH(read_eeprom_kernel, (sink));
+    }
+
+    template<typename Core, typename T> bool kitsrus_t::read_eeprom_kernel(T &sink)
+    {
+	intelhex::hex_data::address_t i(Core::eeprom_start);
 	const intelhex::hex_data::address_t stop(i + info.eeprom_size);
 
 	intelhex::hex_data::address_t j(1);
@@ -327,14 +429,19 @@ namespace kitsrus
 	write(CMD_READ_EEPROM);
 	for(; i<stop; ++i)
 	{
-	    HexData[i] = read();
+	    store(sink, i, read());
 	    if( !emit_callback(j++, info.eeprom_size) )	//Emit callback and check for cancellation
 		return false;
 	}
 	return true;
     }
 
-    bool kitsrus_t::read_config(intelhex::hex_data &HexData)
+    template<typename T> bool kitsrus_t::read_config_into(T &sink)
+    {
+	DISPATCH(read_config_kernel, (sink));
+    }
+
+    template<typename Core, typename T> bool kitsrus_t::read_config_kernel(T &sink)
     {
 	intelhex::value_type a[26];
 	write(CMD_READ_CONFIG);
@@ -351,25 +458,33 @@ namespace kitsrus
 	}
 
 	// Store the config bytes
-	if( info.is12bit() || info.is14bit() )
+	if( Core::reads_id )
 	{
-	    intelhex::hex_data::address_t j(info.get_id_start());
-	    HexData[j++] = a[2];
-	    HexData[j++] = a[3];
-	    HexData[j++] = a[4];
-	    HexData[j++] = a[5];
+	    intelhex::hex_data::address_t j(Core::id_follows_rom ? info.rom_size : Core::id_start);
+	    store(sink, j++, a[2]);
+	    store(sink, j++, a[3]);
+	    store(sink, j++, a[4]);
+	    store(sink, j++, a[5]);
 	}
 
-	intelhex::hex_data::address_t j(info.get_config_start());
-	if( j == 0 )	// Config bits are never at address zero
-	    return false;
+	intelhex::hex_data::address_t j(Core::config_start);
 	const intelhex::hex_data::address_t end(j + 2*info.numConfigWords());
 	for(unsigned i=0x0A; j < end; ++i, ++j)
-	    HexData[j] = a[i];
+	    store(sink, j, a[i]);
 
 	return true;
     }
 
+    bool kitsrus_t::read_rom(intelhex::hex_data &HexData)	{ return read_rom_into(HexData);	}
+    bool kitsrus_t::read_eeprom(intelhex::hex_data &HexData)	{ return read_eeprom_into(HexData);	}
+    bool kitsrus_t::read_config(intelhex::hex_data &HexData)	{ return read_config_into(HexData);	}
+    bool kitsrus_t::read_rom(hexwriter::hexwriter_t &writer)	{ return read_rom_into(writer);	}
+    bool kitsrus_t::read_eeprom(hexwriter::hexwriter_t &writer)	{ return read_eeprom_into(writer);	}
+    bool kitsrus_t::read_config(hexwriter::hexwriter_t &writer)	{ return read_config_into(writer);	}
+    bool kitsrus_t::read_rom(chipimage::chipimage_t &image)	{ return read_rom_into(image);	}
+    bool kitsrus_t::read_eeprom(chipimage::chipimage_t &image)	{ return read_eeprom_into(image);	}
+    bool kitsrus_t::read_config(chipimage::chipimage_t &image)	{ return read_config_into(image);	}
+
     bool kitsrus_t::erase_chip()
     {
 	write(CMD_ERASE);
@@ -394,6 +509,35 @@ namespace kitsrus
 	    return false;
     }
 
+    bool kitsrus_t::start_socket_wait(bool inserted)
+    {
+	write(inserted ? CMD_IN_SOCKET : CMD_NOT_IN_SOCKET);
+	return read() == 'A';
+    }
+
+    // The programmer answers with 'Y' once the socket has changed, so don't
+    //	block on the read until there's something to read
+    int kitsrus_t::poll_socket()
+    {
+	if( com->available() <= 0 )
+	    return 0;
+	return (read() == 'Y') ? 1 : -1;
+    }
+
+    // The config readback starts with the device ID word, low byte first
+    bool kitsrus_t::read_chip_id(uint16_t &id)
+    {
+	write(CMD_READ_CONFIG);
+	if( read() != 'C' )
+	    return false;
+
+	uint8_t a[26];
+	for(unsigned i=0; i<26; ++i)	// The rest has to be read even though it isn't needed
+	    a[i] = read();
+	id = a[0] | (a[1] << 8);
+	return true;
+    }
+
     int kitsrus_t::get_version()
     {
 	if(firmware < 0)
@@ -8,19 +8,28 @@
 #define KITSRUS_H
 
 #include <fstream>
+#include <vector>
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "chipimage.h"
 #include "chipinfo.h"
+#include "coretraits.h"
+#include "hexwriter.h"
 #include "intelhex.h"
 
-#include "qextserialport.h"
+#include "transport.h"
+
+// How often to check for a reply while probing, in milliseconds
+#define	PROBE_POLL_INTERVAL	5
 
 namespace kitsrus
 {
+    void    msleep(unsigned ms);
+
     class kitsrus_t
     {
 	//Kitsrus Commands
@@ -59,8 +68,9 @@ namespace kitsrus
 	#define	KIT_182			0x05
 	#define	KIT_185			0x44
 
-	QextSerialPort	com;	//Serial port interface
+	transport::transport_t	*com;	//Serial port, or a network bridge to one
 	chipinfo::chipinfo	info;
+	coretraits::family_t	family;	// Picks the kernels for info's core type
 
 	int firmware;	//The firmware type of the programmer
 
@@ -75,13 +85,13 @@ namespace kitsrus
 		printf("write 0x%02X\n", (unsigned)c);
 #endif	//DEBUG
 	    char d = c;
-	    return com.write(&d, 1);
+	    return com->write(&d, 1);
 	}
 
 	int16_t	read()
 	{
 	    char c;
-	    if( com.read(&c,1) != 1 )
+	    if( com->read(&c,1) != 1 )
 	    {
 		std::cerr << "read error\n";
 		return -1;
@@ -95,11 +105,24 @@ namespace kitsrus
 	    return c;
 	}
 	//These two are inverted when using a K149
-	void set_dtr()	    { com.setDtr((firmware!=KIT_149A) && (firmware!=KIT_149B));	}
-	void clear_dtr()    { com.setDtr((firmware==KIT_149A) || (firmware==KIT_149B));	}
+	bool set_dtr()	    { return com->set_dtr((firmware!=KIT_149A) && (firmware!=KIT_149B));	}
+	bool clear_dtr()    { return com->set_dtr((firmware==KIT_149A) || (firmware==KIT_149B));	}
+
+	bool	pulse_dtr();
+	bool	read_within(char *, size_t, unsigned timeout);
+	bool	send_config(const std::vector<uint8_t> &);
+	template<typename T> bool read_rom_into(T &);
+	template<typename T> bool read_eeprom_into(T &);
+	template<typename T> bool read_config_into(T &);
+
+	// Kernels instantiated for each core family in coretraits
+	template<typename Core> bool	write_rom_kernel(const chipimage::chipimage_t &, chipinfo::chipinfo::rom_size_type);
+	template<typename Core> bool	send_config_kernel(const std::vector<uint8_t> &);
+	template<typename Core, typename T> bool    read_eeprom_kernel(T &);
+	template<typename Core, typename T> bool    read_config_kernel(T &);
 
 	kitsrus_t(const kitsrus_t&);	//No copy
-	void close()	{ com.close();	}
+	void close()	{ if( com ) com->close();	}
 
 	bool (*callback)(void*,int,int);
 	void* callback_payload;
@@ -116,21 +139,21 @@ public:
 	typedef	chipinfo::chipinfo::eeprom_size_type	eeprom_size_type;
 	typedef	bool(*callback_t)(void*,int,int);
 
-	kitsrus_t(QString &port, chipinfo::chipinfo chip) : com(port), info(chip), firmware(-1), callback(NULL)
-	{
-	    com.setBaudRate(BAUD19200);
-	    com.setDataBits(DATA_8);
-	    com.setParity(PAR_NONE);
-	    com.setStopBits(STOP_1);
-	    com.setFlowControl(FLOW_OFF);
-	    com.setTimeout(0,0);
-	}
-	~kitsrus_t() { close(); }
+	// The port can be anything that transport::create() accepts
+	kitsrus_t(QString &port, chipinfo::chipinfo chip) : com(transport::create(port)), info(chip), family(coretraits::family(chip.core_type)), firmware(-1), callback(NULL) {}
+	// Takes ownership of the transport
+	kitsrus_t(transport::transport_t *t, chipinfo::chipinfo chip) : com(t), info(chip), family(coretraits::family(chip.core_type)), firmware(-1), callback(NULL) {}
+	~kitsrus_t() { close(); delete com; }
 
-	bool	open()	{	return com.open(QIODevice::ReadWrite) ? true : false;	}
+	// False if create() didn't like the port name
+	bool	valid() const	{ return com != NULL;	}
+	bool	open()	{	return com && com->open();	}
 	bool	command_mode();
 	bool	soft_reset();
 	bool	hard_reset();
+	// Is there a programmer on the port? Gives up after timeout milliseconds
+	//  without an answer, and leaves the programmer in command mode.
+	bool	probe(unsigned timeout, std::string &protocol);
 
 	bool	init_program_vars();
 	bool	chip_power_on();
@@ -139,16 +162,32 @@ public:
 	bool	write_rom(intelhex::hex_data &);
 	bool	write_eeprom(intelhex::hex_data &);
 	bool	write_config(intelhex::hex_data &);
+	bool	write_rom(const chipimage::chipimage_t &, rom_size_type);
+	bool	write_eeprom(const chipimage::chipimage_t &, eeprom_size_type);
+	bool	write_config(const chipimage::chipimage_t &);
 	void	write_calibration();
 	bool	read_rom(intelhex::hex_data &);
 	bool	read_eeprom(intelhex::hex_data &);
 	bool	read_config(intelhex::hex_data &);
+	bool	read_rom(hexwriter::hexwriter_t &);
+	bool	read_eeprom(hexwriter::hexwriter_t &);
+	bool	read_config(hexwriter::hexwriter_t &);
+	bool	read_rom(chipimage::chipimage_t &);
+	bool	read_eeprom(chipimage::chipimage_t &);
+	bool	read_config(chipimage::chipimage_t &);
 	bool	erase_chip();
 	void	blank_check_rom();
 	void	blank_check_eeprom();
 	void	write_18F_fuse();
 	bool	detect_chip();
+	// Ask the programmer to say when a chip is put in the socket, or taken
+	//  out, and then call poll_socket() until it does
+	bool	start_socket_wait(bool inserted);
+	int	poll_socket();	// 1 when the socket has changed, 0 if not yet, -1 on error
+	bool	read_chip_id(uint16_t &);	// The device ID word, revision bits included
 	int	get_version();
+	// Command to reply times, if the transport keeps them
+	const transport::latency_t*	latency() const { return com ? com->latency() : NULL;	}
 
 	void set_callback(callback_t f, void *p)	//Function and pointer to pass to function
 	{
@@ -167,6 +206,12 @@ public:
 	rom_size_type	get_rom_size() {return info.rom_size; }
 	eeprom_size_type    get_eeprom_size() {return info.eeprom_size; }
 	uint32_t	get_eeprom_start() {return info.get_eeprom_start(); }
+	// Switch to a different target. Call init_program_vars() afterwards.
+	void	set_chip(const chipinfo::chipinfo &chip)
+	{
+	    info = chip;
+	    family = coretraits::family(chip.core_type);
+	}
 	void	set_149();	//Ugly kludge to work around the K149 reset logic
     };
 
@@ -6,21 +6,478 @@
     Copyright 2005 Brandon Fosdick (BSD License)
 */
 
+#include <iostream>
+
+#include <stdlib.h>
+#include <string.h>
+
 #include<QApplication>
+#include <QFile>
+#include <QSettings>
 
+#include "binimage.h"
+#include "centralwidget.h"
 #include "delegate.h"
+#include "devicedatabase.h"
+#include "gang.h"
+#include "hexwriter.h"
+#include "imagediff.h"
+#include "iothread.h"
+#include "jobqueue.h"
+#include "jobserver.h"
 #include "mainwindow.h"
+#include "portprobe.h"
+#include "portwatcher.h"
+#include "serializer.h"
+#include "session.h"
 
 Delegate delegate;
+DeviceDatabase deviceDatabase;
 
-int main(int argc, char *argv[])
+// These need to be set before QProg is constructed, and before the settings are used
+static void set_application_names()
 {
-    QApplication app(argc, argv);
-
-    // These need to be set before QProg is constructed
     QCoreApplication::setOrganizationName("bfoz.net");
     QCoreApplication::setOrganizationDomain("bfoz.net");
     QCoreApplication::setApplicationName("QProg");
+}
+
+// Serial ports get their own I/O threads if IO/Thread is set, pinned to the
+//  IO/CPU processor if that's set, at IO/Priority (a QThread::Priority)
+static void load_io_options()
+{
+    QSettings	settings;
+    transport::io_options.enabled = settings.value("IO/Thread", false).toBool();
+    transport::io_options.cpu = settings.value("IO/CPU", -1).toInt();
+    transport::io_options.priority = (QThread::Priority)settings.value("IO/Priority", QThread::InheritPriority).toInt();
+}
+
+// qprog diff <target> <file1> <file2>
+//  Compare two images in the blocks that the programmer writes. Like diff(1)
+//  the exit status is 0 if they match, 1 if they don't and 2 on error.
+static int diff_main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    set_application_names();
+
+    if( argc != 5 )
+    {
+	std::cerr << "usage: " << argv[0] << " diff <target> <file1> <file2>\n";
+	return 2;
+    }
+
+    deviceDatabase.load();
+    QString target(argv[2]);
+    chipinfo::chipinfo	chip_info;
+    if( !loadChipInfo(target, chip_info) )
+    {
+	std::cerr << "Unknown target " << argv[2] << "\n";
+	return 2;
+    }
+
+    chipimage::chipimage_t  a, b;
+    QString error;
+    if( !binimage::load_file(QFile::decodeName(argv[3]), chip_info, a, &error) ||
+	!binimage::load_file(QFile::decodeName(argv[4]), chip_info, b, &error) )
+    {
+	std::cerr << error.toStdString() << "\n";
+	return 2;
+    }
+
+    imagediff::changes_t    changes;
+    imagediff::diff(a, b, changes);
+    imagediff::print(std::cout, a, b, changes);
+    return changes.empty() ? 0 : 1;
+}
+
+// Exit status and result= value of each outcome of a command line operation
+#define	CLI_OK		0	// result=ok
+#define	CLI_FAILED	1	// result=fail (didn't verify, isn't blank) or result=mismatch (not the target)
+#define	CLI_ERROR	2	// result=error, and error= says why
+
+static const char *const cli_commands[] = {"program", "read", "verify", "erase", "blank"};
+
+struct cli_options_t
+{
+    QString	port;
+    QString	target;
+    QString	file;
+    bool	erase;		// Erase before programming
+    bool	detect;		// Identify the chip in the socket, and use it as the target if there isn't one
+    std::vector<std::string>	serials;    // serializer_t field specs
+    uint64_t	unit;		// Which serial number this chip gets
+    cli_options_t() : erase(false), detect(false), unit(0) {}
+};
+
+static bool parse_cli_options(int argc, char *argv[], cli_options_t &options)
+{
+    for(int i=2; i < argc; ++i)
+    {
+	if( strcmp(argv[i], "--erase") == 0 )
+	    options.erase = true;
+	else if( strcmp(argv[i], "--detect") == 0 )
+	    options.detect = true;
+	else if( i+1 == argc )
+	    return false;
+	else if( strcmp(argv[i], "--port") == 0 )
+	    options.port = QFile::decodeName(argv[++i]);
+	else if( strcmp(argv[i], "--target") == 0 )
+	    options.target = argv[++i];
+	else if( strcmp(argv[i], "--file") == 0 )
+	    options.file = QFile::decodeName(argv[++i]);
+	else if( strcmp(argv[i], "--serial") == 0 )
+	    options.serials.push_back(argv[++i]);
+	else if( strcmp(argv[i], "--unit") == 0 )
+	    options.unit = strtoull(argv[++i], NULL, 0);
+	else
+	    return false;
+    }
+    return true;
+}
+
+static int cli_error(const QString &message)
+{
+    std::cout << "result=error\nerror=" << message.toStdString() << "\n";
+    return CLI_ERROR;
+}
+
+// Print pass or fail for each region, and the result
+static int cli_report(const imagediff::changes_t &changes, bool config)
+{
+    std::cout << "rom=" << (imagediff::extent(changes, chipimage::ROM) ? "fail" : "pass") << "\n";
+    std::cout << "eeprom=" << (imagediff::extent(changes, chipimage::EEPROM) ? "fail" : "pass") << "\n";
+    if( config )
+	std::cout << "config=" << (imagediff::extent(changes, chipimage::CONFIG) ? "fail" : "pass") << "\n";
+    std::cout << "changes=" << changes.size() << "\n";
+    std::cout << "result=" << (changes.empty() ? "ok" : "fail") << "\n";
+    return changes.empty() ? CLI_OK : CLI_FAILED;
+}
+
+// Command to reply times, and whether they went through an I/O thread, so
+//  that a run without one is a baseline for a run with one
+static void cli_latency(const session::session_t &s)
+{
+    const transport::latency_t *const latency = s.latency();
+    if( !latency || !latency->count )
+	return;
+    const bool threaded = transport::io_options.enabled && !s.port().startsWith(RFC2217_PREFIX);
+    std::cout << "latency.io_thread=" << (threaded ? "yes" : "no") << "\n";
+    std::cout << "latency.count=" << latency->count << "\n";
+    std::cout << "latency.mean_us=" << (int)latency->mean() << "\n";
+    std::cout << "latency.max_us=" << (int)latency->max << "\n";
+    std::cout << "latency.jitter_us=" << (int)latency->jitter() << "\n";
+}
+
+// Set up a serializer for image from --serial options
+static bool load_serializer(const std::vector<std::string> &specs, const chipinfo::chipinfo &chip, const chipimage::chipimage_t &image, serializer::serializer_t &serializer, QString *error)
+{
+    for(std::vector<std::string>::const_iterator i = specs.begin(); i != specs.end(); ++i)
+	if( !serializer.add(*i, error) )
+	    return false;
+    return serializer.bind(chip, image, error);
+}
+
+// qprog program|read|verify|erase|blank --port <port> [--target <part>] [--file <file>] [--erase] [--detect] [--serial <field> ... --unit <n>]
+//  Drive a programmer without a display. Results are printed to stdout as
+//  key=value lines, ending with result=, and the exit status is one of the
+//  CLI_* values. --detect identifies the chip in the socket. It becomes the
+//  target if --target isn't given, otherwise the operation is refused unless
+//  it's the same part. Each --serial option puts a different value into the
+//  image for each chip (see serializer_t), and --unit says which chip this is.
+static int cli_main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    set_application_names();
+
+    const std::string command(argv[1]);
+    const bool needs_file = (command == "program") || (command == "read") || (command == "verify");
+    cli_options_t   options;
+    if( !parse_cli_options(argc, argv, options) || options.port.isEmpty()
+	|| (options.target.isEmpty() && !options.detect) || (needs_file && options.file.isEmpty()) )
+    {
+	std::cerr << "usage: " << argv[0] << " program|read|verify|erase|blank --port <port> [--target <part>] [--file <file>] [--erase] [--detect] [--serial <field> ... --unit <n>]\n";
+	return CLI_ERROR;
+    }
+
+    if( !deviceDatabase.load() || deviceDatabase.empty() )
+	return cli_error("No device info");
+
+    // Detection has to start from some part, and any one will do
+    chipinfo::chipinfo	chip_info = deviceDatabase[0];
+    if( !options.target.isEmpty() && !loadChipInfo(options.target, chip_info) )
+	return cli_error(QString("Unknown target %1").arg(options.target));
+
+    session::session_t	s(options.port, chip_info);
+    if( !s.open() )
+	return cli_error(s.error());
+
+    if( options.detect )
+    {
+	if( !s.detect() )
+	    return cli_error(s.error());
+	std::cout << "detected=" << s.chip().name << "\n";
+	if( !options.target.isEmpty() && (s.chip().name != chip_info.name) )
+	{
+	    std::cout << "result=mismatch\n";
+	    return CLI_FAILED;
+	}
+    }
+    std::cout << "target=" << s.chip().name << "\n";
+
+    if( command == "erase" )
+    {
+	if( !s.erase() )
+	    return cli_error(s.error());
+	std::cout << "result=ok\n";
+	return CLI_OK;
+    }
+
+    chipimage::chipimage_t  readback;
+    imagediff::changes_t    changes;
+    if( command == "blank" )
+	return s.blank_check(readback, changes) ? cli_report(changes, false) : cli_error(s.error());
+
+    if( command == "read" )
+    {
+	const chipinfo::chipinfo &chip = s.chip();
+	hexwriter::hexwriter_t	writer;
+	if( !writer.open(QFile::encodeName(options.file).constData()) )
+	    return cli_error(QString("Could not open %1").arg(options.file));
+	writer.skip_blank(2*chip.romBegin(), 2*chip.romEnd(), chip.romBlank(), 2);
+	writer.skip_blank(chip.eepromBegin(), chip.eepromEnd(), chip.eepromBlank(), 1);
+	const bool read = s.read(writer);
+	if( !writer.finish() || !read )
+	{
+	    QFile::remove(options.file);	// Don't leave a partial file lying around
+	    return cli_error(read ? QString("Could not write %1").arg(options.file) : s.error());
+	}
+	std::cout << "result=ok\n";
+	return CLI_OK;
+    }
+
+    chipimage::chipimage_t  image;
+    QString error;
+    if( !binimage::load_file(options.file, s.chip(), image, &error) )
+	return cli_error(error);
+
+    serializer::serializer_t	serializer;
+    if( !load_serializer(options.serials, s.chip(), image, serializer, &error) || !serializer.patch(options.unit, image, &error) )
+	return cli_error(error);
+    if( !serializer.empty() )
+	std::cout << "serial=" << serializer.label(options.unit) << "\n";
+
+    if( command == "program" )
+    {
+	if( !s.write(image, NULL, options.erase) )
+	    return cli_error(s.error());
+	cli_latency(s);
+	std::cout << "result=ok\n";
+	return CLI_OK;
+    }
+
+    if( !s.verify(image, readback, changes) )
+	return cli_error(s.error());
+    cli_latency(s);
+    return cli_report(changes, true);
+}
+
+// qprog gang --port <port> [--port <port> ...] --target <part> --file <file> [--erase] [--verify] [--serial <field> ... --unit <n>]
+//  Program the same file into the chips on several programmers at once, each
+//  on its own thread. Each socket gets socket.N.* lines, numbered in the order
+//  of the --port options, and result= is the worst of them. With --serial
+//  options socket N gets unit n+N.
+static int gang_main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    set_application_names();
+
+    QStringList	ports;
+    QString	target, file;
+    std::vector<std::string>	serials;
+    uint64_t	unit = 0;
+    bool	erase = false;
+    bool	verify = false;
+    bool	usage = false;
+    for(int i=2; (i < argc) && !usage; ++i)
+    {
+	if( strcmp(argv[i], "--erase") == 0 )
+	    erase = true;
+	else if( strcmp(argv[i], "--verify") == 0 )
+	    verify = true;
+	else if( i+1 == argc )
+	    usage = true;
+	else if( strcmp(argv[i], "--port") == 0 )
+	    ports.append(QFile::decodeName(argv[++i]));
+	else if( strcmp(argv[i], "--target") == 0 )
+	    target = argv[++i];
+	else if( strcmp(argv[i], "--file") == 0 )
+	    file = QFile::decodeName(argv[++i]);
+	else if( strcmp(argv[i], "--serial") == 0 )
+	    serials.push_back(argv[++i]);
+	else if( strcmp(argv[i], "--unit") == 0 )
+	    unit = strtoull(argv[++i], NULL, 0);
+	else
+	    usage = true;
+    }
+    if( usage || ports.isEmpty() || target.isEmpty() || file.isEmpty() )
+    {
+	std::cerr << "usage: " << argv[0] << " gang --port <port> [--port <port> ...] --target <part> --file <file> [--erase] [--verify] [--serial <field> ... --unit <n>]\n";
+	return CLI_ERROR;
+    }
+
+    if( !deviceDatabase.load() )
+	return cli_error("No device info");
+    chipinfo::chipinfo	chip_info;
+    if( !loadChipInfo(target, chip_info) )
+	return cli_error(QString("Unknown target %1").arg(target));
+
+    // Loaded once, and shared by every socket
+    chipimage::chipimage_t  image;
+    QString error;
+    if( !binimage::load_file(file, chip_info, image, &error) )
+	return cli_error(error);
+
+    // Every socket's image shares the loaded one until it's serialized
+    serializer::serializer_t	serializer;
+    if( !load_serializer(serials, chip_info, image, serializer, &error) )
+	return cli_error(error);
+    std::vector<chipimage::chipimage_t>	images(ports.size(), image);
+    for(unsigned i=0; i < images.size(); ++i)
+	if( !serializer.patch(unit + i, images[i], &error) )
+	    return cli_error(error);
+
+    std::vector<gang::result_t>	results;
+    gang::program(ports, chip_info, images, erase, verify, results);
+
+    static const char *const status_names[] = {"ok", "fail", "error"};
+    gang::status_t  worst = gang::RESULT_OK;
+    for(unsigned i=0; i < results.size(); ++i)
+    {
+	const gang::result_t &r = results[i];
+	std::cout << "socket." << i << ".port=" << r.port.toStdString() << "\n";
+	if( !serializer.empty() )
+	    std::cout << "socket." << i << ".serial=" << serializer.label(unit + i) << "\n";
+	std::cout << "socket." << i << ".ms=" << r.elapsed << "\n";
+	if( r.status == gang::RESULT_FAILED )
+	    std::cout << "socket." << i << ".changes=" << r.changes.size() << "\n";
+	std::cout << "socket." << i << ".result=" << status_names[r.status] << "\n";
+	if( r.status == gang::RESULT_ERROR )
+	    std::cout << "socket." << i << ".error=" << r.error.toStdString() << "\n";
+	if( r.status > worst )
+	    worst = r.status;
+    }
+    std::cout << "result=" << status_names[worst] << "\n";
+    return (worst == gang::RESULT_OK) ? CLI_OK : ((worst == gang::RESULT_FAILED) ? CLI_FAILED : CLI_ERROR);
+}
+
+// qprog serve --port <port> [--port <port> ...] [--name <name>]
+//  Run a job server for the given programmers until killed. Other programs
+//  submit jobs to it over a local socket (see JobServer), named "qprog" if
+//  --name isn't given.
+static int serve_main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    set_application_names();
+
+    QStringList	ports;
+    QString	name("qprog");
+    bool	usage = false;
+    for(int i=2; (i < argc) && !usage; ++i)
+    {
+	if( i+1 == argc )
+	    usage = true;
+	else if( strcmp(argv[i], "--port") == 0 )
+	    ports.append(QFile::decodeName(argv[++i]));
+	else if( strcmp(argv[i], "--name") == 0 )
+	    name = QFile::decodeName(argv[++i]);
+	else
+	    usage = true;
+    }
+    if( usage || ports.isEmpty() )
+    {
+	std::cerr << "usage: " << argv[0] << " serve --port <port> [--port <port> ...] [--name <name>]\n";
+	return CLI_ERROR;
+    }
+
+    if( !deviceDatabase.load() )
+	return cli_error("No device info");
+
+    JobQueue	queue(ports);
+    JobServer	server(queue);
+    if( !server.listen(name) )
+	return cli_error(QString("Could not listen on %1: %2").arg(name).arg(server.errorString()));
+    std::cout << "listening=" << server.fullServerName().toStdString() << std::endl;
+    return app.exec();
+}
+
+// qprog probe [--port <port> ...]
+//  Look for programmers on all of the ports at once, or on every serial port
+//  if none are given, and list the ones that answered as port.N=, firmware.N=,
+//  protocol.N= and inverted.N= lines. The exit status is 1 if none answered.
+static int probe_main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    set_application_names();
+
+    QStringList	ports;
+    bool	usage = false;
+    for(int i=2; (i < argc) && !usage; ++i)
+    {
+	if( (i+1 < argc) && (strcmp(argv[i], "--port") == 0) )
+	    ports.append(QFile::decodeName(argv[++i]));
+	else
+	    usage = true;
+    }
+    if( usage )
+    {
+	std::cerr << "usage: " << argv[0] << " probe [--port <port> ...]\n";
+	return CLI_ERROR;
+    }
+
+    // Without any --port options try every port that sysfs knows about
+    if( ports.isEmpty() )
+    {
+	const QList<PortInfo> available = PortWatcher::enumerate();
+	for(QList<PortInfo>::const_iterator i = available.begin(); i != available.end(); ++i)
+	    ports.append(i->path);
+    }
+    if( ports.isEmpty() )
+	return cli_error("No serial ports found");
+
+    std::vector<portprobe::result_t>	found;
+    portprobe::probe(ports, found);
+
+    std::cout << "count=" << found.size() << "\n";
+    for(unsigned i=0; i < found.size(); ++i)
+    {
+	const portprobe::result_t &r = found[i];
+	std::cout << "port." << i << "=" << r.port.toStdString() << "\n";
+	std::cout << "firmware." << i << "=" << r.firmware_name.toStdString() << "\n";
+	std::cout << "protocol." << i << "=" << r.protocol.toStdString() << "\n";
+	std::cout << "inverted." << i << "=" << (r.inverted ? "yes" : "no") << "\n";
+    }
+    return found.empty() ? CLI_FAILED : CLI_OK;
+}
+
+int main(int argc, char *argv[])
+{
+    set_application_names();	// For the settings that load_io_options() reads
+    load_io_options();
+
+    if( (argc > 1) && (strcmp(argv[1], "diff") == 0) )
+	return diff_main(argc, argv);
+    if( (argc > 1) && (strcmp(argv[1], "gang") == 0) )
+	return gang_main(argc, argv);
+    if( (argc > 1) && (strcmp(argv[1], "serve") == 0) )
+	return serve_main(argc, argv);
+    if( (argc > 1) && (strcmp(argv[1], "probe") == 0) )
+	return probe_main(argc, argv);
+    for(unsigned i=0; (argc > 1) && (i < sizeof(cli_commands)/sizeof(cli_commands[0])); ++i)
+	if( strcmp(argv[1], cli_commands[i]) == 0 )
+	    return cli_main(argc, argv);
+
+    QApplication app(argc, argv);
+    set_application_names();
 
     // Post a startup event to the application delegate
     app.postEvent(&delegate, new QEvent((QEvent::Type)Delegate::Startup), Qt::LowEventPriority);
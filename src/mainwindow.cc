@@ -11,10 +11,9 @@
 #include <QFileDialog>
 #include <QMenuBar>
 #include <QMessageBox>
-#include <QSettings>
-#include <QTextStream>
 
 #include "delegate.h"
+#include "devicedatabase.h"
 #include "mainwindow.h"
 #include "centralwidget.h"
 
@@ -37,9 +36,18 @@ MainWindow::MainWindow() : buffer(NULL)
 #endif
 
     QMenu *deviceInfoMenu = menuBar()->addMenu("Device Info");
-    deviceInfoMenu->addAction("Update", this, SLOT(updateDeviceInfo()))->setStatusTip("Update the Device Info");
+    deviceInfoMenu->addAction("Update", &delegate, SLOT(getDeviceInfo()))->setStatusTip("Update the Device Info");
+    connect(&delegate, SIGNAL(deviceInfoUpdated()), this, SLOT(deviceInfoUpdated()));
     deviceInfoMenu->addAction("Update From File", this, SLOT(updateDeviceInfoFromFile()))->setStatusTip("Update the Device Info from a file");
 
+    QMenu *imageMenu = menuBar()->addMenu("Image");
+    imageMenu->addAction("Export Binary Image", central, SLOT(exportBinaryImage()))->setStatusTip("Convert the selected file to a binary image for the selected target");
+    imageMenu->addAction("Export Intel HEX", central, SLOT(exportHex()))->setStatusTip("Convert the selected file to Intel HEX");
+
+    QMenu *programmerMenu = menuBar()->addMenu("Programmer");
+    programmerMenu->addAction("Find Programmers", central, SLOT(findProgrammers()))->setStatusTip("Look for programmers on all of the serial ports");
+    programmerMenu->addAction("Production Run", central, SLOT(production()))->setStatusTip("Program one chip after another as they're put in the socket");
+
 //  chipinfoMenu->addAction(updateInfoAct);
 //  menuBar()->addAction("About", this, SLOT(handleAbout()));
 #ifdef	Q_OS_DARWIN
@@ -63,34 +71,28 @@ void MainWindow::handleAbout()
 	tr("<p align=center><b>QProg %1</b></p><p align=center>&copy; 2005-2008 Brandon Fosdick<br><a href=\"http://www.opensource.org/licenses/bsd-license.php\">BSD License</a></p><p align=center><a href=\"http://bfoz.net/projects/qprog/\">http://bfoz.net/projects/qprog/</a></p>").arg(QPROG_VERSION));
 }
 
+// Reload the target type combobox after the device info is replaced
+void MainWindow::deviceInfoUpdated()
+{
+    static_cast<CentralWidget*>(centralWidget())->FillTargetCombo();
+}
+
 void MainWindow::updateDeviceInfoFromFile()
 {
-    QString filename = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::currentPath());
+    QString filename = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::currentPath(), tr("All Files (*);;chipinfo.cid (*.cid)"));
     if( filename.size() != 0 )
     {
-	QFile	file(filename);
-	if( !file.open(QIODevice::ReadOnly) )
+	QString error;
+	DeviceDatabase::counts_type	counts;
+	if( !deviceDatabase.import(filename, counts, &error) )
 	{
-	    QMessageBox::critical(0, "Error", "Could not open device info file");
+	    QMessageBox::critical(this, tr("Update From File"), error);
+	    return;
 	}
-	else
-	{
-	    // Store the device info at the system level so the user can make
-	    //  changes without corrupting the local copy of the database.
-	    QSettings	settings(QSettings::SystemScope, "bfoz.net", "QProg");
-	    QTextStream in(&file);
-	    while(!in.atEnd())
-	    {
-		QString line(in.readLine());
-		if( line.contains('=') )
-		{
-		    QStringList qsl = line.split('=');
-		    settings.setValue(qsl.at(0), qsl.at(1));
-		}
-	    }
+	if( counts.changed() )
 	    static_cast<CentralWidget*>(centralWidget())->FillTargetCombo();	//Force the target type combobox to be reloaded
 
-	    QMessageBox::information(this, tr("Update From File"), tr("Update"));
-	}
+	QMessageBox::information(this, tr("Update From File"),
+	    tr("Added %1, updated %2, deleted %3, unchanged %4").arg(counts.inserted).arg(counts.updated).arg(counts.deleted).arg(counts.unchanged));
     }
 }
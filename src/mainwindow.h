@@ -27,6 +27,7 @@ protected:
     virtual void customEvent(QEvent*);
 
 private slots:
+    void deviceInfoUpdated();
     void handleAbout();
     void updateDeviceInfoFromFile();
 
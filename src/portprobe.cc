@@ -0,0 +1,59 @@
+/*  Find the ports that have a programmer on them
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include "kitsrus.h"
+#include "portprobe.h"
+
+namespace portprobe
+{
+    prober_t::prober_t(const QString &port, QObject *parent) : QThread(parent)
+    {
+	result.port = port;
+    }
+
+    void prober_t::run()
+    {
+	QString	port(result.port);
+	kitsrus::kitsrus_t  prog(port, chipinfo::chipinfo());
+	if( !prog.open() )
+	    return;
+
+	std::string protocol;
+	result.found = prog.probe(PROBE_TIMEOUT, protocol);
+	if( !result.found )
+	{
+	    prog.set_149();
+	    result.inverted = result.found = prog.probe(PROBE_TIMEOUT, protocol);
+	}
+	if( !result.found )
+	    return;
+
+	result.firmware = prog.get_version();
+	const char *const name = prog.firmwareName();
+	result.firmware_name = name ? QString(name) : QString("Unknown firmware %1").arg(result.firmware);
+	result.protocol = protocol.c_str();
+    }
+
+    void probe(const QStringList &ports, std::vector<result_t> &found)
+    {
+	std::vector<prober_t*>	probers;
+	for(QStringList::const_iterator i = ports.begin(); i != ports.end(); ++i)
+	{
+	    probers.push_back(new prober_t(*i));
+	    probers.back()->start();
+	}
+
+	found.clear();
+	for(std::vector<prober_t*>::iterator i = probers.begin(); i != probers.end(); ++i)
+	{
+	    (*i)->wait();
+	    if( (*i)->result.found )
+		found.push_back((*i)->result);
+	    delete *i;
+	}
+    }
+}
@@ -0,0 +1,53 @@
+/*  Find the ports that have a programmer on them
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	PORTPROBE_H
+#define	PORTPROBE_H
+
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+// How long a programmer has to answer a reset, in milliseconds
+#define	PROBE_TIMEOUT	500
+
+namespace portprobe
+{
+    struct result_t
+    {
+	QString	port;
+	bool	found;
+	int	firmware;	// One of the KIT_ values
+	QString	firmware_name;
+	QString	protocol;
+	bool	inverted;	// It only answered with the K149's inverted DTR
+	result_t() : found(false), firmware(-1), inverted(false) {}
+    };
+
+    // Probes one port on its own thread. A reset with normal DTR is tried
+    //	first, then one with the K149's inverted DTR, and each gets
+    //	PROBE_TIMEOUT to be answered. The ports are probed in parallel, so
+    //	probing all of them takes no longer than probing one.
+    class prober_t : public QThread
+    {
+    public:
+	prober_t(const QString &port, QObject *parent = NULL);
+
+	result_t    result;	// Valid once the thread has finished
+
+    protected:
+	virtual void run();
+    };
+
+    // Probe all of the ports at once and wait. found gets the ones that
+    //	answered, in the same order as ports.
+    void probe(const QStringList &ports, std::vector<result_t> &found);
+}
+
+#endif	// PORTPROBE_H
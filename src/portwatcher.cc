@@ -0,0 +1,204 @@
+/*  List the serial ports and watch for them coming and going
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QStringList>
+
+#ifdef	Q_OS_LINUX
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/netlink.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#endif	//Q_OS_LINUX
+
+#include "portwatcher.h"
+
+// udev creates the /dev node a little after the kernel announces the device
+#define	SETTLE_DELAY	250
+
+#define	SYSFS_TTY	"/sys/class/tty"
+
+QString PortInfo::description() const
+{
+    QString s(driver);
+    if( !vendor_id.isEmpty() )
+	s += QString(", USB %1:%2").arg(vendor_id).arg(product_id);
+    if( !product.isEmpty() )
+	s += QString(" %1").arg(product);
+    if( !serial.isEmpty() )
+	s += QString(", serial %1").arg(serial);
+    return s;
+}
+
+// The first line of a sysfs attribute, or an empty string if it isn't there
+static QString attribute(const QString &dir, const char *name)
+{
+    QFile file(dir + "/" + name);
+    if( !file.open(QIODevice::ReadOnly) )
+	return QString();
+    return QString(file.readLine()).trimmed();
+}
+
+// Fill in the USB fields by walking up from the port's device to the USB
+//  interface and then the USB device
+static void usb_info(const QString &device, PortInfo &info)
+{
+    QString	interface;
+    for(QString dir(device); dir.startsWith("/sys/devices/"); dir = dir.left(dir.lastIndexOf('/')))
+    {
+	if( interface.isEmpty() && QFile::exists(dir + "/bInterfaceNumber") )
+	    interface = attribute(dir, "bInterfaceNumber");
+	if( QFile::exists(dir + "/idVendor") )
+	{
+	    info.vendor_id = attribute(dir, "idVendor");
+	    info.product_id = attribute(dir, "idProduct");
+	    info.serial = attribute(dir, "serial");
+	    info.product = attribute(dir, "product");
+	    info.usb_path = dir.mid(dir.lastIndexOf('/') + 1);
+	    if( !interface.isEmpty() )
+		info.usb_path += ":" + interface;
+
+	    // A serial number only identifies the device, so multi-port
+	    //	adapters need the interface too
+	    const QString where = info.serial.isEmpty() ? info.usb_path : info.serial + ":" + interface;
+	    info.id = QString("usb-%1:%2-%3").arg(info.vendor_id).arg(info.product_id).arg(where);
+	    return;
+	}
+    }
+}
+
+QList<PortInfo> PortWatcher::enumerate()
+{
+    QList<PortInfo> list;
+#ifdef	Q_OS_LINUX
+    const QStringList names = QDir(SYSFS_TTY).entryList(QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot, QDir::Name);
+    for(QStringList::const_iterator i = names.begin(); i != names.end(); ++i)
+    {
+	const QString dir = QString(SYSFS_TTY "/%1").arg(*i);
+
+	// Consoles, ptys and the like don't have a device
+	const QString device = QFileInfo(dir + "/device").canonicalFilePath();
+	if( device.isEmpty() )
+	    continue;
+
+	// The 8250 driver makes ports whether or not there's a UART behind
+	//  them, and the ones without have a type of 0 (PORT_UNKNOWN)
+	if( attribute(dir, "type") == "0" )
+	    continue;
+
+	PortInfo info;
+	info.name = *i;
+	info.path = "/dev/" + *i;
+	info.driver = QFileInfo(QFileInfo(dir + "/device/driver").canonicalFilePath()).fileName();
+	info.id = info.path;
+	usb_info(device, info);
+	list.append(info);
+    }
+#endif	//Q_OS_LINUX
+    return list;
+}
+
+PortWatcher::PortWatcher(QObject *parent) : QObject(parent), fd(-1), netlink(false), notifier(NULL)
+{
+    timer.setSingleShot(true);
+    timer.setInterval(SETTLE_DELAY);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+
+    port_list = enumerate();
+
+#ifdef	Q_OS_LINUX
+    // Listen for the kernel's device announcements
+    fd = socket(AF_NETLINK, SOCK_DGRAM, NETLINK_KOBJECT_UEVENT);
+    if( fd != -1 )
+    {
+	struct sockaddr_nl address;
+	memset(&address, 0, sizeof(address));
+	address.nl_family = AF_NETLINK;
+	address.nl_groups = 1;		// The kernel's group (udev's is 2)
+	if( bind(fd, (struct sockaddr*)&address, sizeof(address)) == 0 )
+	    netlink = true;
+	else
+	{
+	    ::close(fd);
+	    fd = -1;
+	}
+    }
+
+    // Not allowed to, so watch /dev for nodes being made and removed
+    if( fd == -1 )
+    {
+	fd = inotify_init();
+	if( (fd != -1) && (inotify_add_watch(fd, "/dev", IN_CREATE | IN_DELETE) == -1) )
+	{
+	    ::close(fd);
+	    fd = -1;
+	}
+    }
+
+    if( fd != -1 )
+    {
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+	connect(notifier, SIGNAL(activated(int)), this, SLOT(onActivated(int)));
+    }
+#endif	//Q_OS_LINUX
+}
+
+PortWatcher::~PortWatcher()
+{
+    delete notifier;
+#ifdef	Q_OS_LINUX
+    if( fd != -1 )
+	::close(fd);
+#endif	//Q_OS_LINUX
+}
+
+// Drain the socket and restart the timer if anything happened to a tty
+void PortWatcher::onActivated(int)
+{
+#ifdef	Q_OS_LINUX
+    char buffer[4096];
+    ssize_t length;
+
+    while( (length = ::read(fd, buffer, sizeof(buffer) - 1)) > 0 )
+    {
+	if( netlink )
+	{
+	    // "action@devpath" followed by NUL separated KEY=value pairs
+	    buffer[length] = '\0';
+	    for(const char *p = buffer; p < buffer + length; p += strlen(p) + 1)
+		if( strcmp(p, "SUBSYSTEM=tty") == 0 )
+		    timer.start();
+	}
+	else
+	{
+	    for(char *p = buffer; p < buffer + length; )
+	    {
+		const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(p);
+		if( event->len && (strncmp(event->name, "tty", 3) == 0) )
+		    timer.start();
+		p += sizeof(struct inotify_event) + event->len;
+	    }
+	}
+    }
+#endif	//Q_OS_LINUX
+}
+
+void PortWatcher::onTimeout()
+{
+    const QList<PortInfo> list = enumerate();
+    if( list == port_list )
+	return;
+    port_list = list;
+    emit portsChanged();
+}
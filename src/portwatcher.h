@@ -0,0 +1,73 @@
+/*  List the serial ports and watch for them coming and going
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	PORTWATCHER_H
+#define	PORTWATCHER_H
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+class QSocketNotifier;
+
+// What sysfs knows about a serial port. The USB fields are empty for ports
+//  that aren't on USB.
+struct PortInfo
+{
+    QString	path;		// /dev/ttyUSB0
+    QString	name;		// ttyUSB0
+    QString	driver;		// ftdi_sio, cdc_acm, serial8250...
+    QString	vendor_id;	// USB idVendor, in hex
+    QString	product_id;	// USB idProduct, in hex
+    QString	serial;		// USB serial number
+    QString	product;	// USB product string
+    QString	usb_path;	// Bus and hub ports, like 1-1.2, and the interface
+    // Stays the same when the port is unplugged and comes back under a
+    //	different name: the USB serial number if there is one, otherwise the
+    //	hub port it's plugged into. Ports that aren't on USB use their path.
+    QString	id;
+
+    QString description() const;    // For tooltips
+    bool operator==(const PortInfo &o) const { return (path == o.path) && (id == o.id);	}
+};
+
+// On Linux the ports are found by walking /sys/class/tty, which picks up
+//  ttyS, ttyUSB, ttyACM and anything else that has real hardware behind it,
+//  and changes are noticed by listening for the kernel's uevents on a netlink
+//  socket. If that isn't allowed, /dev is watched with inotify instead. Either
+//  way portsChanged() is emitted once things settle, so a reconnecting
+//  programmer shows up without a rescan.
+//
+//  Elsewhere ports() is always empty and portsChanged() is never emitted.
+class PortWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    PortWatcher(QObject *parent = NULL);
+    ~PortWatcher();
+
+    const QList<PortInfo>&  ports() const { return port_list;	}
+
+    static QList<PortInfo>  enumerate();    // Walk sysfs now
+
+signals:
+    void    portsChanged();
+
+private slots:
+    void    onActivated(int);
+    void    onTimeout();
+
+private:
+    QList<PortInfo>	port_list;
+    QTimer	timer;
+    int		fd;
+    bool	netlink;	// fd is a uevent socket, not inotify
+    QSocketNotifier*	notifier;
+};
+
+#endif	// PORTWATCHER_H
@@ -0,0 +1,74 @@
+/*  Program one chip after another as they're put in the socket
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include "production.h"
+
+ProductionRun::ProductionRun(const QString &p, const chipinfo::chipinfo &chip, const chipimage::chipimage_t &i, const serializer::serializer_t &sz, quint64 first_unit, bool e, bool v, unsigned t, QObject *parent) : QThread(parent), port(p), chip_info(chip), image(i), serializer(sz), unit(first_unit), erase(e), verify(v), interval(t), stopping(0), waiting(false)
+{
+}
+
+bool ProductionRun::progress(int, int)
+{
+    return !(waiting && stopping);
+}
+
+bool ProductionRun::waitForSocket(session::session_t &s, bool inserted)
+{
+    waiting = true;
+    const bool changed = s.wait_for_socket(inserted, interval);
+    waiting = false;
+    if( !changed && !stopping )
+	emit failed(s.error());
+    return changed;
+}
+
+void ProductionRun::run()
+{
+    session::session_t	s(port, chip_info, this);
+    if( !s.open() )
+    {
+	emit failed(s.error());
+	return;
+    }
+
+    chipimage::chipimage_t  readback;
+    while( !stopping )
+    {
+	emit waitingForChip();
+	if( !waitForSocket(s, true) )
+	    return;
+
+	emit programming();
+	QTime	timer;
+	timer.start();
+	QString	error;
+	if( !serializer.empty() )
+	{
+	    // Only the fields change, so this is cheap after the first chip
+	    if( !serializer.patch(unit, image, &error) )
+	    {
+		emit failed(error);
+		return;
+	    }
+	    emit serialized(serializer.label(unit).c_str(), unit + 1);
+	    ++unit;
+	}
+	imagediff::changes_t	changes;
+	if( !s.write(image, NULL, erase) || (verify && !s.verify(image, readback, changes)) )
+	{
+	    error = s.error();
+	    s.recover();
+	}
+	else if( !changes.empty() )
+	    error = QString("%1 blocks didn't verify").arg((int)changes.size());
+	emit unitFinished(error.isEmpty(), timer.elapsed(), error);
+
+	emit waitingForRemoval();
+	if( !waitForSocket(s, false) )
+	    return;
+    }
+}
@@ -0,0 +1,103 @@
+/*  Program one chip after another as they're put in the socket
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	PRODUCTION_H
+#define	PRODUCTION_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QThread>
+#include <QTime>
+
+#include "chipimage.h"
+#include "chipinfo.h"
+#include "serializer.h"
+#include "session.h"
+
+// Counts and rate of a production run
+class ProductionStats
+{
+public:
+    ProductionStats() : passed(0), failed(0), busy(0) {}
+
+    unsigned	passed;
+    unsigned	failed;
+
+    void    start()	{ clock.start();	}
+    void    add(bool pass, int ms)
+    {
+	if( pass )
+	    ++passed;
+	else
+	    ++failed;
+	busy += ms;
+    }
+
+    unsigned	units() const { return passed + failed;	}
+    // Including the time spent changing chips
+    double  unitsPerHour() const
+    {
+	const int elapsed = clock.elapsed();
+	return elapsed ? (3600000.0 * units() / elapsed) : 0;
+    }
+    // Programming time only
+    int	averageTime() const { return units() ? (int)(busy / units()) : 0;	}
+
+private:
+    QTime   clock;
+    double  busy;   // Milliseconds spent programming
+};
+
+// Keeps one session open, watches the socket, and programs (and verifies)
+//  each chip as soon as it's seated. The image, session and readback buffer
+//  are kept between chips, so each one costs only the programming itself.
+//  Progress is reported with queued signals, and the run goes on until
+//  stop() is called or the programmer stops responding.
+//
+//  If the serializer has any fields each chip gets the next unit's values,
+//  starting from first_unit. A unit is used up whether or not its chip
+//  passes, so that a number never ends up on two chips.
+class ProductionRun : public QThread, private session::progress_t
+{
+    Q_OBJECT
+public:
+    // interval is how often to check the socket, in milliseconds
+    ProductionRun(const QString &port, const chipinfo::chipinfo &, const chipimage::chipimage_t &, const serializer::serializer_t &, quint64 first_unit, bool erase, bool verify, unsigned interval, QObject *parent = NULL);
+
+public slots:
+    // Stop once the chip being programmed, if any, is done
+    void    stop()  { stopping = 1;	}
+
+signals:
+    void    waitingForChip();
+    void    programming();
+    void    serialized(const QString &label, qulonglong next_unit);
+    void    unitFinished(bool passed, int ms, const QString &error);
+    void    waitingForRemoval();
+    void    failed(const QString &error);	// The run stopped because of an error
+
+protected:
+    virtual void run();
+
+private:
+    QString port;
+    chipinfo::chipinfo	chip_info;
+    chipimage::chipimage_t  image;
+    serializer::serializer_t	serializer;
+    quint64	unit;
+    bool    erase;
+    bool    verify;
+    unsigned	interval;
+
+    QAtomicInt	stopping;
+    bool    waiting;	// Only the socket waits can be cancelled
+
+    virtual bool    progress(int, int);
+    bool    waitForSocket(session::session_t &, bool inserted);
+};
+
+#endif	// PRODUCTION_H
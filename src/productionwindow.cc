@@ -0,0 +1,110 @@
+/*  Window that shows a production run as it goes
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <QCloseEvent>
+#include <QGridLayout>
+#include <QSettings>
+
+#include "productionwindow.h"
+
+ProductionWindow::ProductionWindow(const QString &port, const chipinfo::chipinfo &chip_info, const chipimage::chipimage_t &image, const serializer::serializer_t &serializer, quint64 first_unit, bool erase, bool verify, unsigned interval, QWidget *parent) : QDialog(parent)
+{
+    setAttribute(Qt::WA_DeleteOnClose);
+    setWindowTitle(QString("Production - %1").arg(chip_info.name.c_str()));
+
+    state = new QLabel("Starting");
+    result = new QLabel("");
+    result->setAlignment(Qt::AlignCenter);
+    result->setStyleSheet("font-size: 36pt; font-weight: bold");
+    error = new QLabel("");
+    serial = new QLabel("");
+    counts = new QLabel("");
+    rate = new QLabel("");
+    stopButton = new QPushButton("Stop");
+
+    QGridLayout	*layout = new QGridLayout;
+    layout->addWidget(state, 0, 0, 1, 2);
+    layout->addWidget(result, 1, 0, 1, 2);
+    layout->addWidget(error, 2, 0, 1, 2);
+    layout->addWidget(serial, 3, 0, 1, 2);
+    layout->addWidget(counts, 4, 0);
+    layout->addWidget(rate, 4, 1);
+    layout->addWidget(stopButton, 5, 1);
+    setLayout(layout);
+
+    run = new ProductionRun(port, chip_info, image, serializer, first_unit, erase, verify, interval, this);
+    connect(run, SIGNAL(waitingForChip()), this, SLOT(onWaitingForChip()));
+    connect(run, SIGNAL(programming()), this, SLOT(onProgramming()));
+    connect(run, SIGNAL(serialized(const QString&, qulonglong)), this, SLOT(onSerialized(const QString&, qulonglong)));
+    connect(run, SIGNAL(unitFinished(bool, int, const QString&)), this, SLOT(onUnitFinished(bool, int, const QString&)));
+    connect(run, SIGNAL(waitingForRemoval()), this, SLOT(onWaitingForRemoval()));
+    connect(run, SIGNAL(failed(const QString&)), this, SLOT(onFailed(const QString&)));
+    connect(run, SIGNAL(finished()), this, SLOT(onRunFinished()));
+    connect(stopButton, SIGNAL(clicked()), run, SLOT(stop()));
+
+    stats.start();
+    run->start();
+}
+
+ProductionWindow::~ProductionWindow()
+{
+    run->stop();
+    run->wait();
+}
+
+void ProductionWindow::closeEvent(QCloseEvent *event)
+{
+    run->stop();
+    event->accept();
+}
+
+void ProductionWindow::onWaitingForChip()
+{
+    state->setText("Insert a chip");
+}
+
+void ProductionWindow::onProgramming()
+{
+    state->setText("Programming");
+    result->setText("");
+    result->setStyleSheet("font-size: 36pt; font-weight: bold");
+    error->setText("");
+}
+
+// Remember where to pick up next time, even if this run doesn't finish cleanly
+void ProductionWindow::onSerialized(const QString &label, qulonglong next_unit)
+{
+    serial->setText(QString("Serial %1").arg(label));
+    QSettings().setValue("Production/Serial/NextUnit", next_unit);
+}
+
+void ProductionWindow::onUnitFinished(bool passed, int ms, const QString &message)
+{
+    stats.add(passed, ms);
+
+    result->setText(passed ? "PASS" : "FAIL");
+    result->setStyleSheet(QString("font-size: 36pt; font-weight: bold; color: %1").arg(passed ? "green" : "red"));
+    error->setText(message);
+    counts->setText(QString("Passed %1, failed %2").arg(stats.passed).arg(stats.failed));
+    rate->setText(QString("%1 units/hour, %2 ms each").arg(stats.unitsPerHour(), 0, 'f', 0).arg(stats.averageTime()));
+}
+
+void ProductionWindow::onWaitingForRemoval()
+{
+    state->setText("Remove the chip");
+}
+
+void ProductionWindow::onFailed(const QString &message)
+{
+    error->setText(message);
+}
+
+void ProductionWindow::onRunFinished()
+{
+    state->setText("Stopped");
+    stopButton->setEnabled(false);
+}
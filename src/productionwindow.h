@@ -0,0 +1,52 @@
+/*  Window that shows a production run as it goes
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	PRODUCTIONWINDOW_H
+#define	PRODUCTIONWINDOW_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QPushButton>
+
+#include "production.h"
+
+// Shows what the socket is waiting for, pass or fail for the last chip, the
+//  counts and the rate, without stopping for any dialogs. Closing the window
+//  stops the run. Deletes itself when closed.
+class ProductionWindow : public QDialog
+{
+    Q_OBJECT
+public:
+    ProductionWindow(const QString &port, const chipinfo::chipinfo &, const chipimage::chipimage_t &, const serializer::serializer_t &, quint64 first_unit, bool erase, bool verify, unsigned interval, QWidget *parent = NULL);
+    ~ProductionWindow();
+
+protected:
+    virtual void closeEvent(QCloseEvent *);
+
+private slots:
+    void    onWaitingForChip();
+    void    onProgramming();
+    void    onSerialized(const QString &label, qulonglong next_unit);
+    void    onUnitFinished(bool passed, int ms, const QString &error);
+    void    onWaitingForRemoval();
+    void    onFailed(const QString &error);
+    void    onRunFinished();
+
+private:
+    ProductionRun   *run;
+    ProductionStats stats;
+
+    QLabel  *state;
+    QLabel  *result;
+    QLabel  *error;
+    QLabel  *serial;
+    QLabel  *counts;
+    QLabel  *rate;
+    QPushButton	*stopButton;
+};
+
+#endif	// PRODUCTIONWINDOW_H
@@ -0,0 +1,71 @@
+/*  Queue between two threads that doesn't need a lock
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	RING_H
+#define	RING_H
+
+#include <vector>
+
+#include <QAtomicInt>
+
+// A fixed size circular queue with exactly one thread pushing and one thread
+//  popping. Each side only ever writes its own index, and publishes it with a
+//  release store after the items are in place, so neither side waits on the
+//  other and there's no lock to be preempted while holding. push() and pop()
+//  move as many items as they can and return how many that was.
+template<typename T> class ring_t
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit ring_t(unsigned capacity) : head(0), tail(0)
+    {
+	unsigned size = 1;
+	while( size < capacity )
+	    size <<= 1;
+	buffer.resize(size);
+	mask = size - 1;
+    }
+
+    // Producer only
+    unsigned push(const T *items, unsigned count)
+    {
+	const unsigned t = (int)tail;
+	const unsigned h = head.fetchAndAddAcquire(0);
+	const unsigned n = qMin(count, (unsigned)buffer.size() - (t - h));
+	for(unsigned i=0; i < n; ++i)
+	    buffer[(t + i) & mask] = items[i];
+	tail.fetchAndStoreRelease(t + n);
+	return n;
+    }
+
+    // Consumer only
+    unsigned pop(T *items, unsigned count)
+    {
+	const unsigned h = (int)head;
+	const unsigned t = tail.fetchAndAddAcquire(0);
+	const unsigned n = qMin(count, t - h);
+	for(unsigned i=0; i < n; ++i)
+	    items[i] = buffer[(h + i) & mask];
+	head.fetchAndStoreRelease(h + n);
+	return n;
+    }
+
+    // Either side. Only a snapshot, since the other side may be moving.
+    unsigned size()	{ return (unsigned)tail.fetchAndAddAcquire(0) - (unsigned)head.fetchAndAddAcquire(0);	}
+    bool    empty()	{ return size() == 0;	}
+    unsigned space()	{ return buffer.size() - size();	}
+
+private:
+    std::vector<T>  buffer;
+    unsigned	mask;
+    QAtomicInt	head;	// Next item to pop, written only by the consumer
+    QAtomicInt	tail;	// Next free slot, written only by the producer
+
+    ring_t(const ring_t &);	// No copy
+};
+
+#endif	// RING_H
@@ -0,0 +1,229 @@
+/*  Decide which programmer runs each job
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <algorithm>
+
+#include "kitsrus.h"
+#include "scheduler.h"
+
+#define	FAMILY(f)	(1 << coretraits::f)
+#define	ALL_FAMILIES	(FAMILY(CORE10) | FAMILY(CORE12) | FAMILY(CORE14) | FAMILY(CORE16))
+
+// The core families that each firmware can program
+static const struct
+{
+    int		firmware;
+    unsigned	families;
+} firmware_families[] =
+{
+    {KIT_128,	FAMILY(CORE12) | FAMILY(CORE14)},
+    {KIT_149A,	FAMILY(CORE12) | FAMILY(CORE14) | FAMILY(CORE16)},
+    {KIT_149B,	FAMILY(CORE12) | FAMILY(CORE14) | FAMILY(CORE16)},
+    {KIT_150,	ALL_FAMILIES},
+    {KIT_170,	FAMILY(CORE12) | FAMILY(CORE14)},
+    {KIT_182,	ALL_FAMILIES},
+    {KIT_185,	ALL_FAMILIES}
+};
+
+bool Scheduler::supports(int firmware, coretraits::family_t family)
+{
+    if( family == coretraits::CORE_UNKNOWN )
+	return false;
+    for(unsigned i=0; i < sizeof(firmware_families)/sizeof(firmware_families[0]); ++i)
+	if( firmware_families[i].firmware == firmware )
+	    return firmware_families[i].families & (1 << family);
+    return true;
+}
+
+Scheduler::Scheduler(const QStringList &ports)
+{
+    for(QStringList::const_iterator i = ports.begin(); i != ports.end(); ++i)
+	units.push_back(programmer_t(*i));
+}
+
+int Scheduler::find(const QString &port) const
+{
+    for(unsigned i=0; i < units.size(); ++i)
+	if( units[i].port == port )
+	    return i;
+    return -1;
+}
+
+bool Scheduler::eligible(const programmer_t &unit, const entry_t &entry) const
+{
+    return !unit.faulted && supports(unit.firmware, entry.family);
+}
+
+// Roughly how long a new job would have to wait for a programmer. Until a
+//  programmer has finished something it's assumed to be as fast as the
+//  average of the others.
+double Scheduler::cost(const programmer_t &unit) const
+{
+    double  per_job = unit.average_ms;
+    if( per_job == 0 )
+    {
+	double	total = 0;
+	unsigned    known = 0;
+	for(programmers_type::const_iterator i = units.begin(); i != units.end(); ++i)
+	    if( i->average_ms )
+	    {
+		total += i->average_ms;
+		++known;
+	    }
+	per_job = known ? (total / known) : 1;
+    }
+    return per_job * (unit.queue.size() + (unit.busy ? 1 : 0));
+}
+
+// Put a job in the queue of the best programmer for it
+bool Scheduler::place(job_id id, entry_t &entry)
+{
+    int	best = -1;
+    if( entry.pinned )
+	best = eligible(units[entry.unit], entry) ? (int)entry.unit : -1;
+    else
+    {
+	for(unsigned i=0; i < units.size(); ++i)
+	    if( eligible(units[i], entry) && ((best < 0) || (cost(units[i]) < cost(units[best]))) )
+		best = i;
+    }
+    if( best < 0 )
+	return false;
+
+    entry.unit = best;
+    units[best].queue.push_back(id);
+    entries[id] = entry;
+    return true;
+}
+
+bool Scheduler::add(job_id id, const QString &port, coretraits::family_t family)
+{
+    entry_t entry;
+    entry.family = family;
+    entry.pinned = !port.isEmpty();
+    entry.unit = 0;
+    if( entry.pinned )
+    {
+	const int unit = find(port);
+	if( unit < 0 )
+	    return false;
+	entry.unit = unit;
+    }
+    return place(id, entry);
+}
+
+bool Scheduler::remove(job_id id)
+{
+    std::map<job_id, entry_t>::iterator i = entries.find(id);
+    if( i == entries.end() )
+	return false;
+    std::deque<job_id> &queue = units[i->second.unit].queue;
+    queue.erase(std::find(queue.begin(), queue.end(), id));
+    entries.erase(i);
+    return true;
+}
+
+Scheduler::job_id Scheduler::next(const QString &port)
+{
+    const int unit = find(port);
+    if( (unit < 0) || units[unit].busy || units[unit].faulted )
+	return 0;
+    programmer_t &self = units[unit];
+
+    std::deque<job_id> *from = &self.queue;
+    std::deque<job_id>::iterator job = self.queue.begin();
+    if( self.queue.empty() )
+    {
+	// Steal the oldest job that this programmer can run from the longest queue
+	from = NULL;
+	for(programmers_type::iterator i = units.begin(); i != units.end(); ++i)
+	{
+	    if( (from && (i->queue.size() <= from->size())) || (&*i == &self) )
+		continue;
+	    for(std::deque<job_id>::iterator j = i->queue.begin(); j != i->queue.end(); ++j)
+	    {
+		const entry_t &entry = entries[*j];
+		if( !entry.pinned && eligible(self, entry) )
+		{
+		    from = &i->queue;
+		    job = j;
+		    break;
+		}
+	    }
+	}
+	if( !from )
+	    return 0;
+    }
+
+    const job_id id = *job;
+    from->erase(job);
+    entries.erase(id);
+    self.busy = true;
+    return id;
+}
+
+void Scheduler::finished(const QString &port, int ms)
+{
+    const int unit = find(port);
+    if( unit < 0 )
+	return;
+    programmer_t &self = units[unit];
+    self.busy = false;
+    self.failures = 0;
+    if( ms < 0 )
+	return;
+    ++self.completed;
+    self.average_ms = self.average_ms ? (self.average_ms + (ms - self.average_ms)/4) : ms;
+}
+
+void Scheduler::failed(const QString &port, std::vector<job_id> &orphans)
+{
+    const int unit = find(port);
+    if( unit < 0 )
+	return;
+    programmer_t &self = units[unit];
+    self.busy = false;
+    if( ++self.failures >= FAULT_LIMIT )
+    {
+	self.faulted = true;
+	evict(unit, true, orphans);
+    }
+}
+
+void Scheduler::setFirmware(const QString &port, int firmware, std::vector<job_id> &orphans)
+{
+    const int unit = find(port);
+    if( (unit < 0) || (units[unit].firmware == firmware) )
+	return;
+    units[unit].firmware = firmware;
+    evict(unit, false, orphans);
+}
+
+// Move the waiting jobs that a programmer can't run, or all of them, to other programmers
+void Scheduler::evict(unsigned unit, bool everything, std::vector<job_id> &orphans)
+{
+    std::deque<job_id> &queue = units[unit].queue;
+    std::deque<job_id>	moving;
+    for(std::deque<job_id>::iterator i = queue.begin(); i != queue.end();)
+    {
+	if( everything || !eligible(units[unit], entries[*i]) )
+	{
+	    moving.push_back(*i);
+	    i = queue.erase(i);
+	}
+	else
+	    ++i;
+    }
+
+    for(std::deque<job_id>::iterator i = moving.begin(); i != moving.end(); ++i)
+    {
+	entry_t entry = entries[*i];
+	entries.erase(*i);
+	if( !place(*i, entry) )
+	    orphans.push_back(*i);
+    }
+}
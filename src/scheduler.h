@@ -0,0 +1,103 @@
+/*  Decide which programmer runs each job
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	SCHEDULER_H
+#define	SCHEDULER_H
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+
+#include "coretraits.h"
+
+// Open or reset failures in a row that take a programmer out of rotation
+#define	FAULT_LIMIT	3
+
+// Keeps a queue of jobs for each programmer. A job that names a programmer
+//  goes in that programmer's queue. Any other job goes to the compatible
+//  programmer that should get to it soonest, going by how many jobs are ahead
+//  of it there and how long that programmer has been taking per job. A
+//  programmer that runs out of work takes the oldest job that it can run from
+//  the longest queue.
+//
+//  Which core families a programmer can handle depends on its firmware, which
+//  isn't known until it's been reset, so until then it's assumed to handle
+//  everything. A programmer that can't be opened or reset FAULT_LIMIT times in
+//  a row is taken out of rotation, and the jobs waiting for it are handed out
+//  again.
+//
+//  Nothing here is thread safe. The scheduler only keeps job IDs, and the
+//  caller starts the jobs.
+class Scheduler
+{
+public:
+    typedef unsigned	job_id;
+
+    struct programmer_t
+    {
+	QString	port;
+	int	firmware;	// -1 until it's known
+	bool	busy;
+	bool	faulted;	// Out of rotation
+	unsigned    failures;	// Open or reset failures in a row
+	unsigned    completed;
+	double	average_ms;	// Moving average of the time per job, 0 until one finishes
+	std::deque<job_id>  queue;  // Oldest first
+
+	programmer_t(const QString &p) : port(p), firmware(-1), busy(false), faulted(false), failures(0), completed(0), average_ms(0) {}
+    };
+    typedef std::vector<programmer_t>	programmers_type;
+
+    Scheduler(const QStringList &ports);
+
+    // Queue a job, for the given programmer or, if port is empty, for any of
+    //	them. Returns false if no programmer can run it.
+    bool    add(job_id, const QString &port, coretraits::family_t);
+    // Returns false if the job wasn't waiting
+    bool    remove(job_id);
+    // The job that an idle programmer should start next, or 0 if there
+    //	isn't one. The programmer is busy until finished() or failed().
+    job_id  next(const QString &port);
+
+    // The programmer finished a job, successfully or not, in ms
+    //	milliseconds. ms is negative if the job didn't actually run.
+    void    finished(const QString &port, int ms);
+    // The programmer couldn't be opened or reset. If that takes it out of
+    //	rotation, the jobs that were waiting for it and can't go anywhere
+    //	else are appended to orphans.
+    void    failed(const QString &port, std::vector<job_id> &orphans);
+    // The programmer was reset and reported its firmware. Waiting jobs that
+    //	it turns out not to be able to run are moved, or appended to orphans.
+    void    setFirmware(const QString &port, int firmware, std::vector<job_id> &orphans);
+
+    const programmers_type& programmers() const { return units;	}
+    // Can a programmer with the given firmware program the family? Unknown
+    //	firmware can program any family but CORE_UNKNOWN, which nothing can.
+    static bool	supports(int firmware, coretraits::family_t);
+
+private:
+    struct entry_t
+    {
+	coretraits::family_t	family;
+	bool	pinned;		// Has to run on the programmer it was given
+	unsigned    unit;	// Whose queue it's in
+    };
+
+    programmers_type	units;
+    std::map<job_id, entry_t>	entries;    // Waiting jobs
+
+    int	    find(const QString &port) const;
+    bool    eligible(const programmer_t &, const entry_t &) const;
+    double  cost(const programmer_t &) const;
+    bool    place(job_id, entry_t &);
+    void    evict(unsigned unit, bool everything, std::vector<job_id> &orphans);
+};
+
+#endif	// SCHEDULER_H
@@ -0,0 +1,329 @@
+/*  Give each chip its own serial number, MAC address or other unique data
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QFile>
+
+#include "coretraits.h"
+#include "serializer.h"
+
+// RETLW k, for each core family that has narrow program words
+#define	RETLW_12BIT	0x0800
+#define	RETLW_14BIT	0x3400
+
+namespace serializer
+{
+    static bool fail(QString *error, const QString &message)
+    {
+	if( error )
+	    *error = message;
+	return false;
+    }
+
+    static bool parse_number(const std::string &s, uint64_t &n)
+    {
+	char *end;
+	n = strtoull(s.c_str(), &end, 0);
+	return !s.empty() && (*end == '\0');
+    }
+
+    // Check that a template has exactly one conversion that format() can do
+    static bool check_pattern(const std::string &pattern)
+    {
+	unsigned conversions = 0;
+	for(std::string::size_type i=0; i < pattern.size(); ++i)
+	{
+	    if( pattern[i] != '%' )
+		continue;
+	    if( (i+1 < pattern.size()) && (pattern[i+1] == '%') )
+	    {
+		++i;
+		continue;
+	    }
+	    while( (i+1 < pattern.size()) && isdigit((unsigned char)pattern[i+1]) )
+		++i;
+	    if( (i+1 == pattern.size()) || !strchr("uxX", pattern[i+1]) )
+		return false;
+	    ++i;
+	    ++conversions;
+	}
+	return conversions == 1;
+    }
+
+    // A checked template with the number in it. Written out by hand so that
+    //	the template never gets anywhere near printf.
+    static std::string format(const std::string &pattern, uint64_t n)
+    {
+	std::string result;
+	for(std::string::size_type i=0; i < pattern.size(); ++i)
+	{
+	    if( pattern[i] != '%' )
+	    {
+		result += pattern[i];
+		continue;
+	    }
+	    if( pattern[++i] == '%' )
+	    {
+		result += '%';
+		continue;
+	    }
+
+	    const bool zero = (pattern[i] == '0');
+	    unsigned width = 0;
+	    for(; isdigit((unsigned char)pattern[i]); ++i)
+		width = 10*width + (pattern[i] - '0');
+
+	    const char *const digits = (pattern[i] == 'X') ? "0123456789ABCDEF" : "0123456789abcdef";
+	    const unsigned base = (pattern[i] == 'u') ? 10 : 16;
+	    std::string number;
+	    do
+	    {
+		number.insert(number.begin(), digits[n % base]);
+		n /= base;
+	    } while( n );
+	    if( number.size() < width )
+		number.insert(number.begin(), width - number.size(), zero ? '0' : ' ');
+	    result += number;
+	}
+	return result;
+    }
+
+    // Hex digits, optionally separated by colons, dashes or spaces
+    static bool parse_hex(const std::string &s, std::string &bytes)
+    {
+	std::string digits;
+	for(std::string::const_iterator i = s.begin(); i != s.end(); ++i)
+	{
+	    if( isxdigit((unsigned char)*i) )
+		digits += *i;
+	    else if( (*i != ':') && (*i != '-') && (*i != ' ') )
+		return false;
+	}
+	if( digits.size() % 2 )
+	    digits.insert(digits.begin(), '0');
+
+	bytes.clear();
+	for(std::string::size_type i=0; i < digits.size(); i += 2)
+	    bytes += (char)strtoul(digits.substr(i, 2).c_str(), NULL, 16);
+	return true;
+    }
+
+    // One value per line. Blank lines and lines starting with # are skipped.
+    static bool load_list(const QString &name, std::vector<std::string> &values, QString *error)
+    {
+	QFile	file(name);
+	if( !file.open(QIODevice::ReadOnly | QIODevice::Text) )
+	    return fail(error, QString("Could not open %1").arg(name));
+	while( !file.atEnd() )
+	{
+	    const QByteArray line = file.readLine().trimmed();
+	    if( !line.isEmpty() && (line[0] != '#') )
+		values.push_back(std::string(line.constData(), line.size()));
+	}
+	if( values.empty() )
+	    return fail(error, QString("%1 doesn't have any values").arg(name));
+	return true;
+    }
+
+    bool serializer_t::add(const std::string &spec, QString *error)
+    {
+	field_t	field;
+	bool	has_address = false;
+	std::string::size_type	begin = 0;
+	while( begin < spec.size() )
+	{
+	    std::string::size_type end = spec.find(',', begin);
+	    if( end == std::string::npos )
+		end = spec.size();
+	    const std::string item(spec, begin, end - begin);
+	    begin = end + 1;
+
+	    const std::string::size_type equals = item.find('=');
+	    if( equals == std::string::npos )
+		return fail(error, QString("Expected key=value in %1").arg(item.c_str()));
+	    const std::string key(item, 0, equals);
+	    const std::string value(item, equals + 1);
+
+	    uint64_t	n = 0;
+	    const bool	numeric = parse_number(value, n);
+	    if( (key == "address") && numeric )
+	    {
+		field.address = n;
+		has_address = true;
+	    }
+	    else if( (key == "width") && numeric && (n > 0) && (n <= 64) )
+		field.width = n;
+	    else if( (key == "start") && numeric )
+		field.start = n;
+	    else if( (key == "step") && numeric )
+		field.step = n;
+	    else if( (key == "format") && (value == "be") )
+		field.format = FORMAT_BE;
+	    else if( (key == "format") && (value == "le") )
+		field.format = FORMAT_LE;
+	    else if( (key == "format") && (value == "text") )
+		field.format = FORMAT_TEXT;
+	    else if( key == "template" )
+	    {
+		if( !check_pattern(value) )
+		    return fail(error, QString("The template needs one %u, %x or %X: %1").arg(value.c_str()));
+		field.pattern = value;
+	    }
+	    else if( (key == "rom") && (value == "retlw") )
+		field.retlw = true;
+	    else if( (key == "rom") && (value == "raw") )
+		field.retlw = false;
+	    else if( key == "list" )
+	    {
+		if( !load_list(QFile::decodeName(value.c_str()), field.values, error) )
+		    return false;
+	    }
+	    else
+		return fail(error, QString("Bad serial field setting %1").arg(item.c_str()));
+	}
+	if( !has_address )
+	    return fail(error, QString("Serial field needs an address: %1").arg(spec.c_str()));
+
+	fields.push_back(field);
+	return true;
+    }
+
+    bool serializer_t::bind(const chipinfo::chipinfo &chip, const chipimage::chipimage_t &image, QString *error)
+    {
+	const coretraits::family_t family = coretraits::family(chip.core_type);
+	if( family == coretraits::CORE_UNKNOWN )
+	    return fail(error, QString("%1 has an unknown core type").arg(chip.name.c_str()));
+	const bool narrow = (family != coretraits::CORE16);
+	const uint16_t retlw = (family == coretraits::CORE14) ? RETLW_14BIT : RETLW_12BIT;
+
+	for(std::vector<field_t>::iterator i = fields.begin(); i != fields.end(); ++i)
+	{
+	    unsigned r = 0;
+	    for(; r < chipimage::NUM_REGIONS; ++r)
+	    {
+		const chipimage::region_t region = (chipimage::region_t)r;
+		const bool words = narrow && ((region == chipimage::ROM) || (region == chipimage::ID));
+		i->opcode = (words && (region == chipimage::ROM) && i->retlw) ? retlw : 0;
+		i->word_mask = words ? chip.romBlank() : 0xFFFF;
+		if( (i->address >= image.begin(region)) && (i->address + i->span() <= image.end(region)) )
+		{
+		    i->region = region;
+		    i->offset = i->address - image.begin(region);
+		    break;
+		}
+	    }
+	    if( r == chipimage::NUM_REGIONS )
+		return fail(error, QString("Serial field at 0x%1 isn't inside the ROM, EEPROM, ID or config").arg(format("%X", i->address).c_str()));
+	    if( i->opcode && (i->offset % 2) )
+		return fail(error, QString("Serial field at 0x%1 doesn't start on a word").arg(format("%X", i->address).c_str()));
+	}
+	return true;
+    }
+
+    bool serializer_t::value(const field_t &field, uint64_t unit, std::string &bytes, QString *error)
+    {
+	if( !field.values.empty() )
+	{
+	    if( unit >= field.values.size() )
+		return fail(error, QString("Ran out of values for the serial field at 0x%1").arg(format("%X", field.address).c_str()));
+	    const std::string &s = field.values[unit];
+	    if( field.format == FORMAT_TEXT )
+		bytes = s;
+	    else if( !parse_hex(s, bytes) )
+		return fail(error, QString("Not a hex value: %1").arg(s.c_str()));
+	    if( bytes.size() > field.width )
+		return fail(error, QString("%1 doesn't fit in %2 bytes").arg(s.c_str()).arg((unsigned)field.width));
+	    // Numbers are padded on the left, text on the right
+	    if( field.format == FORMAT_TEXT )
+		bytes.append(field.width - bytes.size(), '\0');
+	    else
+		bytes.insert(bytes.begin(), field.width - bytes.size(), '\0');
+	}
+	else
+	{
+	    const uint64_t n = field.start + unit*field.step;
+	    if( field.format == FORMAT_TEXT )
+	    {
+		bytes = format(field.pattern, n);
+		if( bytes.size() > field.width )
+		    return fail(error, QString("%1 doesn't fit in %2 bytes").arg(bytes.c_str()).arg((unsigned)field.width));
+		bytes.append(field.width - bytes.size(), '\0');
+	    }
+	    else
+	    {
+		if( (field.width < 8) && (n >> (8*field.width)) )
+		    return fail(error, QString("Serial number %1 doesn't fit in %2 bytes").arg(format("%u", n).c_str()).arg((unsigned)field.width));
+		bytes.assign(field.width, '\0');
+		for(size_type i=0; (i < field.width) && (i < 8); ++i)
+		    bytes[field.width - 1 - i] = (char)(n >> (8*i));
+	    }
+	}
+
+	if( field.format == FORMAT_LE )
+	    bytes.assign(bytes.rbegin(), bytes.rend());
+	return true;
+    }
+
+    bool serializer_t::patch(uint64_t unit, chipimage::chipimage_t &image, QString *error) const
+    {
+	std::string bytes;
+	for(std::vector<field_t>::const_iterator i = fields.begin(); i != fields.end(); ++i)
+	{
+	    if( !value(*i, unit, bytes, error) )
+		return false;
+
+	    if( i->opcode )	// A word for each byte
+	    {
+		for(size_type j=0; j < i->width; ++j)
+		{
+		    const uint16_t word = i->opcode | (uint8_t)bytes[j];
+		    image.set(i->region, i->offset + 2*j, word & 0xFF);
+		    image.set(i->region, i->offset + 2*j + 1, word >> 8);
+		}
+		continue;
+	    }
+
+	    // The high byte of a narrow word can't take every value
+	    const uint8_t high_mask = i->word_mask >> 8;
+	    for(size_type j=0; j < i->width; ++j)
+		if( ((i->offset + j) % 2) && ((uint8_t)bytes[j] & ~high_mask) )
+		    return fail(error, QString("Serial value %1 doesn't fit in the %2-bit words at 0x%3").arg(label(unit).c_str()).arg(i->word_mask == BLANK_12BIT ? 12 : 14).arg(format("%X", i->address).c_str()));
+	    for(size_type j=0; j < i->width; ++j)
+		image.set(i->region, i->offset + j, (uint8_t)bytes[j]);
+	}
+	return true;
+    }
+
+    std::string serializer_t::label(uint64_t unit) const
+    {
+	static const char digits[] = "0123456789ABCDEF";
+	std::string result, bytes;
+	for(std::vector<field_t>::const_iterator i = fields.begin(); i != fields.end(); ++i)
+	{
+	    if( !result.empty() )
+		result += ' ';
+	    if( !value(*i, unit, bytes, NULL) )
+		result += '?';
+	    else if( i->format == FORMAT_TEXT )
+		result += bytes.substr(0, bytes.find('\0'));
+	    else
+	    {
+		if( i->format == FORMAT_LE )	// Show it the way it reads
+		    bytes.assign(bytes.rbegin(), bytes.rend());
+		for(std::string::const_iterator j = bytes.begin(); j != bytes.end(); ++j)
+		{
+		    result += digits[((uint8_t)*j) >> 4];
+		    result += digits[((uint8_t)*j) & 0xF];
+		}
+	    }
+	}
+	return result;
+    }
+}
@@ -0,0 +1,98 @@
+/*  Give each chip its own serial number, MAC address or other unique data
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	SERIALIZER_H
+#define	SERIALIZER_H
+
+#include <string>
+#include <vector>
+
+#include <QString>
+
+#include "chipimage.h"
+#include "chipinfo.h"
+
+namespace serializer
+{
+    typedef chipimage::chipimage_t::address_t	address_t;
+    typedef chipimage::chipimage_t::size_type	size_type;
+
+    enum format_t
+    {
+	FORMAT_BE,	// Binary, most significant byte first
+	FORMAT_LE,	// Binary, least significant byte first
+	FORMAT_TEXT	// Characters, padded with zeros
+    };
+
+    // One run of bytes that's different on every chip. Unit n gets the nth
+    //	line of the list file if there is one, otherwise start + n*step, as
+    //	bytes or through the template.
+    //
+    //	The program and ID words of 12 and 14-bit cores are narrower than
+    //	two bytes. In ROM each byte normally gets a word of its own, as a
+    //	RETLW with the byte in it, so that the field is a table that the
+    //	firmware can CALL into. With rom=raw the bytes are stored two to a
+    //	word, low byte first, like they are in ID. Then a value with bits
+    //	that a word doesn't have fails to patch. On 16-bit cores, and
+    //	in EEPROM and config, bytes are stored as they are.
+    struct field_t
+    {
+	address_t   address;	// Hex file address, as for chipimage_t::put()
+	size_type   width;	// Bytes
+	format_t    format;
+	uint64_t    start;
+	uint64_t    step;
+	std::string pattern;	// Template for text, with one %u, %x or %X (%06u and so on)
+	std::vector<std::string>    values;	// From the list file
+	bool	retlw;		// One RETLW per byte in ROM, rather than raw bytes
+
+	// Filled in by serializer_t::bind()
+	chipimage::region_t region;
+	size_type   offset;
+	uint16_t    opcode;	// RETLW for the core, or 0 for raw bytes
+	uint16_t    word_mask;	// The bits of a word that the region holds
+
+	field_t() : address(0), width(4), format(FORMAT_BE), start(0), step(1), pattern("%u"), retlw(true), region(chipimage::ROM), offset(0), opcode(0), word_mask(0xFFFF) {}
+	// Bytes of the image that the field covers
+	size_type   span() const { return opcode ? 2*width : width;	}
+    };
+
+    // Patches the fields into an image for each chip, so that a file only has
+    //	to be loaded once for a whole run. The patched image starts out as a
+    //	copy of the loaded one, sharing its storage, and gets its own storage
+    //	the first time it's patched. After that each unit only overwrites the
+    //	fields' bytes.
+    class serializer_t
+    {
+    public:
+	// Add a field described by a comma separated list of
+	//  address=, width=, format=be|le|text, start=, step=, template=,
+	//  list=<file> and rom=retlw|raw. For example
+	//  "address=0x4200,width=2,start=1000" or
+	//  "address=0x3FC0,width=8,format=text,template=SN%06u".
+	bool	add(const std::string &spec, QString *error = NULL);
+	bool	empty() const { return fields.empty();	}
+
+	// Find each field in the regions of image, which is for chip. Fails if
+	//  one isn't entirely inside a region.
+	bool	bind(const chipinfo::chipinfo &chip, const chipimage::chipimage_t &image, QString *error = NULL);
+
+	// Write unit's values into image, which should have the same layout as
+	//  the bound one. Fails if a value doesn't fit its words.
+	bool	patch(uint64_t unit, chipimage::chipimage_t &image, QString *error = NULL) const;
+
+	// The values for unit, for logs: text as is, binary as hex
+	std::string label(uint64_t unit) const;
+
+    private:
+	std::vector<field_t>	fields;
+
+	static bool	value(const field_t &, uint64_t unit, std::string &bytes, QString *error);
+    };
+}
+
+#endif	// SERIALIZER_H
@@ -0,0 +1,299 @@
+/*  A programming session with one programmer and one target
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include "chipdetect.h"
+#include "coretraits.h"
+#include "session.h"
+
+namespace session
+{
+    session_t::session_t(const QString &p, const chipinfo::chipinfo &chip, progress_t *progress) : port_name(p), chip_info(chip), prog(port_name, chip), progress(progress)
+    {
+	prog.set_callback(&session_t::callback, this);
+    }
+
+    bool session_t::callback(void *p, int i, int max_i)
+    {
+	session_t *const s = static_cast<session_t*>(p);
+	return s->progress ? s->progress->progress(i, max_i) : true;
+    }
+
+    bool session_t::fail(const QString &message)
+    {
+	error_string = message;
+	return false;
+    }
+
+    void session_t::stage(const char *label)
+    {
+	if( progress )
+	    progress->stage(label);
+    }
+
+    bool session_t::reset()
+    {
+	if( !prog.hard_reset() )
+	{
+	    //Try assuming that the programmer is a Kit149
+	    prog.set_149();
+	    if( !prog.hard_reset() )
+		return fail("Could not reset programmer");
+	}
+
+	//Enter command mode
+	if( !prog.command_mode() )
+	    return fail("Could not enter Command Mode");
+	return true;
+    }
+
+    bool session_t::open()
+    {
+	if( coretraits::family(chip_info.core_type) == coretraits::CORE_UNKNOWN )
+	    return fail(QString("%1 has an unknown core type").arg(chip_info.name.c_str()));
+	if( !prog.valid() )
+	    return fail(QString("Bad port name %1, network ports look like " RFC2217_PREFIX "host:port").arg(port_name));
+	if( !prog.open() )
+	    return fail(QString("Could not open serial port %1").arg(port_name));
+
+	if( !reset() )
+	    return false;
+
+	//Check the protocol version
+	const std::string protocol = prog.get_protocol();
+	if( (protocol != "P018") && (protocol != "P18A") )
+	    return fail(QString("Wrong protocol version ( %1 )").arg(QString(protocol.c_str())));
+
+	prog.init_program_vars();	//Initialize programming variables
+	return true;
+    }
+
+    bool session_t::recover()
+    {
+	if( !reset() )
+	    return false;
+	prog.init_program_vars();
+	return true;
+    }
+
+    bool session_t::wait_for_socket(bool inserted, unsigned interval)
+    {
+	if( !prog.start_socket_wait(inserted) )
+	{
+	    recover();
+	    return fail("Programmer didn't start watching the socket");
+	}
+
+	for(;;)
+	{
+	    const int state = prog.poll_socket();
+	    if( state > 0 )
+		return true;
+	    if( state < 0 )
+	    {
+		recover();
+		return fail("Error watching the socket");
+	    }
+	    if( progress && !progress->progress(0, 0) )
+	    {
+		recover();	// The programmer is still waiting
+		return fail("Cancelled");
+	    }
+	    kitsrus::msleep(interval);
+	}
+    }
+
+    const chipinfo::chipinfo* session_t::detect()
+    {
+	stage("Detecting Target");
+	const chipinfo::chipinfo *const device = chipdetect::detect(prog, chip_info);
+	if( !device )
+	{
+	    fail("Could not identify the chip in the socket");
+	    return NULL;
+	}
+	chip_info = *device;
+	return device;
+    }
+
+    bool session_t::erase()
+    {
+	if( !prog.erase_chip() )
+	    return fail("Could not erase part");
+	prog.chip_power_off();		//Turn the chip off
+	return true;
+    }
+
+    bool session_t::write_rom(const chipimage::chipimage_t &image, kitsrus::kitsrus_t::rom_size_type size)
+    {
+	prog.chip_power_on();		//Activate programming voltages
+	if( !prog.write_rom(image, size) )
+	{
+	    prog.hard_reset();		//Do a hard reset to clear the error and turn power off
+	    return fail("Error programming ROM");
+	}
+	prog.chip_power_off();		//Turn the chip off
+	return true;
+    }
+
+    bool session_t::write_config(const chipimage::chipimage_t &image)
+    {
+	prog.chip_power_on();		//Activate programming voltages
+	if( !prog.write_config(image) )
+	{
+	    prog.hard_reset();		//Do a hard reset to clear the error and turn power off
+	    return fail("Error programming config");
+	}
+	prog.chip_power_off();		//Turn the chip off
+	return true;
+    }
+
+    bool session_t::write_eeprom(const chipimage::chipimage_t &image, kitsrus::kitsrus_t::eeprom_size_type size)
+    {
+	prog.chip_power_on();		//Activate programming voltages
+	if( !prog.write_eeprom(image, size) )
+	{
+	    prog.hard_reset();		//Do a hard reset to clear the error and turn power off
+	    return fail("Error programming EEPROM");
+	}
+	prog.chip_power_off();		//Turn the chip off
+	return true;
+    }
+
+    bool session_t::write(const chipimage::chipimage_t &image, const chipimage::chipimage_t *previous, bool erase_first)
+    {
+	// Writing without an erase can only clear bits, so a change that sets
+	//  any has to start over from an erased chip. Data EEPROM is erased a
+	//  byte at a time as it's written, so it doesn't count.
+	if( previous && (imagediff::sets_bits(image, *previous, chipimage::ROM)
+			 || imagediff::sets_bits(image, *previous, chipimage::ID)
+			 || imagediff::sets_bits(image, *previous, chipimage::CONFIG)) )
+	{
+	    previous = NULL;
+	    erase_first = true;
+	}
+
+	imagediff::changes_t    changes;
+	if( previous )
+	    imagediff::diff(image, *previous, changes);
+
+	if( erase_first && !erase() )
+	    return false;
+
+	//  For some reason config has to be written first or the programmer locks up
+	if( !previous || imagediff::extent(changes, chipimage::ID) || imagediff::extent(changes, chipimage::CONFIG) )
+	{
+	    stage("Writing Config");
+	    if( !write_config(image) )
+		return false;
+	}
+
+	const chipimage::chipimage_t::size_type eeprom_size = previous ? imagediff::extent(changes, chipimage::EEPROM) : image.used(chipimage::EEPROM);
+	if( eeprom_size )
+	{
+	    stage("Writing EEPROM");
+	    if( !write_eeprom(image, eeprom_size) )
+		return false;
+	}
+
+	const chipimage::chipimage_t::size_type rom_size = previous ? imagediff::extent(changes, chipimage::ROM) : image.used(chipimage::ROM);
+	if( rom_size )
+	{
+	    stage("Writing ROM");
+	    if( !write_rom(image, rom_size) )
+		return false;
+	}
+	return true;
+    }
+
+    template<typename T> bool session_t::read_rom(T &sink)
+    {
+	prog.chip_power_on();		//Activate programming voltages
+	if( !prog.read_rom(sink) )
+	{
+	    prog.hard_reset();		//Do a hard reset to clear the error and turn power off
+	    return fail("Error reading ROM");
+	}
+	prog.chip_power_off();		//Turn the chip off
+	return true;
+    }
+
+    template<typename T> bool session_t::read_config(T &sink)
+    {
+	prog.chip_power_on();		//Activate programming voltages
+	if( !prog.read_config(sink) )
+	{
+	    prog.hard_reset();		//Do a hard reset to clear the error and turn power off
+	    return fail("Error reading config");
+	}
+	prog.chip_power_off();		//Turn the chip off
+	return true;
+    }
+
+    template<typename T> bool session_t::read_eeprom(T &sink)
+    {
+	prog.chip_power_on();		//Activate programming voltages
+	if( !prog.read_eeprom(sink) )
+	{
+	    prog.hard_reset();		//Do a hard reset to clear the error and turn power off
+	    return fail("Error reading EEPROM");
+	}
+	prog.chip_power_off();		//Turn the chip off
+	return true;
+    }
+
+    template<typename T> bool session_t::read_all(T &sink)
+    {
+	stage("Reading ROM");
+	if( !read_rom(sink) )
+	    return false;
+
+	stage("Reading Config");
+	if( !read_config(sink) )
+	    return false;
+
+	stage("Reading EEPROM");
+	return read_eeprom(sink);
+    }
+
+    bool session_t::read(hexwriter::hexwriter_t &writer)    { return read_all(writer);	}
+    bool session_t::read(chipimage::chipimage_t &image)	    { return read_all(image);	}
+
+    // Read straight into a dense image that's kept between reads, so that
+    //	repeated verifies of the same part don't allocate anything
+    bool session_t::read_back(chipimage::chipimage_t &readback)
+    {
+	if( readback.matches(chip_info) )
+	    readback.reset();
+	else
+	    readback.clear(chip_info);
+	return read(readback);
+    }
+
+    bool session_t::verify(const chipimage::chipimage_t &image, chipimage::chipimage_t &readback, imagediff::changes_t &changes)
+    {
+	if( !read_back(readback) )
+	    return false;
+
+	// ID isn't compared because the file usually doesn't have one
+	imagediff::diff(image, readback, chipimage::ROM, changes);
+	imagediff::diff(image, readback, chipimage::EEPROM, changes);
+	imagediff::diff_config(chip_info, image, readback, changes);
+	return true;
+    }
+
+    bool session_t::blank_check(chipimage::chipimage_t &readback, imagediff::changes_t &changes)
+    {
+	if( !read_back(readback) )
+	    return false;
+
+	chipimage::chipimage_t	blank;
+	blank.clear(chip_info);
+	imagediff::diff(blank, readback, chipimage::ROM, changes);
+	imagediff::diff(blank, readback, chipimage::EEPROM, changes);
+	return true;
+    }
+}
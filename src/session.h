@@ -0,0 +1,107 @@
+/*  A programming session with one programmer and one target
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	SESSION_H
+#define	SESSION_H
+
+#include <QString>
+
+#include "chipimage.h"
+#include "chipinfo.h"
+#include "hexwriter.h"
+#include "imagediff.h"
+#include "kitsrus.h"
+
+namespace session
+{
+    // Receives a session's progress. The defaults ignore it.
+    class progress_t
+    {
+    public:
+	virtual ~progress_t() {}
+	virtual void	stage(const char *) {}	// What's being done now
+	// Return false to cancel
+	virtual bool	progress(int, int) { return true;	}
+    };
+
+    // The sequences of programmer commands that make up each operation, with
+    //	no user interface. The GUI and the command line both drive the
+    //	programmer through one of these.
+    //
+    //	Every operation returns false on failure, and error() says why. Chip
+    //	power is turned off after each step, and a failed step is followed by
+    //	a hard reset to get the programmer back to a known state.
+    class session_t
+    {
+    public:
+	session_t(const QString &port, const chipinfo::chipinfo &, progress_t *progress = NULL);
+
+	// Open the port, reset the programmer, check its protocol and set it up for the target
+	bool	open();
+
+	// Identify the chip in the socket (see chipdetect) and make it the
+	//  target. Returns NULL if it couldn't be identified.
+	const chipinfo::chipinfo*   detect();
+
+	bool	erase();
+	// Wait for a chip to be put in the socket, or taken out, checking every
+	//  interval milliseconds. The progress callback gets (0, 0) after each
+	//  check, and returning false from it cancels the wait.
+	bool	wait_for_socket(bool inserted, unsigned interval);
+	// Get the programmer back to command mode, set up for the target, after
+	//  a step has failed or been cancelled
+	bool	recover();
+	// If a previous image is given only the parts of image that differ
+	//  from it are written. The programmer always writes ROM and EEPROM
+	//  from the start of the region, so "differ" means "up to the last
+	//  changed byte". If a change needs a bit turned back on, the chip is
+	//  erased and all of image is written instead.
+	bool	write(const chipimage::chipimage_t &image, const chipimage::chipimage_t *previous = NULL, bool erase_first = false);
+	bool	read(hexwriter::hexwriter_t &);
+	bool	read(chipimage::chipimage_t &);
+	// Read the chip into readback, which is reused if it's already the
+	//  right shape, and list the blocks where the ROM, EEPROM and config
+	//  differ from image. Only the config words that image sets are
+	//  compared, in the bits that the chip implements. Returns false only
+	//  if the read fails.
+	bool	verify(const chipimage::chipimage_t &image, chipimage::chipimage_t &readback, imagediff::changes_t &);
+	// Like verify(), but against a blank image. Config isn't checked
+	//  because a blank image doesn't have the real config blank values.
+	bool	blank_check(chipimage::chipimage_t &readback, imagediff::changes_t &);
+
+	int	firmware()  { return prog.get_version();	}  // One of the KIT_ values
+	const transport::latency_t*	latency() const { return prog.latency();	}
+	const chipinfo::chipinfo&   chip() const { return chip_info;	}
+	const QString&	port() const { return port_name;	}
+	const QString&	error() const { return error_string;	}
+
+    private:
+	QString	port_name;
+	chipinfo::chipinfo  chip_info;
+	kitsrus::kitsrus_t  prog;
+	progress_t	*progress;
+	QString	error_string;
+
+	session_t(const session_t &);	// No copy
+
+	bool	fail(const QString &);
+	bool	reset();
+	void	stage(const char *);
+	template<typename T> bool   read_all(T &);
+	bool	read_back(chipimage::chipimage_t &);
+	template<typename T> bool   read_rom(T &);
+	template<typename T> bool   read_config(T &);
+	template<typename T> bool   read_eeprom(T &);
+	bool	write_rom(const chipimage::chipimage_t &, kitsrus::kitsrus_t::rom_size_type);
+	bool	write_config(const chipimage::chipimage_t &);
+	bool	write_eeprom(const chipimage::chipimage_t &, kitsrus::kitsrus_t::eeprom_size_type);
+
+	static bool	callback(void *, int, int);
+    };
+}
+
+#endif	// SESSION_H
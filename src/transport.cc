@@ -0,0 +1,405 @@
+/*  Byte streams to a programmer: a local serial port or a network bridge
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <math.h>
+#include <string.h>
+
+#ifdef	Q_WS_WIN
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif	//Q_WS_WIN
+
+#include <QByteArray>
+#include <QTcpSocket>
+
+#include "iothread.h"
+#include "qextserialport.h"
+#include "transport.h"
+
+// Milliseconds
+#define	TCP_CONNECT_TIMEOUT	5000
+#define	TCP_READ_TIMEOUT	10000	// Serial reads never time out, but a network can go away
+
+// Telnet (RFC 854) and COM-PORT-OPTION (RFC 2217) codes
+#define	TELNET_IAC	255
+#define	TELNET_DONT	254
+#define	TELNET_DO	253
+#define	TELNET_WONT	252
+#define	TELNET_WILL	251
+#define	TELNET_SB	250
+#define	TELNET_SE	240
+#define	TELOPT_BINARY	0
+#define	TELOPT_COM_PORT	44
+#define	COM_SET_BAUDRATE    1
+#define	COM_SET_DATASIZE    2
+#define	COM_SET_PARITY	    3
+#define	COM_SET_STOPSIZE    4
+#define	COM_SET_CONTROL	    5
+#define	COM_PARITY_NONE	    1
+#define	COM_STOPSIZE_1	    1
+#define	COM_CONTROL_NO_FLOW 1
+#define	COM_CONTROL_DTR_ON  8
+#define	COM_CONTROL_DTR_OFF 9
+
+namespace transport
+{
+    double now()
+    {
+#ifdef	Q_WS_WIN
+	LARGE_INTEGER	count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return 1e6 * count.QuadPart / frequency.QuadPart;
+#else
+	struct timeval	tv;
+	gettimeofday(&tv, NULL);
+	return 1e6*tv.tv_sec + tv.tv_usec;
+#endif	//Q_WS_WIN
+    }
+
+    void latency_t::add(double us)
+    {
+	if( !count || (us < min) )
+	    min = us;
+	if( !count || (us > max) )
+	    max = us;
+	sum += us;
+	sum_squares += us*us;
+	++count;
+    }
+
+    double latency_t::jitter() const
+    {
+	if( count < 2 )
+	    return 0;
+	const double variance = (sum_squares - sum*sum/count) / (count - 1);
+	return (variance > 0) ? sqrt(variance) : 0;
+    }
+
+    // A local serial port, at the programmer's 19200 8N1. Writes go straight
+    //	out, so a round trip is timed from the write to the first byte read.
+    class serial_t : public transport_t
+    {
+    public:
+	serial_t(const QString &port) : com(port), sent(0)
+	{
+	    com.setBaudRate(BAUD19200);
+	    com.setDataBits(DATA_8);
+	    com.setParity(PAR_NONE);
+	    com.setStopBits(STOP_1);
+	    com.setFlowControl(FLOW_OFF);
+	    com.setTimeout(0,0);
+	}
+
+	virtual bool	open()	{ return com.open(QIODevice::ReadWrite) ? true : false;	}
+	virtual void	close()	{ com.close(); sent = 0;	}
+	virtual bool	write(const char *data, size_t length)
+	{
+	    if( !sent )
+		sent = now();
+	    return com.write(data, length) == (qint64)length;
+	}
+	virtual int	read(char *data, size_t length)
+	{
+	    size_t  count = 0;
+	    while( count < length )
+	    {
+		const qint64 n = com.read(data + count, length - count);
+		if( n <= 0 )
+		    break;
+		if( sent )
+		{
+		    round_trip.add(now() - sent);
+		    sent = 0;
+		}
+		count += n;
+	    }
+	    return count;
+	}
+	virtual int	available()
+	{
+	    const qint64 n = com.bytesAvailable();
+	    return (n > 0) ? n : 0;
+	}
+	virtual bool	set_dtr(bool on)    { com.setDtr(on); return true;	}
+#ifndef	Q_WS_WIN
+	virtual int	descriptor()	{ return com.isOpen() ? com.handle() : -1;	}
+#endif	//Q_WS_WIN
+	virtual const latency_t*    latency() const { return &round_trip;	}
+
+    private:
+	QextSerialPort	com;
+	latency_t   round_trip;
+	double	sent;		// When a write went out that hasn't been answered yet, or 0
+    };
+
+    // A serial port on another machine, through a bridge that speaks telnet
+    //	with the COM-PORT-OPTION extension (RFC 2217). DTR is set with
+    //	SET-CONTROL, in band.
+    //
+    //	The programmer's protocol is a lot of small writes, each followed by
+    //	an ack, and a round trip over a network costs much more than one over
+    //	a serial cable. So Nagle's algorithm is turned off (TCP_NODELAY), and
+    //	writes are collected until something has to be read, so that each
+    //	command and its arguments, or a whole block of data, is one packet.
+    //
+    //	That's as far as it goes: the next ROM or EEPROM block can't be sent
+    //	ahead of the 'Y' for the last one. The programmer has no flow control
+    //	and only a few bytes of UART buffer, and it doesn't read while it's
+    //	programming, so anything sent early is lost. Each block costs a full
+    //	network round trip (tests/rfc2217.cc measures it). Round trips are
+    //	timed from the flush() that sends written data to the first byte of
+    //	data that comes back.
+    class rfc2217_t : public transport_t
+    {
+    public:
+	rfc2217_t(const QString &h, quint16 p) : host(h), port(p), socket(NULL), state(DATA), verb(0), written(false), sent(0) {}
+	~rfc2217_t() { close();	}
+
+	virtual bool	open();
+	virtual void	close();
+	virtual bool	write(const char *, size_t);
+	virtual int	read(char *, size_t);
+	virtual int	available();
+	virtual bool	flush();
+	virtual bool	set_dtr(bool);
+	virtual const latency_t*    latency() const { return &round_trip;	}
+
+    private:
+	// Where the telnet parser is
+	enum state_t { DATA, GOT_IAC, GOT_VERB, IN_SB, SB_IAC };
+
+	QString	host;
+	quint16	port;
+	QTcpSocket  *socket;	// Made by open(), so that it belongs to the thread that uses it
+	QByteArray  output;	// Written, escaped, but not yet sent
+	QByteArray  input;	// Received, with the telnet commands taken out
+	state_t	state;
+	uint8_t	verb;		// The WILL, WONT, DO or DONT that's waiting for its option
+	bool	written;	// output has data in it, and not just telnet commands
+	latency_t   round_trip;
+	double	sent;		// When data went out that hasn't been answered yet, or 0
+
+	void	negotiate(uint8_t verb, uint8_t option);
+	void	subnegotiate(uint8_t command, const uint8_t *value, size_t length);
+	bool	receive(int timeout);
+	void	filter(const QByteArray &);
+    };
+
+    bool rfc2217_t::open()
+    {
+	close();
+	socket = new QTcpSocket;
+	socket->connectToHost(host, port);
+	if( !socket->waitForConnected(TCP_CONNECT_TIMEOUT) )
+	{
+	    close();
+	    return false;
+	}
+	socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+	negotiate(TELNET_WILL, TELOPT_BINARY);
+	negotiate(TELNET_DO, TELOPT_BINARY);
+	negotiate(TELNET_WILL, TELOPT_COM_PORT);
+
+	const uint8_t baud[] = {0, 0, 19200 >> 8, 19200 & 0xFF};
+	const uint8_t data_size = 8;
+	const uint8_t parity = COM_PARITY_NONE;
+	const uint8_t stop_size = COM_STOPSIZE_1;
+	const uint8_t control = COM_CONTROL_NO_FLOW;
+	subnegotiate(COM_SET_BAUDRATE, baud, sizeof(baud));
+	subnegotiate(COM_SET_DATASIZE, &data_size, 1);
+	subnegotiate(COM_SET_PARITY, &parity, 1);
+	subnegotiate(COM_SET_STOPSIZE, &stop_size, 1);
+	subnegotiate(COM_SET_CONTROL, &control, 1);
+	return flush();
+    }
+
+    void rfc2217_t::close()
+    {
+	if( !socket )
+	    return;
+	flush();
+	socket->disconnectFromHost();
+	delete socket;
+	socket = NULL;
+	output.clear();
+	input.clear();
+	state = DATA;
+	written = false;
+	sent = 0;
+    }
+
+    void rfc2217_t::negotiate(uint8_t verb, uint8_t option)
+    {
+	output.append((char)TELNET_IAC);
+	output.append((char)verb);
+	output.append((char)option);
+    }
+
+    void rfc2217_t::subnegotiate(uint8_t command, const uint8_t *value, size_t length)
+    {
+	output.append((char)TELNET_IAC);
+	output.append((char)TELNET_SB);
+	output.append((char)TELOPT_COM_PORT);
+	output.append((char)command);
+	for(size_t i=0; i < length; ++i)
+	{
+	    output.append((char)value[i]);
+	    if( value[i] == TELNET_IAC )
+		output.append((char)TELNET_IAC);
+	}
+	output.append((char)TELNET_IAC);
+	output.append((char)TELNET_SE);
+    }
+
+    bool rfc2217_t::write(const char *data, size_t length)
+    {
+	if( !socket )
+	    return false;
+	for(size_t i=0; i < length; ++i)
+	{
+	    output.append(data[i]);
+	    if( (uint8_t)data[i] == TELNET_IAC )    // Escape data that looks like a command
+		output.append(data[i]);
+	}
+	written = written || length;
+	return true;
+    }
+
+    bool rfc2217_t::flush()
+    {
+	if( !socket )
+	    return false;
+	if( output.isEmpty() )
+	    return true;
+	if( written && !sent )
+	    sent = now();
+	written = false;
+	const bool success = (socket->write(output) == output.size()) && socket->waitForBytesWritten(TCP_READ_TIMEOUT);
+	output.clear();
+	return success;
+    }
+
+    bool rfc2217_t::set_dtr(bool on)
+    {
+	if( !socket )
+	    return false;
+	const uint8_t control = on ? COM_CONTROL_DTR_ON : COM_CONTROL_DTR_OFF;
+	subnegotiate(COM_SET_CONTROL, &control, 1);
+	return flush();
+    }
+
+    // Wait up to timeout milliseconds for more data
+    bool rfc2217_t::receive(int timeout)
+    {
+	if( !flush() )
+	    return false;
+	if( (socket->bytesAvailable() <= 0) && !socket->waitForReadyRead(timeout) )
+	    return false;
+	filter(socket->readAll());
+	if( sent && !input.isEmpty() )
+	{
+	    round_trip.add(now() - sent);
+	    sent = 0;
+	}
+	return true;
+    }
+
+    // Separate the data from the telnet commands. Anything the bridge offers
+    //	or asks for, other than what open() asked for, is refused.
+    void rfc2217_t::filter(const QByteArray &bytes)
+    {
+	for(int i=0; i < bytes.size(); ++i)
+	{
+	    const uint8_t c = bytes[i];
+	    switch( state )
+	    {
+		case DATA:
+		    if( c == TELNET_IAC )
+			state = GOT_IAC;
+		    else
+			input.append((char)c);
+		    break;
+		case GOT_IAC:
+		    if( c == TELNET_IAC )
+		    {
+			input.append((char)c);
+			state = DATA;
+		    }
+		    else if( (c >= TELNET_WILL) && (c <= TELNET_DONT) )
+		    {
+			verb = c;
+			state = GOT_VERB;
+		    }
+		    else
+			state = (c == TELNET_SB) ? IN_SB : DATA;
+		    break;
+		case GOT_VERB:
+		    if( (c != TELOPT_BINARY) && (c != TELOPT_COM_PORT) )
+		    {
+			if( verb == TELNET_DO )
+			    negotiate(TELNET_WONT, c);
+			else if( verb == TELNET_WILL )
+			    negotiate(TELNET_DONT, c);
+		    }
+		    state = DATA;
+		    break;
+		case IN_SB:		// Replies to SET-CONTROL and friends aren't needed
+		    if( c == TELNET_IAC )
+			state = SB_IAC;
+		    break;
+		case SB_IAC:
+		    state = (c == TELNET_SE) ? DATA : IN_SB;
+		    break;
+	    }
+	}
+    }
+
+    int rfc2217_t::read(char *data, size_t length)
+    {
+	if( !socket )
+	    return -1;
+	while( ((size_t)input.size() < length) && receive(TCP_READ_TIMEOUT) )
+	    ;
+	const int count = qMin((size_t)input.size(), length);
+	memcpy(data, input.constData(), count);
+	input.remove(0, count);
+	return count;
+    }
+
+    int rfc2217_t::available()
+    {
+	if( !socket )
+	    return 0;
+	receive(0);
+	return input.size();
+    }
+
+    transport_t* create(const QString &port)
+    {
+	// The network bridge already waits for data without blocking a read()
+	if( io_options.enabled && !port.startsWith(RFC2217_PREFIX) )
+	    return new threaded_t(port, io_options);
+	return direct(port);
+    }
+
+    transport_t* direct(const QString &port)
+    {
+	if( !port.startsWith(RFC2217_PREFIX) )
+	    return new serial_t(port);
+
+	const QString address = port.mid(strlen(RFC2217_PREFIX));
+	const int colon = address.lastIndexOf(':');
+	bool valid = false;
+	const quint16 number = (colon > 0) ? address.mid(colon + 1).toUShort(&valid) : 0;
+	if( !valid || !number )
+	    return NULL;
+	return new rfc2217_t(address.left(colon), number);
+    }
+}
@@ -0,0 +1,73 @@
+/*  Byte streams to a programmer: a local serial port or a network bridge
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	TRANSPORT_H
+#define	TRANSPORT_H
+
+#include <stddef.h>
+
+#include <QString>
+
+// Prefix of a port name that's an RFC 2217 (telnet COM port control) bridge,
+//  like ser2net in telnet mode. The rest is host:port.
+#define	RFC2217_PREFIX	"rfc2217://"
+
+namespace transport
+{
+    // Time from writing a command to the first byte of the reply, in
+    //	microseconds
+    struct latency_t
+    {
+	unsigned    count;
+	double	min;
+	double	max;
+	double	sum;
+	double	sum_squares;
+	latency_t() : count(0), min(0), max(0), sum(0), sum_squares(0) {}
+
+	void	add(double);
+	double	mean() const    { return count ? sum/count : 0;	}
+	double	jitter() const;	// Standard deviation
+    };
+
+    // Microseconds from some arbitrary time, for measuring round trips
+    double  now();
+
+    // The connection to a programmer, and its DTR line
+    class transport_t
+    {
+    public:
+	virtual ~transport_t() {}
+
+	virtual bool	open() = 0;
+	virtual void	close() = 0;
+	// Writes can be held back until the next read(), available(), flush()
+	//  or close(), so that a command and its arguments go out together
+	virtual bool	write(const char *, size_t) = 0;
+	// Blocks until length bytes have arrived. Returns how many were read,
+	//  which is less than length only on an error or a timeout.
+	virtual int	read(char *, size_t length) = 0;
+	// How many bytes can be read without blocking
+	virtual int	available() = 0;
+	virtual bool	flush() { return true;	}
+	virtual bool	set_dtr(bool) = 0;
+	// Something poll() can wait on while the transport is open, or -1
+	virtual int	descriptor()	{ return -1;	}
+	// Command to reply times. NULL if the transport doesn't keep track.
+	virtual const latency_t*    latency() const { return NULL;	}
+    };
+
+    // A transport for a port name. Names that start with RFC2217_PREFIX are
+    //	network bridges, and anything else is a serial port. Serial ports get
+    //	their own I/O thread if io_options (see iothread.h) says so. Returns
+    //	NULL for a bridge name without a host and a port number.
+    transport_t*    create(const QString &port);
+    // Like create(), but never with an I/O thread
+    transport_t*    direct(const QString &port);
+}
+
+#endif	// TRANSPORT_H
@@ -0,0 +1,76 @@
+/*  Rewriting a part with only what changed
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include "imagediff.h"
+#include "session.h"
+#include "tests.h"
+
+// Write image over previous, which the part already holds, and check that the
+//  part was erased the expected number of times and ends up holding image
+static bool rewrite(const char *test, emulator::pty_t &pty, const emulator::programmer_t &programmer, const chipimage::chipimage_t &image, const chipimage::chipimage_t &previous, unsigned erases)
+{
+    {
+	session::session_t	s(pty.name(), tests::part());
+	if( !s.open() )
+	    return tests::fail(test, s.error());
+	if( !s.write(image, &previous) )
+	    return tests::fail(test, s.error());
+    }
+
+    pty.stop();
+    if( programmer.erases != erases )
+	return tests::fail(test, QString("The part was erased %1 times, not %2").arg(programmer.erases).arg(erases));
+    QString why;
+    if( !tests::holds(programmer, image, why) )
+	return tests::fail(test, why);
+    return pty.open() || tests::fail(test, "Couldn't reopen the pseudo-terminal");
+}
+
+namespace tests
+{
+    // Program a part, then change some of it the way an edit to a watched
+    //	file would. Changes that only clear bits have to be written without
+    //	an erase. One that sets a bit has to erase and start over.
+    bool differential()
+    {
+	const char *const test = "differential";
+
+	emulator::programmer_t	programmer(emulated());
+	emulator::pty_t	pty(programmer);
+	if( !pty.open() )
+	    return fail(test, "Couldn't make a pseudo-terminal");
+
+	const chipimage::chipimage_t image = pattern();
+	{
+	    session::session_t	s(pty.name(), part());
+	    if( !s.open() )
+		return fail(test, s.error());
+	    if( !s.write(image, NULL, true) )
+		return fail(test, s.error());
+	}
+
+	// Clear bits in a few ROM words and change some EEPROM
+	chipimage::chipimage_t	cleared(image);
+	for(unsigned i=0x100; i < 0x110; ++i)
+	    cleared.set(chipimage::ROM, i, image.get(chipimage::ROM, i) & 0x0F);
+	for(unsigned i=0; i < 8; ++i)
+	    cleared.set(chipimage::EEPROM, i, ~image.get(chipimage::EEPROM, i));
+	if( imagediff::sets_bits(cleared, image, chipimage::ROM) )
+	    return fail(test, "The cleared image sets ROM bits");
+	if( !rewrite(test, pty, programmer, cleared, image, 1) )
+	    return false;
+
+	// Put one of them back
+	chipimage::chipimage_t	restored(cleared);
+	restored.set(chipimage::ROM, 0x100, image.get(chipimage::ROM, 0x100) | 0x30);
+	if( !rewrite(test, pty, programmer, restored, cleared, 2) )
+	    return false;
+
+	pty.stop();
+	return true;
+    }
+}
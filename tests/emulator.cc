@@ -0,0 +1,528 @@
+/*  A Kitsrus programmer in software, for testing without hardware
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "emulator.h"
+#include "kitsrus.h"	// For the CMD_ values
+
+#define	BLANK_WORD_LO	0xFF	// An erased 14-bit word, low byte first
+#define	BLANK_WORD_HI	0x3F
+#define	ROM_BLOCK_SIZE	32	// Bytes sent for each 'Y' during CMD_WRITE_ROM
+#define	CONFIG_FRAME	22	// 4 ID bytes, 4 'F' bytes, then 7 config words
+
+// Telnet (RFC 854) and COM-PORT-OPTION (RFC 2217) codes
+#define	TELNET_IAC	255
+#define	TELNET_WILL	251
+#define	TELNET_DONT	254
+#define	TELNET_SB	250
+#define	TELNET_SE	240
+#define	TELOPT_COM_PORT	44
+#define	COM_SET_CONTROL	    5
+#define	COM_CONTROL_DTR_ON  8
+#define	COM_CONTROL_DTR_OFF 9
+
+namespace emulator
+{
+    programmer_t::programmer_t(uint8_t f, uint16_t c, unsigned rom_words, unsigned eeprom_bytes) : rom(2*rom_words), eeprom(eeprom_bytes), id(4), config(14), resets(0), erases(0), blocks(0), firmware(f), chip_id(c), phase(POWER_ON), command(0), expected(0), offset(0), size(0), read_rom(0), read_eeprom(0)
+    {
+	erase();
+	erases = 0;
+    }
+
+    void programmer_t::reset()
+    {
+	++resets;
+	phase = POWER_ON;
+	output.clear();
+	reply('B');
+	reply(firmware);
+    }
+
+    void programmer_t::receive(const char *data, size_t length)
+    {
+	for(size_t i=0; i < length; ++i)
+	{
+	    const uint8_t c = data[i];
+	    switch( phase )
+	    {
+		case POWER_ON:	// Only 'P' does anything until command mode
+		    if( c == 'P' )
+		    {
+			reply('P');
+			phase = COMMAND;
+		    }
+		    break;
+		case COMMAND:
+		    start(c);
+		    break;
+		case ARGUMENTS:
+		    args.push_back(c);
+		    if( --expected == 0 )
+			run();
+		    break;
+		case ROM_BLOCK:
+		case EEPROM_PAIR:
+		    args.push_back(c);
+		    if( --expected == 0 )
+			block();
+		    break;
+	    }
+	}
+    }
+
+    QByteArray programmer_t::take()
+    {
+	QByteArray  taken(output);
+	output.clear();
+	return taken;
+    }
+
+    // Start a command, or run it now if it doesn't have any arguments
+    void programmer_t::start(uint8_t c)
+    {
+	command = c;
+	args.clear();
+	switch( c )
+	{
+	    case CMD_ECHO:	    expected = 1;		    break;
+	    case CMD_INITVAR:	    expected = 11;		    break;
+	    case CMD_WRITE_ROM:
+	    case CMD_WRITE_EEPROM:  expected = 2;		    break;
+	    case CMD_WRITE_CONFIG:
+	    case CMD_WRITE_FUSE:    expected = 2 + CONFIG_FRAME;    break;
+	    default:		    expected = 0;		    break;
+	}
+	if( expected )
+	    phase = ARGUMENTS;
+	else
+	    run();
+    }
+
+    void programmer_t::run()
+    {
+	phase = COMMAND;
+	switch( command )
+	{
+	    case CMD_RESET:	// Back to waiting for 'P'
+		reply('Q');
+		phase = POWER_ON;
+		break;
+	    case CMD_ECHO:
+		reply(args[0]);
+		break;
+	    case CMD_INITVAR:
+		read_rom = 2*((args[0] << 8) | args[1]);
+		read_eeprom = (args[2] << 8) | args[3];
+		reply('I');
+		break;
+	    case CMD_VPP_ON:
+	    case CMD_VPP_CYCLE:
+		reply('V');
+		break;
+	    case CMD_VPP_OFF:
+		reply('v');
+		break;
+	    case CMD_WRITE_ROM:	// The size is in words
+		size = 2*((args[0] << 8) | args[1]);
+		offset = 0;
+		expected = ROM_BLOCK_SIZE;
+		args.clear();
+		phase = ROM_BLOCK;
+		reply('Y');
+		break;
+	    case CMD_WRITE_EEPROM:
+		size = (args[0] << 8) | args[1];
+		offset = 0;
+		expected = 2;
+		args.clear();
+		phase = EEPROM_PAIR;
+		reply('Y');
+		break;
+	    case CMD_WRITE_CONFIG:
+	    case CMD_WRITE_FUSE:	// args[0] and args[1] are the two '0's
+		for(unsigned i=0; i < 4; ++i)
+		    id[i] &= args[2 + i];
+		for(unsigned i=0; i < config.size(); ++i)
+		    program(config, i, args[10 + i]);
+		reply('Y');
+		break;
+	    case CMD_READ_ROM:
+		for(unsigned i=0; i < read_rom; ++i)
+		    reply( (i < rom.size()) ? rom[i] : ((i & 1) ? BLANK_WORD_HI : BLANK_WORD_LO) );
+		break;
+	    case CMD_READ_EEPROM:
+		for(unsigned i=0; i < read_eeprom; ++i)
+		    reply( (i < eeprom.size()) ? eeprom[i] : 0xFF );
+		break;
+	    case CMD_READ_CONFIG:   // Chip ID, 4 ID bytes, 4 unused, then config and padding
+		reply('C');
+		reply(chip_id & 0xFF);
+		reply(chip_id >> 8);
+		for(unsigned i=0; i < 4; ++i)
+		    reply(id[i]);
+		for(unsigned i=0; i < 4; ++i)
+		    reply(0xFF);
+		for(unsigned i=0; i < config.size(); ++i)
+		    reply(config[i]);
+		reply(0xFF);
+		reply(0xFF);
+		break;
+	    case CMD_ERASE:
+		erase();
+		reply('Y');
+		break;
+	    case CMD_IN_SOCKET:	    // The part is already there, and stays there
+	    case CMD_NOT_IN_SOCKET:
+		reply('A');
+		reply('Y');
+		break;
+	    case CMD_GET_VERSION:
+		reply(firmware);
+		break;
+	    case CMD_GET_PROTOCOL:
+		output.append("P018");
+		break;
+	    default:		// Anything else is ignored
+		break;
+	}
+    }
+
+    // A block of a ROM or EEPROM write has arrived. 'P' says that was the last one.
+    void programmer_t::block()
+    {
+	++blocks;
+	for(unsigned i=0; i < args.size(); ++i, ++offset)
+	{
+	    if( phase == EEPROM_PAIR )
+	    {
+		if( offset < eeprom.size() )	// EEPROM erases itself as it goes
+		    eeprom[offset] = args[i];
+	    }
+	    else if( offset < rom.size() )
+		program(rom, offset, args[i]);
+	}
+	args.clear();
+
+	if( offset >= size )
+	{
+	    phase = COMMAND;
+	    reply('P');
+	    return;
+	}
+	expected = (phase == EEPROM_PAIR) ? 2 : ROM_BLOCK_SIZE;
+	reply('Y');
+    }
+
+    void programmer_t::erase()
+    {
+	++erases;
+	for(unsigned i=0; i < rom.size(); ++i)
+	    rom[i] = (i & 1) ? BLANK_WORD_HI : BLANK_WORD_LO;
+	for(unsigned i=0; i < config.size(); ++i)
+	    config[i] = (i & 1) ? BLANK_WORD_HI : BLANK_WORD_LO;
+	id.assign(id.size(), 0xFF);
+	eeprom.assign(eeprom.size(), 0xFF);
+    }
+
+    // Programming flash can only clear bits, and the high byte of a word only has 6 of them
+    void programmer_t::program(std::vector<uint8_t> &memory, unsigned i, uint8_t value)
+    {
+	memory[i] &= (i & 1) ? (value & BLANK_WORD_HI) : value;
+    }
+
+    rfc2217_server_t::rfc2217_server_t(programmer_t &p) : programmer(p), listener(-1), port(0), state(DATA), dtr(false)
+    {
+	wake_fds[0] = wake_fds[1] = -1;
+    }
+
+    rfc2217_server_t::~rfc2217_server_t()
+    {
+	stop();
+    }
+
+    bool rfc2217_server_t::listen()
+    {
+	listener = socket(AF_INET, SOCK_STREAM, 0);
+	if( listener < 0 )
+	    return false;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;	// Any free port
+	socklen_t length = sizeof(address);
+	if( (bind(listener, (sockaddr*)&address, sizeof(address)) < 0)
+	    || (getsockname(listener, (sockaddr*)&address, &length) < 0)
+	    || (::listen(listener, 1) < 0)
+	    || (pipe(wake_fds) < 0) )
+	{
+	    stop();
+	    return false;
+	}
+	port = ntohs(address.sin_port);
+	start();
+	return true;
+    }
+
+    void rfc2217_server_t::stop()
+    {
+	if( isRunning() )
+	{
+	    const char c = 0;
+	    if( ::write(wake_fds[1], &c, 1) == 1 )
+		wait();
+	}
+	if( listener >= 0 )
+	    ::close(listener);
+	for(unsigned i=0; i < 2; ++i)
+	    if( wake_fds[i] >= 0 )
+		::close(wake_fds[i]);
+	listener = wake_fds[0] = wake_fds[1] = -1;
+    }
+
+    QString rfc2217_server_t::name() const
+    {
+	return QString(RFC2217_PREFIX "127.0.0.1:%1").arg(port);
+    }
+
+    void rfc2217_server_t::run()
+    {
+	for(;;)
+	{
+	    pollfd  fds[2] = {{wake_fds[0], POLLIN, 0}, {listener, POLLIN, 0}};
+	    if( poll(fds, 2, -1) < 0 )
+	    {
+		if( errno == EINTR )
+		    continue;
+		return;
+	    }
+	    if( fds[0].revents )
+		return;
+	    if( fds[1].revents & POLLIN )
+	    {
+		const int client = accept(listener, NULL, NULL);
+		if( client < 0 )
+		    continue;
+		const bool stopped = !serve(client);
+		::close(client);
+		if( stopped )
+		    return;
+	    }
+	}
+    }
+
+    // Pass data between a client and the programmer until one of them goes
+    //	away. Returns false if it was stop() that ended it.
+    bool rfc2217_server_t::serve(int client)
+    {
+	state = DATA;
+	dtr = false;
+	char	buffer[512];
+	for(;;)
+	{
+	    pollfd  fds[2] = {{wake_fds[0], POLLIN, 0}, {client, POLLIN, 0}};
+	    if( poll(fds, 2, -1) < 0 )
+	    {
+		if( errno == EINTR )
+		    continue;
+		return true;
+	    }
+	    if( fds[0].revents )
+		return false;
+
+	    const ssize_t n = ::read(client, buffer, sizeof(buffer));
+	    if( n <= 0 )
+		return true;
+	    QByteArray	data;
+	    filter(buffer, n, data);
+	    programmer.receive(data.constData(), data.size());
+
+	    // Replies go out with any IAC doubled
+	    const QByteArray reply = programmer.take();
+	    QByteArray	escaped;
+	    for(int i=0; i < reply.size(); ++i)
+	    {
+		escaped.append(reply[i]);
+		if( (uint8_t)reply[i] == TELNET_IAC )
+		    escaped.append(reply[i]);
+	    }
+	    for(int sent=0; sent < escaped.size();)
+	    {
+		const ssize_t w = ::write(client, escaped.constData() + sent, escaped.size() - sent);
+		if( w <= 0 )
+		    return true;
+		sent += w;
+	    }
+	}
+    }
+
+    // Separate the data from the telnet commands. Negotiations aren't
+    //	answered, the client doesn't wait for them.
+    void rfc2217_server_t::filter(const char *bytes, size_t length, QByteArray &data)
+    {
+	for(size_t i=0; i < length; ++i)
+	{
+	    const uint8_t c = bytes[i];
+	    switch( state )
+	    {
+		case DATA:
+		    if( c == TELNET_IAC )
+			state = GOT_IAC;
+		    else
+			data.append((char)c);
+		    break;
+		case GOT_IAC:
+		    if( c == TELNET_IAC )
+		    {
+			data.append((char)c);
+			state = DATA;
+		    }
+		    else if( (c >= TELNET_WILL) && (c <= TELNET_DONT) )
+			state = GOT_VERB;
+		    else if( c == TELNET_SB )
+		    {
+			sb.clear();
+			state = IN_SB;
+		    }
+		    else
+			state = DATA;
+		    break;
+		case GOT_VERB:
+		    state = DATA;
+		    break;
+		case IN_SB:
+		    if( c == TELNET_IAC )
+			state = SB_IAC;
+		    else
+			sb.append((char)c);
+		    break;
+		case SB_IAC:
+		    if( c == TELNET_SE )
+		    {
+			subnegotiation();
+			state = DATA;
+		    }
+		    else
+		    {
+			sb.append((char)c);	// An escaped IAC
+			state = IN_SB;
+		    }
+		    break;
+	    }
+	}
+    }
+
+    // Only SET-CONTROL's DTR settings matter to the programmer
+    void rfc2217_server_t::subnegotiation()
+    {
+	if( (sb.size() != 3) || ((uint8_t)sb[0] != TELOPT_COM_PORT) || (sb[1] != COM_SET_CONTROL) )
+	    return;
+	if( sb[2] == COM_CONTROL_DTR_ON )
+	    dtr = true;
+	else if( sb[2] == COM_CONTROL_DTR_OFF )
+	{
+	    if( dtr )
+		programmer.reset();
+	    dtr = false;
+	}
+    }
+
+    pty_t::pty_t(programmer_t &p) : programmer(p), master(-1), slave(-1)
+    {
+	wake_fds[0] = wake_fds[1] = -1;
+    }
+
+    pty_t::~pty_t()
+    {
+	stop();
+    }
+
+    bool pty_t::open()
+    {
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if( (master < 0) || (grantpt(master) < 0) || (unlockpt(master) < 0) || !ptsname(master) )
+	{
+	    stop();
+	    return false;
+	}
+	slave_name = ptsname(master);
+
+	// No echo, and no line editing, until a client sets it up for itself
+	slave = ::open(ptsname(master), O_RDWR | O_NOCTTY);
+	termios	settings;
+	if( (slave < 0) || (tcgetattr(slave, &settings) < 0) || (pipe(wake_fds) < 0) )
+	{
+	    stop();
+	    return false;
+	}
+	cfmakeraw(&settings);
+	tcsetattr(slave, TCSANOW, &settings);
+	start();
+	return true;
+    }
+
+    void pty_t::stop()
+    {
+	if( isRunning() )
+	{
+	    const char c = 0;
+	    if( ::write(wake_fds[1], &c, 1) == 1 )
+		wait();
+	}
+	if( master >= 0 )
+	    ::close(master);
+	if( slave >= 0 )
+	    ::close(slave);
+	for(unsigned i=0; i < 2; ++i)
+	    if( wake_fds[i] >= 0 )
+		::close(wake_fds[i]);
+	master = slave = wake_fds[0] = wake_fds[1] = -1;
+    }
+
+    void pty_t::run()
+    {
+	char	buffer[512];
+	for(;;)
+	{
+	    pollfd  fds[2] = {{wake_fds[0], POLLIN, 0}, {master, POLLIN, 0}};
+	    if( poll(fds, 2, -1) < 0 )
+	    {
+		if( errno == EINTR )
+		    continue;
+		return;
+	    }
+	    if( fds[0].revents )
+		return;
+
+	    const ssize_t n = ::read(master, buffer, sizeof(buffer));
+	    if( n <= 0 )
+		return;
+	    programmer.receive(buffer, n);
+
+	    const QByteArray reply = programmer.take();
+	    for(int sent=0; sent < reply.size();)
+	    {
+		const ssize_t w = ::write(master, reply.constData() + sent, reply.size() - sent);
+		if( w <= 0 )
+		    return;
+		sent += w;
+	    }
+	}
+    }
+}
@@ -0,0 +1,132 @@
+/*  A Kitsrus programmer in software, for testing without hardware
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	EMULATOR_H
+#define	EMULATOR_H
+
+#include <vector>
+
+#include <stdint.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QThread>
+
+namespace emulator
+{
+    // The programmer's side of the Kitsrus protocol (P018), with a 14-bit
+    //	part in the socket. Bytes from the host go to receive(), and the
+    //	replies pile up for take(). Programming takes no time, and the part
+    //	never leaves the socket.
+    //
+    //	ROM and config are flash: writes can only clear bits, and only an
+    //	erase sets them again. Words are 14 bits, so the high two bits of
+    //	each one always read back as zero. CMD_INITVAR doesn't resize the
+    //	part, it only says how much of it the host is going to read.
+    class programmer_t
+    {
+    public:
+	programmer_t(uint8_t firmware, uint16_t chip_id, unsigned rom_words, unsigned eeprom_bytes);
+
+	void	reset();	// DTR was pulsed
+	void	receive(const char *, size_t);
+	QByteArray  take();
+
+	// The part, laid out the way the programmer sends it
+	std::vector<uint8_t>	rom;
+	std::vector<uint8_t>	eeprom;
+	std::vector<uint8_t>	id;	// 4 bytes
+	std::vector<uint8_t>	config;	// 7 words
+	unsigned    resets;
+	unsigned    erases;
+	unsigned    blocks;	// ROM blocks and EEPROM pairs written, each one a round trip
+
+    private:
+	// What the next byte from the host is
+	enum phase_t { POWER_ON, COMMAND, ARGUMENTS, ROM_BLOCK, EEPROM_PAIR };
+
+	uint8_t	firmware;
+	uint16_t    chip_id;
+	phase_t	phase;
+	uint8_t	command;
+	std::vector<uint8_t>	args;
+	unsigned    expected;	// Bytes of args still to come
+	unsigned    offset;	// Where the next block of a write goes
+	unsigned    size;	// Bytes in the write the host asked for
+	unsigned    read_rom;	// Bytes of each memory that CMD_INITVAR asked for
+	unsigned    read_eeprom;
+	QByteArray  output;
+
+	void	reply(uint8_t c)    { output.append((char)c);	}
+	void	start(uint8_t);
+	void	run();
+	void	block();
+	void	erase();
+	void	program(std::vector<uint8_t> &, unsigned offset, uint8_t);
+    };
+
+    // Serves a programmer to one RFC 2217 client at a time, on a TCP port on
+    //	the loopback interface, from a thread of its own. DTR going off after
+    //	it was on resets the programmer. Only look at the programmer after
+    //	stop(), or before listen().
+    class rfc2217_server_t : public QThread
+    {
+    public:
+	rfc2217_server_t(programmer_t &);
+	~rfc2217_server_t();
+
+	bool	listen();	// Picks a free port, and starts the thread
+	void	stop();		// Drops the client, and waits for the thread
+	QString	name() const;	// Something transport::create() takes
+
+    protected:
+	virtual void run();
+
+    private:
+	// Where the telnet parser is
+	enum state_t { DATA, GOT_IAC, GOT_VERB, IN_SB, SB_IAC };
+
+	programmer_t	&programmer;
+	int	listener;
+	int	wake_fds[2];	// A byte on the pipe stops the thread
+	uint16_t    port;
+	state_t	state;
+	QByteArray  sb;		// The subnegotiation being received
+	bool	dtr;
+
+	bool	serve(int client);
+	void	filter(const char *, size_t, QByteArray &data);
+	void	subnegotiation();
+    };
+
+    // Serves a programmer on a pseudo-terminal, from a thread of its own, so
+    //	that it can be opened like a serial port. There's no DTR, so the
+    //	programmer is never reset, but 'P' and CMD_RESET still work. Only
+    //	look at the programmer after stop(), or before open().
+    class pty_t : public QThread
+    {
+    public:
+	pty_t(programmer_t &);
+	~pty_t();
+
+	bool	open();		// Makes the pseudo-terminal, and starts the thread
+	void	stop();
+	const QString&	name() const { return slave_name;	}   // The serial port to open
+
+    protected:
+	virtual void run();
+
+    private:
+	programmer_t	&programmer;
+	int	master;
+	int	slave;		// Held open so that the master doesn't hang up between clients
+	int	wake_fds[2];	// A byte on the pipe stops the thread
+	QString	slave_name;
+    };
+}
+
+#endif	// EMULATOR_H
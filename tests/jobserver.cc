@@ -0,0 +1,98 @@
+/*  Programming a part by way of the job server
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <unistd.h>
+
+#include <QCoreApplication>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QTime>
+
+#include "binimage.h"
+#include "jobserver.h"
+#include "kitsrus.h"
+#include "tests.h"
+
+// Milliseconds
+#define	CONNECT_TIMEOUT	5000
+#define	JOB_TIMEOUT	60000
+
+// The server runs on this thread, so keep its events going while waiting for a reply
+static bool read_line(QLocalSocket &client, QByteArray &line, int timeout)
+{
+    QTime   timer;
+    timer.start();
+    while( !client.canReadLine() )
+    {
+	if( (timer.elapsed() > timeout) || (client.state() != QLocalSocket::ConnectedState) )
+	    return false;
+	QCoreApplication::processEvents();
+	kitsrus::msleep(1);
+    }
+    line = client.readLine().trimmed();
+    return true;
+}
+
+namespace tests
+{
+    // Submit a program and verify job for an emulated programmer on an
+    //	RFC 2217 bridge, and wait for it to finish
+    bool jobserver()
+    {
+	const char *const test = "jobserver";
+
+	emulator::programmer_t	programmer(emulated());
+	emulator::rfc2217_server_t  bridge(programmer);
+	if( !bridge.listen() )
+	    return fail(test, "The emulator couldn't listen");
+
+	const chipimage::chipimage_t image = pattern();
+	const QString file = scratch() + "/jobserver.qbi";
+	if( !binimage::save(file, image, part()) )
+	    return fail(test, "Couldn't save the image");
+
+	JobQueue    queue(QStringList() << bridge.name());
+	JobServer   server(queue);
+	const QString name = QString("qprog-test-%1").arg(getpid());
+	if( !server.listen(name) )
+	    return fail(test, server.errorString());
+
+	QLocalSocket	client;
+	client.connectToServer(name);
+	QTime	timer;
+	timer.start();
+	while( (client.state() != QLocalSocket::ConnectedState) && (timer.elapsed() < CONNECT_TIMEOUT) )
+	    QCoreApplication::processEvents();
+
+	client.write("submit target=" + QByteArray(part().name.c_str()) + " file=" + file.toUtf8().toPercentEncoding() + " erase=1 verify=1\n");
+	QByteArray  line;
+	if( !read_line(client, line, CONNECT_TIMEOUT) )
+	    return fail(test, "No reply to submit");
+	if( !line.startsWith("ok id=") )
+	    return fail(test, QString("Submit failed: %1").arg(QString(line)));
+	const QByteArray event = "event " + line.mid(3) + " state=";
+
+	// Wait for the job to finish. Progress and the other events go by.
+	do
+	{
+	    if( !read_line(client, line, JOB_TIMEOUT) )
+		return fail(test, "The job didn't finish");
+	} while( !line.startsWith(event) || line.startsWith(event + "running") || line.startsWith(event + "queued") );
+	client.disconnectFromServer();
+
+	if( !line.startsWith(event + "done") )
+	    return fail(test, QString("The job didn't succeed: %1").arg(QString(line)));
+
+	bridge.stop();
+	QString why;
+	if( !holds(programmer, image, why) )
+	    return fail(test, why);
+	if( programmer.erases != 1 )
+	    return fail(test, QString("The part was erased %1 times").arg(programmer.erases));
+	return true;
+    }
+}
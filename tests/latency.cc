@@ -0,0 +1,57 @@
+/*  Command to reply times with and without an I/O thread
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <iostream>
+
+#include "iothread.h"
+#include "kitsrus.h"
+#include "tests.h"
+
+#define	ROUND_TRIPS	500	// Each one is a command_mode() and a soft_reset()
+
+// Time ROUND_TRIPS commands, with the port opened the way io_options says
+static bool measure(const QString &port, const char *label)
+{
+    const char *const test = "latency";
+
+    kitsrus::kitsrus_t	prog(transport::create(port), tests::part());
+    if( !prog.open() )
+	return tests::fail(test, QString("Couldn't open %1").arg(port));
+    for(unsigned i=0; i < ROUND_TRIPS; ++i)
+	if( !prog.command_mode() || !prog.soft_reset() )
+	    return tests::fail(test, QString("%1: no reply to command %2").arg(label).arg(i));
+
+    const transport::latency_t *const latency = prog.latency();
+    if( !latency || (latency->count != 2*ROUND_TRIPS) )
+	return tests::fail(test, QString("%1: %2 round trips were timed").arg(label).arg(latency ? latency->count : 0));
+    std::cout << "\t" << label << ": " << latency->count << " round trips, ";
+    std::cout << "mean " << latency->mean() << " us, min " << latency->min << " us, ";
+    std::cout << "max " << latency->max << " us, jitter " << latency->jitter() << " us\n";
+    return true;
+}
+
+namespace tests
+{
+    // The same commands to an emulated programmer on a pseudo-terminal,
+    //	through serial_t directly and then through threaded_t, so that the
+    //	I/O thread's numbers have a baseline
+    bool latency()
+    {
+	emulator::programmer_t	programmer(emulated());
+	emulator::pty_t	pty(programmer);
+	if( !pty.open() )
+	    return fail("latency", "Couldn't make a pseudo-terminal");
+
+	const transport::io_options_t	saved = transport::io_options;
+	transport::io_options.enabled = false;
+	bool passed = measure(pty.name(), "direct");
+	transport::io_options.enabled = true;
+	passed = passed && measure(pty.name(), "I/O thread");
+	transport::io_options = saved;
+	return passed;
+    }
+}
@@ -0,0 +1,190 @@
+/*  Tests that drive QProg against an emulated programmer
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <iostream>
+
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+
+#include "devicedatabase.h"
+#include "kitsrus.h"
+#include "tests.h"
+
+DeviceDatabase deviceDatabase;
+
+// A 16F628A, more or less
+static const char part_export[] =
+    "DeviceInfo/Devices/1/Name=TEST16F628A\n"
+    "DeviceInfo/Devices/1/ChipID=1060\n"
+    "DeviceInfo/Devices/1/CreateTimeStamp=2026-10-19 00:00:00\n"
+    "DeviceInfo/Devices/1/BandGap=N\n"
+    "DeviceInfo/Devices/1/CALword=N\n"
+    "DeviceInfo/Devices/1/CoreType=bit14_B\n"
+    "DeviceInfo/Devices/1/EraseMode=1\n"
+    "DeviceInfo/Devices/1/FUSEblank=3FFF\n"
+    "DeviceInfo/Devices/1/FastPowerSequence=0\n"
+    "DeviceInfo/Devices/1/NumConfigWords=1\n"
+    "DeviceInfo/Devices/1/NumEEPROMBytes=128\n"
+    "DeviceInfo/Devices/1/NumROMWords=2048\n"
+    "DeviceInfo/Devices/1/OverProgram=0\n"
+    "DeviceInfo/Devices/1/PowerSequence=VccVpp1\n"
+    "DeviceInfo/Devices/1/ProgramDelay=10\n"
+    "DeviceInfo/Devices/1/ProgramTries=1\n"
+    "DeviceInfo/Devices/size=1\n";
+
+namespace tests
+{
+    bool fail(const char *test, const QString &why)
+    {
+	std::cerr << "FAIL " << test << ": " << qPrintable(why) << "\n";
+	return false;
+    }
+
+    const chipinfo::chipinfo& part()
+    {
+	return deviceDatabase[0];
+    }
+
+    emulator::programmer_t emulated()
+    {
+	return emulator::programmer_t(KIT_150, part().chip_id, part().rom_size, part().eeprom_size);
+    }
+
+    chipimage::chipimage_t pattern()
+    {
+	chipimage::chipimage_t	image;
+	image.clear(part());
+	for(unsigned i=0; i < image.size(chipimage::ROM); i += 2)   // 14-bit words
+	{
+	    image.set(chipimage::ROM, i, i*7);
+	    image.set(chipimage::ROM, i+1, (i >> 4) & 0x3F);
+	}
+	for(unsigned i=0; i < image.size(chipimage::EEPROM); ++i)
+	    image.set(chipimage::EEPROM, i, i ^ 0x5A);
+	image.set(chipimage::CONFIG, 0, 0x21);
+	image.set(chipimage::CONFIG, 1, 0x3F);
+	return image;
+    }
+
+    static bool same(const char *region, const std::vector<uint8_t> &memory, const chipimage::chipimage_t &image, chipimage::region_t r, QString &why)
+    {
+	for(unsigned i=0; (i < memory.size()) && (i < image.size(r)); ++i)
+	{
+	    if( memory[i] != image.get(r, i) )
+	    {
+		why = QString("%1 byte %2 is %3, not %4").arg(region).arg(i).arg(memory[i], 2, 16).arg(image.get(r, i), 2, 16);
+		return false;
+	    }
+	}
+	return true;
+    }
+
+    bool holds(const emulator::programmer_t &p, const chipimage::chipimage_t &image, QString &why)
+    {
+	return same("ROM", p.rom, image, chipimage::ROM, why)
+	    && same("EEPROM", p.eeprom, image, chipimage::EEPROM, why)
+	    && same("Config", p.config, image, chipimage::CONFIG, why);
+    }
+
+    QString scratch()
+    {
+	return QDir::tempPath() + "/qprog-tests";
+    }
+}
+
+static const struct
+{
+    const char *name;
+    bool    (*run)();
+    const char *description;
+} tests_table[] =
+{
+    {"jobserver", tests::jobserver, "Program and verify a part through the job server, over RFC 2217"},
+    {"rfc2217", tests::rfc2217, "Program and verify over RFC 2217, and refuse bad bridge names"},
+    {"latency", tests::latency, "Time commands on a pseudo-terminal, with and without an I/O thread"},
+    {"differential", tests::differential, "Rewrite a changed image without erasing the part"},
+};
+static const unsigned num_tests = sizeof(tests_table)/sizeof(tests_table[0]);
+
+// Put the test part in the database, with everything kept in a scratch directory
+static bool setup()
+{
+    QDir().mkpath(tests::scratch());
+    QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope, tests::scratch());
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, tests::scratch());
+    QCoreApplication::setOrganizationName("QProgTests");
+    QCoreApplication::setApplicationName("QProgTests");
+
+    DeviceInfoParser	parser;
+    DeviceDatabase::counts_type	counts;
+    QString error;
+    if( !parser.feed(part_export, strlen(part_export)) || !parser.finish() )
+	return tests::fail("setup", parser.error());
+    if( !deviceDatabase.apply(parser, counts, &error) )
+	return tests::fail("setup", error);
+    return true;
+}
+
+static void cleanup()
+{
+    QFile::remove(DeviceDatabase::snapshotPath());
+    QDir	dir(tests::scratch());
+    const QStringList files = dir.entryList(QDir::Files);
+    for(QStringList::const_iterator i = files.begin(); i != files.end(); ++i)
+	dir.remove(*i);
+    QDir().rmdir(tests::scratch() + "/QProgTests");
+    QDir().rmdir(tests::scratch());
+}
+
+// With no arguments every test is run, otherwise just the ones named
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    signal(SIGPIPE, SIG_IGN);	// The emulator's clients hang up on it
+
+    for(int i=1; i < argc; ++i)
+    {
+	unsigned j = 0;
+	while( (j < num_tests) && strcmp(argv[i], tests_table[j].name) )
+	    ++j;
+	if( j == num_tests )
+	{
+	    std::cerr << "Usage: " << argv[0] << " [test...]\n";
+	    for(unsigned k=0; k < num_tests; ++k)
+		std::cerr << "\t" << tests_table[k].name << "\t" << tests_table[k].description << "\n";
+	    return 1;
+	}
+    }
+
+    if( !setup() )
+    {
+	cleanup();
+	return 1;
+    }
+
+    unsigned failed = 0;
+    for(unsigned j=0; j < num_tests; ++j)
+    {
+	bool named = (argc < 2);
+	for(int i=1; i < argc; ++i)
+	    named |= !strcmp(argv[i], tests_table[j].name);
+	if( !named )
+	    continue;
+	const bool passed = tests_table[j].run();
+	std::cout << (passed ? "PASS " : "FAIL ") << tests_table[j].name << "\n";
+	failed += passed ? 0 : 1;
+    }
+
+    cleanup();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+/*  Programming a part over an RFC 2217 bridge
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#include <iostream>
+
+#include <QTime>
+
+#include "session.h"
+#include "tests.h"
+#include "transport.h"
+
+namespace tests
+{
+    // Write and verify a part through an emulated bridge on the loopback
+    //	interface, and report what each block's round trip cost. Bridge
+    //	names without a usable host:port have to be refused.
+    bool rfc2217()
+    {
+	const char *const test = "rfc2217";
+
+	static const char *const bad_names[] =
+	{
+	    RFC2217_PREFIX "localhost",
+	    RFC2217_PREFIX "localhost:",
+	    RFC2217_PREFIX ":2217",
+	    RFC2217_PREFIX "localhost:0",
+	    RFC2217_PREFIX "localhost:telnet",
+	    RFC2217_PREFIX "localhost:65536",
+	};
+	for(unsigned i=0; i < sizeof(bad_names)/sizeof(bad_names[0]); ++i)
+	{
+	    transport::transport_t *const t = transport::create(bad_names[i]);
+	    if( t )
+	    {
+		delete t;
+		return fail(test, QString("Took %1 as a port name").arg(bad_names[i]));
+	    }
+	    session::session_t	s(bad_names[i], part());
+	    if( s.open() || !s.error().startsWith("Bad port name") )
+		return fail(test, QString("Opening %1 said \"%2\"").arg(bad_names[i]).arg(s.error()));
+	}
+
+	emulator::programmer_t	programmer(emulated());
+	emulator::rfc2217_server_t  bridge(programmer);
+	if( !bridge.listen() )
+	    return fail(test, "The emulator couldn't listen");
+
+	const chipimage::chipimage_t image = pattern();
+	{
+	    session::session_t	s(bridge.name(), part());
+	    if( !s.open() )
+		return fail(test, s.error());
+
+	    QTime   timer;
+	    timer.start();
+	    if( !s.write(image, NULL, true) )
+		return fail(test, s.error());
+	    const int elapsed = timer.elapsed();
+	    std::cout << "\t" << programmer.blocks << " blocks written in " << elapsed << " ms, ";
+	    std::cout << (programmer.blocks ? 1000.0*elapsed/programmer.blocks : 0) << " us each\n";
+
+	    chipimage::chipimage_t  readback;
+	    imagediff::changes_t    changes;
+	    if( !s.verify(image, readback, changes) )
+		return fail(test, s.error());
+	    if( !changes.empty() )
+		return fail(test, QString("%1 blocks didn't verify").arg((int)changes.size()));
+	}
+
+	bridge.stop();
+	QString why;
+	if( !holds(programmer, image, why) )
+	    return fail(test, why);
+	return true;
+    }
+}
@@ -0,0 +1,40 @@
+/*  Shared bits of the test program
+
+    Created October 19, 2026
+
+    Copyright 2026 Brandon Fosdick (BSD License)
+*/
+
+#ifndef	TESTS_H
+#define	TESTS_H
+
+#include <QString>
+
+#include "chipimage.h"
+#include "chipinfo.h"
+#include "emulator.h"
+
+namespace tests
+{
+    // Print why a test failed, and return false
+    bool    fail(const char *test, const QString &why);
+
+    // The part that every test programs. main() puts it in deviceDatabase.
+    const chipinfo::chipinfo&	part();
+    // A programmer with an erased part() in its socket
+    emulator::programmer_t  emulated();
+    // An image of part() with something in every region
+    chipimage::chipimage_t  pattern();
+    // Does the part in the programmer hold image? If not, why says where it differs.
+    bool    holds(const emulator::programmer_t &, const chipimage::chipimage_t &image, QString &why);
+    // A directory for temporary files, removed when the tests finish
+    QString scratch();
+
+    // The tests. Each one returns true if it passed.
+    bool    jobserver();
+    bool    rfc2217();
+    bool    latency();
+    bool    differential();
+}
+
+#endif	// TESTS_H
@@ -0,0 +1,43 @@
+######################################################################
+# Tests that run QProg against an emulated programmer
+#  qmake && make, then run ./tests, or ./tests with the names of tests
+######################################################################
+
+TEMPLATE = app
+TARGET = tests
+CONFIG	+= console warn_on qt stl
+CONFIG	-= app_bundle
+QT	-= gui
+QT	+= network
+INCLUDEPATH += ../include ../src
+DEPENDPATH += ../src
+
+HEADERS	+= tests.h emulator.h
+SOURCES	+= main.cc emulator.cc
+SOURCES	+= jobserver.cc
+SOURCES	+= rfc2217.cc
+SOURCES	+= latency.cc
+SOURCES	+= differential.cc
+
+HEADERS	+= kitsrus.h transport.h ring.h iothread.h session.h chipdetect.h
+SOURCES	+= kitsrus.cc transport.cc iothread.cc session.cc chipdetect.cc
+HEADERS	+= jobqueue.h jobserver.h scheduler.h
+SOURCES	+= jobqueue.cc jobserver.cc scheduler.cc
+HEADERS	+= chipinfo.h coretraits.h chipimage.h imagediff.h hexwriter.h binimage.h devicedatabase.h
+SOURCES	+= chipinfo.cc chipimage.cc imagediff.cc hexwriter.cc binimage.cc devicedatabase.cc
+
+# libintelhex
+DEPENDPATH += ../lib/intelhex/include ../lib/intelhex/src
+INCLUDEPATH += ../lib/intelhex/include
+HEADERS += intelhex.h
+SOURCES += intelhex.cc
+
+# qextserialport stuff
+DEPENDPATH += ../qextserialport
+INCLUDEPATH += ../qextserialport
+HEADERS	+= qextserialbase.h qextserialport.h
+SOURCES	+= qextserialbase.cpp qextserialport.cpp
+
+unix:HEADERS	+= posix_qextserialport.h
+unix:SOURCES	+= posix_qextserialport.cpp
+unix:DEFINES	+= _TTY_POSIX_